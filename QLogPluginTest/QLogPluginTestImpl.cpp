@@ -2,6 +2,11 @@
 
 #include <QDebug>
 
+#include "AutoRegistered.h"
+
+// 注册工厂，供跨模块查找与其他上下文另建实例
+AUTO_REGISTER(QLogPluginTestImpl, PluginInterface)
+
 QLogPluginTestImpl::~QLogPluginTestImpl()
 {
     qInfo() << "QLogPluginTestImpl::~QLogPluginTestImpl()";
@@ -1,7 +1,35 @@
 ﻿#include "AutoRegistered.h"
 
+#include <algorithm>
+#include <iterator>
 #include <mutex>
 
+namespace {
+/**
+ * @brief 线程内待提交的注册项，保持注册顺序
+ */
+struct PendingBatch {
+    int depth = 0;
+    std::vector<std::pair<std::string, RawEntry>> entries;
+    /**
+     * @brief 最外层批次开始以来的全部注册，{BaseKey，键指针}，供 revertBatch 撤销
+     */
+    std::vector<std::pair<std::string, const char*>> added;
+};
+
+thread_local PendingBatch t_batch;
+
+/**
+ * @brief 注册表版本变更计数，名称随基类变化，只在写侧持锁时调用，不走调用点缓存
+ */
+void countVersion(std::string_view baseKey)
+{
+    if (PluginMetrics::enabled()) {
+        PluginMetrics::Instance().counter("registry.version", baseKey).add();
+    }
+}
+}
+
 RegistryHub::RegistryHub() { }
 RegistryHub::~RegistryHub() { }
 
@@ -13,6 +41,11 @@ RegistryHub& RegistryHub::Instance()
 
 void RegistryHub::add(std::string_view baseKey, const char* type_key, std::any creator)
 {
+    if (t_batch.depth > 0) {
+        t_batch.entries.emplace_back(std::string(baseKey), RawEntry { type_key, std::move(creator) });
+        t_batch.added.emplace_back(std::string(baseKey), type_key);
+        return;
+    }
     std::unique_lock lock(_mtx);
     auto& bucket = ensure_bucket_unlocked(baseKey);
 
@@ -22,10 +55,12 @@ void RegistryHub::add(std::string_view baseKey, const char* type_key, std::any c
 
     bucket.items = newVec;
     bucket.ver.fetch_add(1, std::memory_order_release);
+    countVersion(baseKey);
 }
 
 std::shared_ptr<const std::vector<RawEntry>> RegistryHub::snapshot(std::string_view baseKey) const
 {
+    flush_pending();
     std::shared_lock lock(_mtx);
     auto it = _map.find(std::string(baseKey)); // 注意：map key 是 string
     if (it == _map.end()) {
@@ -37,6 +72,7 @@ std::shared_ptr<const std::vector<RawEntry>> RegistryHub::snapshot(std::string_v
 
 std::size_t RegistryHub::version(std::string_view baseKey) const
 {
+    flush_pending();
     std::shared_lock lock(_mtx);
     auto it = _map.find(std::string(baseKey));
     if (it == _map.end())
@@ -44,6 +80,121 @@ std::size_t RegistryHub::version(std::string_view baseKey) const
     return it->second.ver.load(std::memory_order_acquire);
 }
 
+std::size_t RegistryHub::generation(std::string_view baseKey) const
+{
+    flush_pending();
+    std::shared_lock lock(_mtx);
+    auto it = _map.find(std::string(baseKey));
+    if (it == _map.end())
+        return 0;
+    return it->second.gen.load(std::memory_order_acquire);
+}
+
+RegistryHub::View RegistryHub::view(std::string_view baseKey) const
+{
+    flush_pending();
+    std::shared_lock lock(_mtx);
+    auto it = _map.find(std::string(baseKey));
+    if (it == _map.end()) {
+        static auto empty = std::make_shared<const std::vector<RawEntry>>();
+        return View { 0, 0, empty };
+    }
+    return View { it->second.ver.load(std::memory_order_relaxed), it->second.gen.load(std::memory_order_relaxed), it->second.items };
+}
+
+std::size_t RegistryHub::remove(std::string_view baseKey, std::string_view type_key)
+{
+    return erase(baseKey, [type_key](const RawEntry& e) { return type_key == e.type_key; });
+}
+
+std::size_t RegistryHub::revertBatch()
+{
+    // 未提交的直接丢弃，已提交的按键指针逐项移除
+    t_batch.entries.clear();
+    const auto added = std::move(t_batch.added);
+    t_batch.added.clear();
+    std::size_t removed = 0;
+    for (auto&& [baseKey, type_key] : added) {
+        removed += erase(baseKey, [ptr = type_key](const RawEntry& e) { return e.type_key == ptr; });
+    }
+    return removed;
+}
+
+std::size_t RegistryHub::erase(std::string_view baseKey, const std::function<bool(const RawEntry&)>& match)
+{
+    flush_pending();
+    std::unique_lock lock(_mtx);
+    auto it = _map.find(std::string(baseKey));
+    if (it == _map.end()) {
+        return 0;
+    }
+    auto& bucket = it->second;
+    auto newVec = std::make_shared<std::vector<RawEntry>>();
+    newVec->reserve(bucket.items->size());
+    std::copy_if(bucket.items->begin(), bucket.items->end(), std::back_inserter(*newVec),
+        [&match](const RawEntry& e) { return !match(e); });
+    const auto removed = bucket.items->size() - newVec->size();
+    if (removed == 0) {
+        return 0;
+    }
+    // 先递增代号再递增版本号，读侧看到新版本时必然看到新代号
+    bucket.items = newVec;
+    bucket.gen.fetch_add(1, std::memory_order_release);
+    bucket.ver.fetch_add(1, std::memory_order_release);
+    countVersion(baseKey);
+    return removed;
+}
+
+void RegistryHub::beginBatch()
+{
+    ++t_batch.depth;
+}
+
+void RegistryHub::commitBatch()
+{
+    if (t_batch.depth == 0) {
+        return;
+    }
+    if (--t_batch.depth == 0) {
+        flush_pending();
+        t_batch.added.clear();
+    }
+}
+
+void RegistryHub::flush_pending() const
+{
+    if (t_batch.entries.empty()) {
+        return;
+    }
+    auto pending = std::move(t_batch.entries);
+    t_batch.entries.clear();
+
+    // 按 BaseKey 分组，组内保持注册顺序
+    std::vector<std::pair<std::string_view, std::vector<RawEntry>>> groups;
+    for (auto& [key, entry] : pending) {
+        auto it = std::find_if(groups.begin(), groups.end(), [&](const auto& g) { return g.first == key; });
+        if (it == groups.end()) {
+            groups.emplace_back(key, std::vector<RawEntry> {});
+            it = std::prev(groups.end());
+        }
+        it->second.push_back(std::move(entry));
+    }
+
+    auto self = const_cast<RegistryHub*>(this);
+    std::unique_lock lock(_mtx);
+    for (auto& [key, entries] : groups) {
+        auto& bucket = self->ensure_bucket_unlocked(key);
+        auto newVec = std::make_shared<std::vector<RawEntry>>();
+        newVec->reserve(bucket.items->size() + entries.size());
+        newVec->insert(newVec->end(), bucket.items->begin(), bucket.items->end());
+        std::move(entries.begin(), entries.end(), std::back_inserter(*newVec));
+
+        bucket.items = newVec;
+        bucket.ver.fetch_add(1, std::memory_order_release);
+        countVersion(key);
+    }
+}
+
 RegistryHub::Bucket& RegistryHub::ensure_bucket_unlocked(std::string_view baseKey)
 {
     // 假设调用者已经持有写锁
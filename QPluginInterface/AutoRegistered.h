@@ -15,9 +15,11 @@
 #include <any>
 #include <atomic>
 #include <concepts>
+#include <cstddef>
 #include <functional>
 #include <limits>
 #include <memory>
+#include <new>
 #include <shared_mutex>
 #include <string>
 #include <string_view>
@@ -27,17 +29,32 @@
 #include <utility>
 #include <vector>
 
+#include "QPluginMetrics.h"
+
 /**
  * @brief std::any 存储创建器，创建器的签名(参数)是不确定的
  */
 struct RawEntry {
     const char* type_key;
     /**
-     * @brief 存储 std::function<Base*(Args...)>
+     * @brief 存储 StaticRegistry<Base, Args...>::Creator
      */
     std::any creator;
 };
 
+/**
+ * @brief 把调用方实参绑定到形参 Args&&：引用形参或同类型右值直接转发，其余就地构造一个临时量
+ */
+template <typename A, typename U>
+inline decltype(auto) RegistryBindArg(U&& u)
+{
+    if constexpr (std::is_reference_v<A> || (std::is_same_v<std::remove_cvref_t<U>, A> && !std::is_lvalue_reference_v<U>)) {
+        return static_cast<U&&>(u);
+    } else {
+        return A(std::forward<U>(u));
+    }
+}
+
 class QPLUGININTERFACE_EXPORT RegistryHub {
 private:
     RegistryHub();
@@ -69,6 +86,54 @@ public:
      */
     std::size_t version(std::string_view baseKey) const;
 
+    /**
+     * @brief 代号（每次 remove 递增）；代号不变时快照只在末尾追加，缓存可增量刷新
+     * @param baseKey
+     * @return
+     */
+    std::size_t generation(std::string_view baseKey) const;
+
+    /**
+     * @brief 同一次加锁读取的版本号、代号与快照
+     */
+    struct View {
+        std::size_t version = 0;
+        std::size_t generation = 0;
+        std::shared_ptr<const std::vector<RawEntry>> items;
+    };
+
+    /**
+     * @brief 一致地读取版本号、代号与快照，三者不会跨越一次写入
+     * @param baseKey
+     * @return
+     */
+    View view(std::string_view baseKey) const;
+
+    /**
+     * @brief 移除该 BaseKey 下指定 type_key 的全部注册项
+     * @param baseKey
+     * @param type_key
+     * @return 移除数量
+     */
+    std::size_t remove(std::string_view baseKey, std::string_view type_key);
+
+    /**
+     * @brief 撤销当前线程最外层批次开始以来的全部注册（含批次内已提交的），动态库加载失败卸载后调用，
+     *        避免注册表保留指向已卸载代码的创建函数；按注册时的键指针匹配，其他动态库注册的同名键保留
+     * @return 移除数量
+     */
+    std::size_t revertBatch();
+
+    /**
+     * @brief 开始当前线程的批量注册，可嵌套；期间 add 只进入线程内待提交队列
+     */
+    void beginBatch();
+
+    /**
+     * @brief 结束批量注册，最外层结束时每个 BaseKey 只复制一次、版本号只递增一次
+     */
+    void commitBatch();
+
 private:
     using H = std::hash<std::string_view>;
     using Eq = std::equal_to<>;
@@ -76,6 +141,7 @@ private:
     struct Bucket {
         std::shared_ptr<const std::vector<RawEntry>> items { std::make_shared<const std::vector<RawEntry>>() };
         std::atomic_size_t ver { 0 };
+        std::atomic_size_t gen { 0 };
     };
 
     /**
@@ -85,10 +151,39 @@ private:
      */
     Bucket& ensure_bucket_unlocked(std::string_view baseKey);
 
+    /**
+     * @brief 提交当前线程待注册项；批量期间本线程读取前也会先提交，保证自己注册的类型可见
+     */
+    void flush_pending() const;
+
+    /**
+     * @brief 移除该 BaseKey 下满足条件的注册项，代号与版本号各递增一次
+     */
+    std::size_t erase(std::string_view baseKey, const std::function<bool(const RawEntry&)>& match);
+
     mutable std::shared_mutex _mtx;
     std::unordered_map<std::string, Bucket, H, Eq> _map;
 };
 
+/**
+ * @brief 作用域内的批量注册，例如包住一次 QPluginLoader::load 让动态库的全部 AUTO_REGISTER 一次提交
+ */
+class RegistryBatch {
+public:
+    RegistryBatch()
+    {
+        RegistryHub::Instance().beginBatch();
+    }
+
+    ~RegistryBatch()
+    {
+        RegistryHub::Instance().commitBatch();
+    }
+
+    RegistryBatch(const RegistryBatch&) = delete;
+    RegistryBatch& operator=(const RegistryBatch&) = delete;
+};
+
 /**
  * @brief 从编译器函数签名中提取干净的类名
  * @tparam T
@@ -97,11 +192,16 @@ private:
 template <typename T>
 inline const char* ExtractClassName()
 {
-    static std::string cleanName;
-    if (cleanName.empty()) {
+    // 局部静态变量的初始化是线程安全的，且每个类型只解析一次
+#if defined(_MSC_VER)
+    constexpr std::string_view sig = __FUNCSIG__;
+#elif defined(__GNUC__) || defined(__clang__)
+    constexpr std::string_view sig = __PRETTY_FUNCTION__;
+#endif
+    static const std::string cleanName = [&]() {
+        std::string cleanName;
 #if defined(_MSC_VER)
         // MSVC: __FUNCSIG__ 格式类似 "const char *__cdecl ExtractClassName<class MyNamespace::MyClass>(void)"
-        constexpr std::string_view sig = __FUNCSIG__;
         constexpr std::string_view prefix = "ExtractClassName<";
         constexpr std::string_view suffix = ">(void)";
 
@@ -125,7 +225,6 @@ inline const char* ExtractClassName()
         }
 #elif defined(__GNUC__) || defined(__clang__)
         // GCC/Clang: __PRETTY_FUNCTION__ 格式类似 "const char* ExtractClassName() [with T = MyNamespace::MyClass]"
-        constexpr std::string_view sig = __PRETTY_FUNCTION__;
         constexpr std::string_view prefix = "[with T = ";
         constexpr char suffix = ']';
 
@@ -141,7 +240,8 @@ inline const char* ExtractClassName()
         // 回退方案：使用 typeid
         cleanName = typeid(T).name();
 #endif
-    }
+        return cleanName;
+    }();
     return cleanName.c_str();
 }
 
@@ -194,50 +294,119 @@ public:
      */
     using Factory = std::function<std::unique_ptr<Base>(Args...)>;
     /**
-     * @brief 原始创建者函数签名：返回 void*，接受 Args...
+     * @brief 原始创建者函数签名：返回 void*，参数按 Args&&... 引用传递，类型擦除的各层之间不复制
      */
-    using RawCreator = std::function<void*(Args...)>;
+    using RawCreator = std::function<void*(Args&&...)>;
+    /**
+     * @brief 就地构造：在调用方提供的存储上构造 Derived，返回其 Base 指针
+     */
+    using Placer = Base* (*)(void*, Args&&...);
+
+    /**
+     * @brief 注册时发布的创建信息，存于 RawEntry::creator
+     */
+    struct Creator {
+        RawCreator create;
+        Placer place = nullptr;
+        std::size_t size = 0;
+        std::size_t align = 0;
+    };
 
     struct Entry {
         const char* type_key;
         Factory factory;
+        RawCreator create;
+        /**
+         * @brief 未发布时为空，只能走堆上创建
+         */
+        Placer place = nullptr;
+        std::size_t size = 0;
+        std::size_t align = 0;
+        /**
+         * @brief 该类型的创建耗时（次数即命中数），刷新缓存时解析一次
+         */
+        MetricHistogram* created = nullptr;
     };
 
     /**
-     * @brief 列举：返回本-DSO 的类型化缓存；当版本变化时自动刷新
-     * @return
+     * @brief 小对象缓冲：Derived 尺寸与对齐满足时就地构造，否则回退到堆上
+     * @tparam Size 缓冲字节数
+     * @tparam Align 缓冲对齐
      */
-    static const std::vector<Entry>& entries()
-    {
-        static std::vector<Entry> cache;
-        static std::size_t cachedVersion = std::numeric_limits<std::size_t>::max();
-        static const std::string baseKey = RegistryBaseKey<Base>();
+    template <std::size_t Size, std::size_t Align = alignof(std::max_align_t)>
+    class Local {
+    public:
+        Local() = default;
 
-        auto& hub = RegistryHub::Instance();
-        const auto v = hub.version(baseKey);
-        if (v != cachedVersion) {
-            cache.clear();
-            auto snap = hub.snapshot(baseKey);
-            cache.reserve(snap->size());
-            for (const auto& re : *snap) {
-                // 将 RawEntry 的 std::any 转回具体的 RawCreator
-                try {
-                    auto rawFunc = std::any_cast<RawCreator>(re.creator);
-
-                    // 包装成类型安全的 Factory
-                    Factory f = [c = std::move(rawFunc)](Args... args) -> std::unique_ptr<Base> {
-                        // 转发参数
-                        return std::unique_ptr<Base>(static_cast<Base*>(c(std::forward<Args>(args)...)));
-                    };
-                    cache.push_back(Entry { re.type_key, std::move(f) });
-                } catch (const std::bad_any_cast&) {
-                    // 如果签名不匹配（例如在这个 Base 下注册了错误参数的子类），这里会忽略
-                    continue;
-                }
+        ~Local()
+        {
+            reset();
+        }
+
+        Local(const Local&) = delete;
+        Local& operator=(const Local&) = delete;
+
+        /**
+         * @brief 销毁当前对象后按键重新创建
+         * @param type_key
+         * @param args 构造参数
+         * @return 未注册时为空
+         */
+        template <typename... Us>
+        Base* emplace(std::string_view type_key, Us&&... args)
+        {
+            reset();
+            const auto e = StaticRegistry::find(type_key);
+            if (e == nullptr) {
+                return nullptr;
+            }
+            if (e->place != nullptr && e->size <= Size && e->align <= Align) {
+                _ptr = e->place(_buf, RegistryBindArg<Args>(std::forward<Us>(args))...);
+                _inplace = true;
+            } else {
+                _ptr = static_cast<Base*>(e->create(RegistryBindArg<Args>(std::forward<Us>(args))...));
+                _inplace = false;
             }
-            cachedVersion = v;
+            return _ptr;
         }
-        return cache;
+
+        void reset()
+        {
+            if (_ptr == nullptr) {
+                return;
+            }
+            if (_inplace) {
+                _ptr->~Base();
+            } else {
+                delete _ptr;
+            }
+            _ptr = nullptr;
+        }
+
+        /**
+         * @brief 是否构造在内部缓冲上（未发生堆分配）
+         */
+        bool isInplace() const { return _ptr != nullptr && _inplace; }
+
+        Base* get() const { return _ptr; }
+        Base* operator->() const { return _ptr; }
+        Base& operator*() const { return *_ptr; }
+        explicit operator bool() const { return _ptr != nullptr; }
+
+    private:
+        alignas(Align) unsigned char _buf[Size];
+        Base* _ptr = nullptr;
+        bool _inplace = false;
+    };
+
+    /**
+     * @brief 列举：返回本-DSO 的类型化缓存快照；当版本变化时自动刷新，已返回的快照不受之后的刷新影响
+     * @return
+     */
+    static std::shared_ptr<const std::vector<Entry>> entries()
+    {
+        auto c = refresh();
+        return std::shared_ptr<const std::vector<Entry>>(c, &c->entries);
     }
 
     /**
@@ -246,32 +415,67 @@ public:
      */
     static std::vector<std::string_view> type_keys()
     {
-        const auto& es = entries();
+        const auto es = entries();
         std::vector<std::string_view> out;
-        out.reserve(es.size());
-        for (const auto& e : es) {
+        out.reserve(es->size());
+        for (const auto& e : *es) {
             out.push_back(e.type_key);
         }
         return out;
     }
 
     /**
-     * @brief 通过字符串键创建（支持传参）
+     * @brief 按键查找条目；返回值持有所在的缓存快照，之后的刷新不会使其失效
+     * @param type_key
+     * @return 未注册时为空
+     */
+    static std::shared_ptr<const Entry> find(std::string_view type_key)
+    {
+        auto c = refresh();
+        auto it = c->index.find(type_key);
+        return it == c->index.end() ? nullptr : std::shared_ptr<const Entry>(c, &c->entries[it->second]);
+    }
+
+    /**
+     * @brief 通过字符串键创建（支持传参）；实参按引用一路转发到 Derived 的构造函数
      * @param type_key
      * @param args 构造参数
      * @return
      */
-    static std::unique_ptr<Base> create(std::string_view type_key, Args... args)
+    template <typename... Us>
+        requires(sizeof...(Us) == sizeof...(Args))
+    static std::unique_ptr<Base> create(std::string_view type_key, Us&&... args)
     {
-        const auto& es = entries();
-        for (const auto& e : es) {
-            if (e.type_key == type_key) {
-                return e.factory(std::forward<Args>(args)...);
-            }
+        if (const auto e = find(type_key)) {
+            MetricTimer timer(PluginMetrics::enabled() ? e->created : nullptr);
+            return std::unique_ptr<Base>(static_cast<Base*>(e->create(RegistryBindArg<Args>(std::forward<Us>(args))...)));
+        }
+        if (PluginMetrics::enabled()) {
+            misses().add();
         }
         return nullptr;
     }
 
+    /**
+     * @brief 在调用方提供的存储上就地构造，调用方负责显式调用析构函数
+     * @param type_key
+     * @param storage 存储首地址
+     * @param size 存储字节数
+     * @param align 存储对齐
+     * @param args 构造参数
+     * @return 未注册、未发布就地构造信息或存储不足时为空
+     */
+    template <typename... Us>
+        requires(sizeof...(Us) == sizeof...(Args))
+    static Base* createAt(std::string_view type_key, void* storage, std::size_t size, std::size_t align, Us&&... args)
+    {
+        const auto e = find(type_key);
+        if (e == nullptr || e->place == nullptr || e->size > size || e->align > align) {
+            return nullptr;
+        }
+        return e->place(storage, RegistryBindArg<Args>(std::forward<Us>(args))...);
+    }
+
     /**
      * @brief 返回某个键的工厂（可能为空）
      * @param type_key
@@ -279,13 +483,8 @@ public:
      */
     static Factory factoryOf(std::string_view type_key)
     {
-        const auto& es = entries();
-        for (const auto& e : es) {
-            if (e.type_key == type_key) {
-                return e.factory;
-            }
-        }
-        return {};
+        const auto e = find(type_key);
+        return e ? e->factory : Factory {};
     }
 
     /**
@@ -297,29 +496,17 @@ public:
         requires std::derived_from<Derived, Base>
     static std::function<std::unique_ptr<Derived>(Args...)> factoryOf()
     {
-        const char* key = RegistryTypeKey<Derived>();
-        const auto& es = entries();
-        for (const auto& e : es) {
-            if (e.type_key == key) {
-                auto bf = e.factory;
-                return [bf = std::move(bf)](Args... args) -> std::unique_ptr<Derived> {
-                    std::unique_ptr<Base> b = bf(std::forward<Args>(args)...);
-                    return std::unique_ptr<Derived>(static_cast<Derived*>(b.release()));
-                };
-            }
+        if (const auto e = find(RegistryTypeKey<Derived>())) {
+            return [raw = e->create](Args... args) -> std::unique_ptr<Derived> {
+                return std::unique_ptr<Derived>(static_cast<Derived*>(static_cast<Base*>(raw(std::forward<Args>(args)...))));
+            };
         }
         return {};
     }
 
     static bool IsRegistered(std::string_view type_key)
     {
-        const auto& es = entries();
-        for (const auto& e : es) {
-            if (e.type_key == type_key) {
-                return true;
-            }
-        }
-        return false;
+        return find(type_key) != nullptr;
     }
 
     template <typename Derived>
@@ -333,9 +520,96 @@ public:
      * @brief 供自动注册使用
      */
     static void AddRaw(const char* type_key, RawCreator creator)
+    {
+        AddRaw(type_key, Creator { std::move(creator) });
+    }
+
+    /**
+     * @brief 供自动注册使用，同时发布就地构造信息
+     */
+    static void AddRaw(const char* type_key, Creator creator)
     {
         // 存入 std::any
-        RegistryHub::Instance().add(RegistryBaseKey<Base>(), type_key, std::any(creator));
+        RegistryHub::Instance().add(RegistryBaseKey<Base>(), type_key, std::any(std::move(creator)));
+    }
+
+private:
+    /**
+     * @brief 未命中按基类聚合，首次使用时解析一次；不按 type_key 拆分，避免未命中的任意键撑大指标表。命中按已注册类型记录，见 Entry::created
+     */
+    static MetricCounter& misses()
+    {
+        static auto& counter = PluginMetrics::Instance().counter("registry.create.miss", RegistryBaseKey<Base>());
+        return counter;
+    }
+
+    /**
+     * @brief 本-DSO 的类型化缓存与按 type_key 的索引；发布后不再修改，刷新时整体替换
+     */
+    struct Cache {
+        std::vector<Entry> entries;
+        /**
+         * @brief {type_key，entries 下标}，重复注册的键指向第一项
+         */
+        std::unordered_map<std::string_view, std::size_t> index;
+        std::size_t version = std::numeric_limits<std::size_t>::max();
+        std::size_t generation = std::numeric_limits<std::size_t>::max();
+        /**
+         * @brief 已转换的快照项数
+         */
+        std::size_t consumed = 0;
+    };
+
+    /**
+     * @brief 版本变化时刷新缓存：注册表只追加时在上一份缓存的副本上仅转换新增项，发生移除（代号变化）时全量重建；
+     *        新缓存整体发布，读侧持有的旧快照保持有效
+     * @return
+     */
+    static std::shared_ptr<const Cache> refresh()
+    {
+        static std::atomic<std::shared_ptr<const Cache>> current { std::make_shared<const Cache>() };
+        static const std::string baseKey = RegistryBaseKey<Base>();
+
+        auto cache = current.load(std::memory_order_acquire);
+        auto& hub = RegistryHub::Instance();
+        if (hub.version(baseKey) == cache->version) {
+            return cache;
+        }
+        // 版本号、代号与快照在同一次加锁中读取，互相一致
+        const auto view = hub.view(baseKey);
+        auto next = std::make_shared<Cache>();
+        if (view.generation == cache->generation && view.items->size() >= cache->consumed) {
+            *next = *cache;
+        } else {
+            next->generation = view.generation;
+            next->entries.reserve(view.items->size());
+        }
+        for (auto i = next->consumed; i < view.items->size(); ++i) {
+            const auto& re = (*view.items)[i];
+            // 将 RawEntry 的 std::any 转回具体的 Creator；签名不匹配（例如在这个 Base 下注册了错误参数的子类）时忽略
+            const auto* c = std::any_cast<Creator>(&re.creator);
+            if (c == nullptr) {
+                continue;
+            }
+            // 包装成类型安全的 Factory
+            Factory f = [raw = c->create](Args... args) -> std::unique_ptr<Base> {
+                return std::unique_ptr<Base>(static_cast<Base*>(raw(std::forward<Args>(args)...)));
+            };
+            // 已注册类型有限，按类型拆分的指标在此解析，创建路径上不再查表
+            auto&& created = PluginMetrics::Instance().histogram("registry.create", baseKey + "/" + re.type_key);
+            next->index.emplace(re.type_key, next->entries.size());
+            next->entries.push_back(Entry { re.type_key, std::move(f), c->create, c->place, c->size, c->align, &created });
+        }
+        next->consumed = view.items->size();
+        next->version = view.version;
+        std::shared_ptr<const Cache> published = std::move(next);
+        // 并发刷新时只用更新的版本替换，较慢的线程不会用旧版本覆盖
+        while (cache->version == std::numeric_limits<std::size_t>::max() || cache->version < published->version) {
+            if (current.compare_exchange_weak(cache, published, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                break;
+            }
+        }
+        return published;
     }
 };
 
@@ -351,20 +625,29 @@ public:
         requires std::derived_from<Derived, Base>
     struct Registrar {
         /**
-         * @brief 跳板函数：接收 Args... 并 new Derived(args...)
+         * @brief 跳板函数：接收 Args&&... 并 new Derived(args...)
          */
-        static void* CreateTrampoline(Args... args)
+        static void* CreateTrampoline(Args&&... args)
         {
             return static_cast<Base*>(new Derived(std::forward<Args>(args)...));
         }
 
+        /**
+         * @brief 跳板函数：在 storage 上构造 Derived
+         */
+        static Base* PlaceTrampoline(void* storage, Args&&... args)
+        {
+            return static_cast<Base*>(::new (storage) Derived(std::forward<Args>(args)...));
+        }
+
         Registrar()
         {
             // 仅当 Derived 是非抽象且可用 Args 构造时才进行注册
             if constexpr (!std::is_abstract_v<Derived> && std::is_constructible_v<Derived, Args...>) {
-                StaticRegistry<Base, Args...>::AddRaw(
+                using Registry = StaticRegistry<Base, Args...>;
+                Registry::AddRaw(
                     RegistryTypeKey<Derived>(),
-                    std::function<void*(Args...)>(&CreateTrampoline));
+                    typename Registry::Creator { &CreateTrampoline, &PlaceTrampoline, sizeof(Derived), alignof(Derived) });
             }
         }
     };
@@ -0,0 +1,94 @@
+﻿#include "GlobalObjectRegistry.h"
+
+#include "QPluginLogging.h"
+
+#include <cassert>
+
+GlobalObjectRegistry::GlobalObjectRegistry() { }
+
+GlobalObjectRegistry::~GlobalObjectRegistry()
+{
+    for (auto& chunk : _chunks) {
+        delete[] chunk.load(std::memory_order_relaxed);
+    }
+}
+
+GlobalObjectRegistry& GlobalObjectRegistry::Instance()
+{
+    static GlobalObjectRegistry instance;
+    return instance;
+}
+
+std::size_t GlobalObjectRegistry::slotOf(std::string_view key)
+{
+    {
+        std::shared_lock lock(_mtx);
+        auto it = _index.find(key);
+        if (it != _index.end()) {
+            return it->second;
+        }
+    }
+    std::unique_lock lock(_mtx);
+    auto it = _index.find(key);
+    if (it != _index.end()) {
+        return it->second;
+    }
+    const auto slot = _index.size();
+    if (slot >= CAPACITY) {
+        qCWarning(lcPluginRegistry) << "全局对象表已满，忽略键:" << QByteArray(key.data(), static_cast<int>(key.size()));
+        return npos;
+    }
+    auto& chunk = _chunks[slot >> CHUNK_BITS];
+    if (chunk.load(std::memory_order_relaxed) == nullptr) {
+        auto* cells = new std::atomic<void*>[CHUNK_SIZE];
+        for (std::size_t i = 0; i < CHUNK_SIZE; ++i) {
+            cells[i].store(nullptr, std::memory_order_relaxed);
+        }
+        chunk.store(cells, std::memory_order_release);
+    }
+    _index.emplace(std::string(key), slot);
+    return slot;
+}
+
+void* GlobalObjectRegistry::set(std::size_t slot, void* ptr)
+{
+    if (slot >= CAPACITY) {
+        return nullptr;
+    }
+    auto* chunk = _chunks[slot >> CHUNK_BITS].load(std::memory_order_acquire);
+    assert(chunk != nullptr);
+    chunk[slot & (CHUNK_SIZE - 1)].store(ptr, std::memory_order_release);
+    return ptr;
+}
+
+void* GlobalObjectRegistry::createSlow(std::size_t slot, const std::function<void*()>& create, void (*destroy)(void*))
+{
+    if (slot >= CAPACITY) {
+        return nullptr;
+    }
+    std::lock_guard lock(_createMtx);
+    // 双重检查：等锁期间可能已由其他线程构造
+    if (auto ptr = get(slot)) {
+        return ptr;
+    }
+    auto ptr = create();
+    set(slot, ptr);
+    if (destroy != nullptr && ptr != nullptr) {
+        _owned.push_back(Owned { slot, ptr, destroy });
+    }
+    return ptr;
+}
+
+void GlobalObjectRegistry::destroyAll()
+{
+    std::lock_guard lock(_createMtx);
+    while (!_owned.empty()) {
+        auto owned = _owned.back();
+        _owned.pop_back();
+        // 槽位已被 set 替换时只清理自己构造的对象
+        if (get(owned.slot) == owned.ptr) {
+            set(owned.slot, nullptr);
+        }
+        owned.destroy(owned.ptr);
+    }
+}
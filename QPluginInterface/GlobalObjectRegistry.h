@@ -0,0 +1,130 @@
+﻿#pragma once
+
+#include <QtCore/qglobal.h>
+
+#ifndef BUILD_STATIC
+#if defined(QPLUGININTERFACE_LIB)
+#define QPLUGININTERFACE_EXPORT Q_DECL_EXPORT
+#else
+#define QPLUGININTERFACE_EXPORT Q_DECL_IMPORT
+#endif
+#else
+#define QPLUGININTERFACE_EXPORT
+#endif
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 进程级全局对象表：键只在首次使用时解析为槽位下标，之后读取只有一次原子加载
+ */
+class QPLUGININTERFACE_EXPORT GlobalObjectRegistry {
+private:
+    GlobalObjectRegistry();
+
+public:
+    ~GlobalObjectRegistry();
+
+    static GlobalObjectRegistry& Instance();
+
+    /**
+     * @brief 无效槽位，槽位用尽时由 slotOf 返回；对它的读写均为空操作
+     */
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    /**
+     * @brief 键对应的槽位下标，同一键在进程内始终不变
+     * @param key
+     * @return 槽位用尽时为 npos
+     */
+    std::size_t slotOf(std::string_view key);
+
+    /**
+     * @brief 读取槽位（无锁）
+     * @param slot
+     * @return 未设置或槽位无效时为空
+     */
+    void* get(std::size_t slot) const
+    {
+        if (slot >= CAPACITY) {
+            return nullptr;
+        }
+        const auto* chunk = _chunks[slot >> CHUNK_BITS].load(std::memory_order_acquire);
+        return chunk ? chunk[slot & (CHUNK_SIZE - 1)].load(std::memory_order_acquire) : nullptr;
+    }
+
+    /**
+     * @brief 设置槽位（不接管所有权）
+     * @param slot
+     * @param ptr
+     * @return ptr，槽位无效时为空
+     */
+    void* set(std::size_t slot, void* ptr);
+
+    /**
+     * @brief 读取槽位，为空时线程安全地仅构造一次
+     * @tparam T 对象类型
+     * @param slot
+     * @param owned 是否由注册表按构造逆序析构
+     * @param create 构造函数
+     * @return
+     */
+    template <typename T, typename F>
+    T* getOrCreate(std::size_t slot, bool owned, F&& create)
+    {
+        if (auto ptr = get(slot)) {
+            return static_cast<T*>(ptr);
+        }
+        void (*destroy)(void*) = nullptr;
+        if (owned) {
+            destroy = [](void* p) { delete static_cast<T*>(p); };
+        }
+        return static_cast<T*>(createSlow(slot, [&create]() -> void* { return create(); }, destroy));
+    }
+
+    /**
+     * @brief 按构造逆序析构由注册表持有的对象，并清空对应槽位
+     */
+    void destroyAll();
+
+private:
+    void* createSlow(std::size_t slot, const std::function<void*()>& create, void (*destroy)(void*));
+
+    static constexpr std::size_t CHUNK_BITS = 8;
+    static constexpr std::size_t CHUNK_SIZE = std::size_t(1) << CHUNK_BITS;
+    static constexpr std::size_t MAX_CHUNKS = 64;
+    static constexpr std::size_t CAPACITY = CHUNK_SIZE * MAX_CHUNKS;
+
+    struct StringHash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view s) const noexcept
+        {
+            return std::hash<std::string_view> {}(s);
+        }
+    };
+
+    std::array<std::atomic<std::atomic<void*>*>, MAX_CHUNKS> _chunks {};
+
+    mutable std::shared_mutex _mtx;
+    std::unordered_map<std::string, std::size_t, StringHash, std::equal_to<>> _index;
+
+    /**
+     * @brief 构造期间可能递归注册其他对象，使用可重入锁
+     */
+    std::recursive_mutex _createMtx;
+
+    struct Owned {
+        std::size_t slot;
+        void* ptr;
+        void (*destroy)(void*);
+    };
+    std::vector<Owned> _owned;
+};
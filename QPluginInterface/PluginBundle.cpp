@@ -0,0 +1,10 @@
+﻿#include "PluginBundle.h"
+
+PluginBundle::~PluginBundle()
+{
+}
+
+std::unique_ptr<PluginInterface> PluginBundle::create(const QString& className)
+{
+    return StaticRegistry<PluginInterface>::create(className.toStdString());
+}
@@ -0,0 +1,46 @@
+﻿#pragma once
+
+#include <QObject>
+
+#ifndef BUILD_STATIC
+#if defined(QPLUGININTERFACE_LIB)
+#define QPLUGININTERFACE_EXPORT Q_DECL_EXPORT
+#else
+#define QPLUGININTERFACE_EXPORT Q_DECL_IMPORT
+#endif
+#else
+#define QPLUGININTERFACE_EXPORT
+#endif
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+#pragma execution_character_set("utf-8")
+#endif
+
+#include <memory>
+
+#include "AutoRegistered.h"
+#include "PluginInterface.h"
+
+/**
+ * @brief 插件包根对象：一个动态库内含多个插件，元信息 Plugins 数组逐项声明 Name、Class、Interface 与 Dependencies。
+ *        管理器只加载一次动态库，再经本对象按 Class 创建各插件实例，各实例与独立插件一样参与筛选、查找与初始化
+ */
+class QPLUGININTERFACE_EXPORT PluginBundle : public QObject {
+    Q_OBJECT;
+
+public:
+    ~PluginBundle() override;
+
+    /**
+     * @brief 创建包内插件实例，默认按 Class 查找 REGISTER_BUNDLE_PLUGIN 注册的工厂
+     * @param className 元信息中的 Class，缺省为 Name
+     * @return 未注册时为空；实例由管理器接管
+     */
+    virtual std::unique_ptr<PluginInterface> create(const QString& className);
+};
+
+// 注册插件包内的插件类，type_key 即元信息中的 Class；不同插件包的同名类需以命名空间区分
+// 用法: REGISTER_BUNDLE_PLUGIN(MyPlugin)
+#ifndef REGISTER_BUNDLE_PLUGIN
+#define REGISTER_BUNDLE_PLUGIN(CLASS) AUTO_REGISTER(CLASS, PluginInterface)
+#endif
@@ -0,0 +1,31 @@
+﻿#pragma once
+
+#include <QObject>
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+#pragma execution_character_set("utf-8")
+#endif
+
+/**
+ * @brief 可选的 fork 钩子：插件需要在孕育进程 fork 工作进程前后处理自己的线程与描述符时实现本接口，
+ *        并以 Q_INTERFACES(PluginForkHooks) 声明；管理器经 qobject_cast 查询，不改变 PluginInterface 的布局
+ */
+class PluginForkHooks {
+public:
+    virtual ~PluginForkHooks() = default;
+
+    /**
+     * @brief fork 之前调用（实例所在线程）：停止自行创建的线程与线程池任务，关闭不应由父子进程共享的描述符
+     */
+    virtual void beforeFork() = 0;
+
+    /**
+     * @brief fork 之后在父子进程中各调用一次（实例所在线程）
+     * @param child 是否为工作进程；工作进程中重新打开描述符、重启线程，孕育进程中恢复 beforeFork 停止的工作
+     */
+    virtual void afterFork(bool child) = 0;
+};
+
+QT_BEGIN_NAMESPACE
+Q_DECLARE_INTERFACE(PluginForkHooks, "cn.hiyj.PluginForkHooks")
+QT_END_NAMESPACE
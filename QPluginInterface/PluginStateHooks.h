@@ -0,0 +1,45 @@
+﻿#pragma once
+
+#include <QByteArray>
+#include <QObject>
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+#pragma execution_character_set("utf-8")
+#endif
+
+/**
+ * @brief 可选的检查点钩子：插件需要由检查点缓存跳过耗时初始化时实现本接口，并以 Q_INTERFACES(PluginStateHooks) 声明；
+ *        管理器经 qobject_cast 查询，不改变 PluginInterface 的布局
+ */
+class PluginStateHooks {
+public:
+    virtual ~PluginStateHooks() = default;
+
+    /**
+     * @brief 启用检查点缓存时，在 extensionsInitialize 之后调用（插件所在线程），导出可在下次启动时恢复的初始化结果
+     * @return 检查点数据，为空时不缓存
+     */
+    virtual QByteArray saveState() = 0;
+
+    /**
+     * @brief 启用检查点缓存且指纹未变时，在 initialize 之前调用（插件所在线程）；
+     *        恢复成功的插件在 initialize 中跳过耗时的构建步骤
+     * @param state 检查点数据，直接引用文件映射，仅在本次调用内有效；需保留时深复制（如 QByteArray(state.constData(), state.size())），
+     *        赋值或按值保存只共享引用
+     * @return 是否已恢复，返回 false 时按冷启动初始化并重新导出
+     */
+    virtual bool restoreState(const QByteArray& state) = 0;
+
+    /**
+     * @brief 并入检查点指纹的附加键（插件所在线程），如配置文件的哈希；键变化时检查点作废
+     * @return 默认为空
+     */
+    virtual QByteArray stateKey()
+    {
+        return QByteArray();
+    }
+};
+
+QT_BEGIN_NAMESPACE
+Q_DECLARE_INTERFACE(PluginStateHooks, "cn.hiyj.PluginStateHooks")
+QT_END_NAMESPACE
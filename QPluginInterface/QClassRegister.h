@@ -2,7 +2,10 @@
 
 #include <QCoreApplication>
 #include <QVariant>
-#include <qDebug>
+#include <type_traits>
+
+#include "GlobalObjectRegistry.h"
+#include "QPluginLogging.h"
 
 #ifndef GetQValueClassName
 #define GetQValueClassName(value) [](const QObject* obj) { return obj->metaObject()->className(); }(value)
@@ -12,41 +15,42 @@
 #define GetQClassName(className) #className
 #endif
 
+// 对象不析构，与进程同生存期（与存入 qApp 属性时一致），卸载插件后其他上下文与静态析构中仍可使用
 #ifndef RegisterQClass
-#define RegisterQClass(className)                                          \
-    [&]() {                                                                \
-        auto&& rs = qApp->property(#className).value<void*>();             \
-        if (rs == nullptr) {                                               \
-            rs = new className();                                          \
-            qApp->setProperty(#className, QVariant::fromValue((void*)rs)); \
-        };                                                                 \
-        assert(rs != nullptr);                                             \
-        return static_cast<className*>(rs);                                \
+#define RegisterQClass(className)                                                             \
+    [&]() {                                                                                   \
+        static const auto slot = GlobalObjectRegistry::Instance().slotOf(#className);         \
+        auto rs = GlobalObjectRegistry::Instance().getOrCreate<className>(slot, false, []() { \
+            return new className();                                                           \
+        });                                                                                   \
+        assert(rs != nullptr);                                                               \
+        return rs;                                                                           \
     }()
 #endif
 
+// 对象由 parent 持有
 #ifndef RegisterQClassP
-#define RegisterQClassP(className, parent)                                 \
-    [&]() {                                                                \
-        auto&& rs = qApp->property(#className).value<void*>();             \
-        if (rs == nullptr) {                                               \
-            rs = new className(parent);                                    \
-            qApp->setProperty(#className, QVariant::fromValue((void*)rs)); \
-        };                                                                 \
-        assert(rs != nullptr);                                             \
-        return static_cast<className*>(rs);                                \
+#define RegisterQClassP(className, parent)                                                     \
+    [&]() {                                                                                    \
+        static const auto slot = GlobalObjectRegistry::Instance().slotOf(#className);          \
+        auto rs = GlobalObjectRegistry::Instance().getOrCreate<className>(slot, false, [&]() { \
+            return new className(parent);                                                      \
+        });                                                                                    \
+        assert(rs != nullptr);                                                                 \
+        return rs;                                                                             \
     }()
 #endif
 
 #ifndef GetRegisterQClass
 // 获取注册的对象
-#define GetRegisterQClass(className)                                        \
-    [&]() {                                                                 \
-        auto rs = qApp->property(#className).value<void*>();                \
-        if (rs == nullptr)                                                  \
-            qDebug() << "GetRegisterQClass:" << #className << "is nullptr"; \
-        assert(rs != nullptr);                                              \
-        return static_cast<className*>(rs);                                 \
+#define GetRegisterQClass(className)                                                              \
+    [&]() {                                                                                       \
+        static const auto slot = GlobalObjectRegistry::Instance().slotOf(#className);             \
+        auto rs = GlobalObjectRegistry::Instance().get(slot);                                     \
+        if (rs == nullptr)                                                                        \
+            qPluginDebug(lcPluginRegistry) << "GetRegisterQClass:" << #className << "is nullptr"; \
+        assert(rs != nullptr);                                                                    \
+        return static_cast<className*>(rs);                                                       \
     }()
 #endif
 
@@ -66,44 +70,57 @@
     QT_END_NAMESPACE
 #endif // !RegisterMetaType
 
+// 属性键解析为槽位：字符串字面量在每个宏展开处首次使用时解析并缓存，其他键（变量、表达式）每次调用时解析
+#ifndef QPropertySlotOf
+#define QPropertySlotOf(key)                                                       \
+    [&](auto literal) {                                                            \
+        if constexpr (decltype(literal)::value) {                                  \
+            static const auto slot = GlobalObjectRegistry::Instance().slotOf(key); \
+            return slot;                                                           \
+        } else {                                                                   \
+            return GlobalObjectRegistry::Instance().slotOf(key);                   \
+        }                                                                          \
+    }(std::bool_constant<(#key)[0] == '"'> {})
+#endif
+
 // 注册指定类型指针转为属性值
 #ifndef RegisterPropertyPtr
-#define RegisterPropertyPtr(key, ptr)                          \
-    [&] {                                                      \
-        auto&& p = ptr;                                        \
-        qApp->setProperty(key, QVariant::fromValue((void*)p)); \
-        return p;                                              \
+#define RegisterPropertyPtr(key, ptr)                                         \
+    [&] {                                                                     \
+        auto&& p = ptr;                                                       \
+        GlobalObjectRegistry::Instance().set(QPropertySlotOf(key), (void*)p); \
+        return p;                                                             \
     }()
 #endif
 
 // 获取app属性值转为指定类型指针
 #ifndef GetAppPropertyPtr
-#define GetAppPropertyPtr(key, className)                            \
-    [&]() -> className* {                                            \
-        auto&& rs = qApp->property(key).value<void*>();              \
-        if (rs == nullptr) {                                         \
-            qDebug() << "GetAppPropertyPtr:" << key << "is nullptr"; \
-            return nullptr;                                          \
-        }                                                            \
-        return reinterpret_cast<className*>(rs);                     \
+#define GetAppPropertyPtr(key, className)                                                  \
+    [&]() -> className* {                                                                  \
+        auto&& rs = GlobalObjectRegistry::Instance().get(QPropertySlotOf(key));            \
+        if (rs == nullptr) {                                                               \
+            qPluginDebug(lcPluginRegistry) << "GetAppPropertyPtr:" << key << "is nullptr"; \
+            return nullptr;                                                                \
+        }                                                                                  \
+        return reinterpret_cast<className*>(rs);                                           \
     }()
 #endif // !GetAppPropertyPtr
 
 // set app属性值
 #ifndef SetAppPropertyPtr
-#define SetAppPropertyPtr(key, value) qApp->setProperty(key, QVariant::fromValue((void*)value))
+#define SetAppPropertyPtr(key, value) GlobalObjectRegistry::Instance().set(QPropertySlotOf(key), (void*)value)
 #endif
 
 #ifdef QPLUGINMANAGER
 #ifndef GetPluginPtr
-#define GetPluginPtr(className)                                    \
-    [&](const QString& name) -> std::optional<className*> {        \
-        auto&& opt = QPluginManager::Instance().load(name);        \
-        if (!opt.has_value()) {                                    \
-            qWarning() << "GetPluginPtr:" << name << "is nullptr"; \
-            return { std::nullopt };                               \
-        }                                                          \
-        return { reinterpret_cast<className*>(opt.value()) };      \
+#define GetPluginPtr(className)                                                     \
+    [&](const QString& name) -> std::optional<className*> {                         \
+        auto&& opt = QPluginManager::Current().load(name);                          \
+        if (!opt.has_value()) {                                                     \
+            qCWarning(lcPluginRegistry) << "GetPluginPtr:" << name << "is nullptr"; \
+            return { std::nullopt };                                                \
+        }                                                                           \
+        return { reinterpret_cast<className*>(opt.value()) };                       \
     }(#className)
 #endif // !GetPluginPtr
 #else
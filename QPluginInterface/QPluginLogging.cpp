@@ -0,0 +1,239 @@
+﻿#include "QPluginLogging.h"
+
+#include <QDateTime>
+#include <QFile>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <utility>
+
+Q_LOGGING_CATEGORY(lcPluginManager, "qplugin.manager", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcPluginRegistry, "qplugin.registry", QtInfoMsg)
+
+namespace {
+const char* levelOf(QtMsgType type)
+{
+    switch (type) {
+    case QtDebugMsg:
+        return "D";
+    case QtInfoMsg:
+        return "I";
+    case QtWarningMsg:
+        return "W";
+    case QtCriticalMsg:
+        return "C";
+    case QtFatalMsg:
+        return "F";
+    }
+    return "?";
+}
+}
+
+PluginLogSink::PluginLogSink() { }
+
+PluginLogSink::~PluginLogSink()
+{
+    uninstall();
+}
+
+PluginLogSink& PluginLogSink::Instance()
+{
+    static PluginLogSink instance;
+    return instance;
+}
+
+bool PluginLogSink::install(const QString& path, int flushMs, std::size_t capacity)
+{
+    uninstall();
+    auto file = new QFile(path);
+    const auto opened = path.isEmpty()
+        ? file->open(stderr, QIODevice::WriteOnly | QIODevice::Unbuffered)
+        : file->open(QIODevice::WriteOnly | QIODevice::Append);
+    if (!opened) {
+        delete file;
+        return false;
+    }
+    {
+        std::lock_guard lock(_mtx);
+        _file = file;
+        _flushMs = std::max(flushMs, 1);
+        _capacity = std::max<std::size_t>(capacity, 1);
+        _pending.reserve(std::min<std::size_t>(_capacity, BATCH_SIZE));
+        _stop = false;
+        _flushRequested = false;
+    }
+    _thread = std::thread(&PluginLogSink::run, this);
+    _previous = qInstallMessageHandler(&PluginLogSink::handler);
+    _installed.store(true, std::memory_order_release);
+    return true;
+}
+
+void PluginLogSink::uninstall()
+{
+    if (!_installed.exchange(false)) {
+        return;
+    }
+    qInstallMessageHandler(_previous);
+    _previous = nullptr;
+    {
+        std::lock_guard lock(_mtx);
+        _stop = true;
+    }
+    _cv.notify_all();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+    delete std::exchange(_file, nullptr);
+}
+
+void PluginLogSink::flush()
+{
+    if (!_installed.load(std::memory_order_acquire)) {
+        return;
+    }
+    std::unique_lock lock(_mtx);
+    if (_suspended) {
+        // 后台线程已停止，在调用线程写出
+        _drained.wait(lock, [this]() { return !_writing; });
+        std::vector<Entry> batch;
+        batch.swap(_pending);
+        _writing = true;
+        lock.unlock();
+        write(batch);
+        lock.lock();
+        _writing = false;
+        _drained.notify_all();
+        return;
+    }
+    _flushRequested = true;
+    _cv.notify_all();
+    _drained.wait(lock, [this]() { return _stop || (_pending.empty() && !_writing); });
+}
+
+void PluginLogSink::suspend()
+{
+    if (!_installed.load(std::memory_order_acquire)) {
+        return;
+    }
+    {
+        std::lock_guard lock(_mtx);
+        _stop = true;
+    }
+    _cv.notify_all();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+    std::lock_guard lock(_mtx);
+    _stop = false;
+    _suspended = true;
+}
+
+void PluginLogSink::resume()
+{
+    if (!_installed.load(std::memory_order_acquire) || _thread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard lock(_mtx);
+        _suspended = false;
+    }
+    _thread = std::thread(&PluginLogSink::run, this);
+}
+
+bool PluginLogSink::isInstalled() const
+{
+    return _installed.load(std::memory_order_acquire);
+}
+
+std::uint64_t PluginLogSink::written() const
+{
+    return _written.load(std::memory_order_relaxed);
+}
+
+std::uint64_t PluginLogSink::dropped() const
+{
+    return _dropped.load(std::memory_order_relaxed);
+}
+
+void PluginLogSink::handler(QtMsgType type, const QMessageLogContext& context, const QString& message)
+{
+    auto&& self = Instance();
+    self.enqueue(type, context.category, message);
+    if (type != QtFatalMsg) {
+        return;
+    }
+    // 致命消息返回后进程即终止，在当前线程同步写出队列
+    std::vector<Entry> batch;
+    {
+        std::unique_lock lock(self._mtx);
+        self._drained.wait_for(lock, std::chrono::milliseconds(self._flushMs), [&self]() { return !self._writing; });
+        batch.swap(self._pending);
+    }
+    self.write(batch);
+}
+
+void PluginLogSink::enqueue(QtMsgType type, const char* category, const QString& message)
+{
+    std::unique_lock lock(_mtx);
+    if (_pending.size() >= _capacity) {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    _pending.push_back(Entry { type, QDateTime::currentMSecsSinceEpoch(), QByteArray(category ? category : "default"), message });
+    const auto wake = _pending.size() == BATCH_SIZE || type == QtCriticalMsg || type == QtFatalMsg;
+    lock.unlock();
+    if (wake) {
+        _cv.notify_one();
+    }
+}
+
+void PluginLogSink::run()
+{
+    std::vector<Entry> batch;
+    std::unique_lock lock(_mtx);
+    while (true) {
+        _cv.wait_for(lock, std::chrono::milliseconds(_flushMs), [this]() {
+            return _stop || _flushRequested || _pending.size() >= BATCH_SIZE;
+        });
+        _flushRequested = false;
+        if (_pending.empty()) {
+            _drained.notify_all();
+            if (_stop) {
+                break;
+            }
+            continue;
+        }
+        // 交换后复用两块缓冲区，稳定运行时不再分配
+        batch.swap(_pending);
+        _writing = true;
+        lock.unlock();
+        write(batch);
+        batch.clear();
+        lock.lock();
+        _writing = false;
+        _drained.notify_all();
+    }
+}
+
+void PluginLogSink::write(const std::vector<Entry>& batch)
+{
+    if (batch.empty() || _file == nullptr) {
+        return;
+    }
+    QByteArray out;
+    out.reserve(static_cast<int>(batch.size()) * 96);
+    for (const auto& entry : batch) {
+        out += QDateTime::fromMSecsSinceEpoch(entry.msecs).toString("yyyy-MM-dd hh:mm:ss.zzz").toUtf8();
+        out += ' ';
+        out += levelOf(entry.type);
+        out += ' ';
+        out += entry.category;
+        out += ": ";
+        out += entry.message.toUtf8();
+        out += '\n';
+    }
+    _file->write(out);
+    _file->flush();
+    _written.fetch_add(batch.size(), std::memory_order_relaxed);
+}
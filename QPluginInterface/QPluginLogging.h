@@ -0,0 +1,153 @@
+﻿#pragma once
+
+#include <QtCore/qglobal.h>
+
+#ifndef BUILD_STATIC
+#if defined(QPLUGININTERFACE_LIB)
+#define QPLUGININTERFACE_EXPORT Q_DECL_EXPORT
+#else
+#define QPLUGININTERFACE_EXPORT Q_DECL_IMPORT
+#endif
+#else
+#define QPLUGININTERFACE_EXPORT
+#endif
+
+#include <QByteArray>
+#include <QLoggingCategory>
+#include <QString>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+QT_FORWARD_DECLARE_CLASS(QFile)
+
+/**
+ * @brief 插件管理器日志分类 qplugin.manager，默认只输出 info 及以上，
+ *        运行时通过 QT_LOGGING_RULES="qplugin.*.debug=true" 打开调试输出
+ */
+QPLUGININTERFACE_EXPORT const QLoggingCategory& lcPluginManager();
+
+/**
+ * @brief 注册表日志分类 qplugin.registry（RegisterQClass/GetPluginPtr 等宏）
+ */
+QPLUGININTERFACE_EXPORT const QLoggingCategory& lcPluginRegistry();
+
+/**
+ * @brief 调试日志；定义 QPLUGIN_NO_DEBUG_LOG 时整条语句在编译期移除，参数不会求值
+ */
+#if defined(QPLUGIN_NO_DEBUG_LOG)
+#define qPluginDebug(category) \
+    while (false)              \
+    QMessageLogger().noDebug()
+#else
+#define qPluginDebug(category) qCDebug(category)
+#endif
+
+/**
+ * @brief 异步批量日志输出：消息处理函数只把消息放入队列，格式化与写入在后台线程批量完成，
+ *        日志 I/O 不占用加载线程
+ */
+class QPLUGININTERFACE_EXPORT PluginLogSink {
+private:
+    PluginLogSink();
+
+public:
+    ~PluginLogSink();
+
+    static PluginLogSink& Instance();
+
+    /**
+     * @brief 安装为 Qt 消息处理函数
+     * @param path 输出文件（追加写入），为空时写入 stderr
+     * @param flushMs 后台线程最长的批量间隔
+     * @param capacity 队列上限，写入跟不上时丢弃新消息并计数，保证调用线程不阻塞
+     * @return 文件无法打开时返回 false
+     */
+    bool install(const QString& path = QString(), int flushMs = 100, std::size_t capacity = 65536);
+
+    /**
+     * @brief 写出剩余消息并恢复之前的消息处理函数
+     */
+    void uninstall();
+
+    /**
+     * @brief 等待当前队列中的消息全部写出；suspend 期间在调用线程写出
+     */
+    void flush();
+
+    /**
+     * @brief 写出队列并停止后台线程，之后的消息留在队列中，flush 时在调用线程写出；fork 之前调用，子进程中不存在父进程的线程
+     */
+    void suspend();
+
+    /**
+     * @brief 重新启动 suspend 停止的后台线程，fork 之后在父子进程中各调用一次
+     */
+    void resume();
+
+    bool isInstalled() const;
+
+    /**
+     * @brief 已写出的消息数
+     */
+    std::uint64_t written() const;
+
+    /**
+     * @brief 队列满时丢弃的消息数
+     */
+    std::uint64_t dropped() const;
+
+private:
+    struct Entry {
+        QtMsgType type;
+        qint64 msecs;
+        QByteArray category;
+        QString message;
+    };
+
+    /**
+     * @brief 队列达到该长度时提前唤醒后台线程
+     */
+    static constexpr std::size_t BATCH_SIZE = 256;
+
+    static void handler(QtMsgType type, const QMessageLogContext& context, const QString& message);
+
+    void enqueue(QtMsgType type, const char* category, const QString& message);
+
+    void run();
+
+    /**
+     * @brief 格式化并一次写出一批消息
+     * @param batch
+     */
+    void write(const std::vector<Entry>& batch);
+
+    mutable std::mutex _mtx;
+    std::condition_variable _cv;
+    std::condition_variable _drained;
+    std::vector<Entry> _pending;
+    std::size_t _capacity = 65536;
+    int _flushMs = 100;
+    bool _stop = false;
+    bool _flushRequested = false;
+    bool _writing = false;
+    /**
+     * @brief suspend 之后、resume 之前没有后台线程
+     */
+    bool _suspended = false;
+    std::thread _thread;
+
+    /**
+     * @brief 只在后台线程写入（致命消息与 suspend 期间的 flush 除外，此时没有并发的写入）
+     */
+    QFile* _file = nullptr;
+
+    QtMessageHandler _previous = nullptr;
+    std::atomic_bool _installed { false };
+    std::atomic<std::uint64_t> _written { 0 };
+    std::atomic<std::uint64_t> _dropped { 0 };
+};
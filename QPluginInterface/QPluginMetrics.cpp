@@ -0,0 +1,303 @@
+﻿#include "QPluginMetrics.h"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QString>
+
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+
+std::atomic_bool PluginMetrics::s_enabled { false };
+
+std::size_t MetricCounter::ShardIndex()
+{
+    static std::atomic_size_t next { 0 };
+    thread_local const std::size_t index = next.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+    return index;
+}
+
+std::uint64_t MetricCounter::value() const
+{
+    std::uint64_t sum = 0;
+    for (const auto& s : _shards) {
+        sum += s.value.load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+void MetricCounter::reset()
+{
+    for (auto& s : _shards) {
+        s.value.store(0, std::memory_order_relaxed);
+    }
+}
+
+std::size_t MetricHistogram::BucketOf(std::uint64_t value)
+{
+    constexpr std::uint64_t sub = 1ull << SUB_BITS;
+    if (value < sub) {
+        return static_cast<std::size_t>(value);
+    }
+    const int shift = std::bit_width(value) - 1 - SUB_BITS;
+    const auto mantissa = (value >> shift) & (sub - 1);
+    return static_cast<std::size_t>((shift + 1) * sub + mantissa);
+}
+
+std::uint64_t MetricHistogram::BucketUpper(std::size_t index)
+{
+    constexpr std::size_t sub = std::size_t(1) << SUB_BITS;
+    if (index < sub) {
+        return index;
+    }
+    const auto shift = index / sub - 1;
+    const auto lower = static_cast<std::uint64_t>(sub + index % sub) << shift;
+    return lower + ((std::uint64_t(1) << shift) - 1);
+}
+
+void MetricHistogram::record(std::uint64_t value)
+{
+    _buckets[BucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+    _count.fetch_add(1, std::memory_order_relaxed);
+    _sum.fetch_add(value, std::memory_order_relaxed);
+    auto lo = _min.load(std::memory_order_relaxed);
+    while (value < lo && !_min.compare_exchange_weak(lo, value, std::memory_order_relaxed)) { }
+    auto hi = _max.load(std::memory_order_relaxed);
+    while (value > hi && !_max.compare_exchange_weak(hi, value, std::memory_order_relaxed)) { }
+}
+
+HistogramSnapshot MetricHistogram::snapshot() const
+{
+    HistogramSnapshot s;
+    std::array<std::uint64_t, BUCKETS> counts {};
+    std::uint64_t total = 0;
+    for (std::size_t i = 0; i < BUCKETS; ++i) {
+        counts[i] = _buckets[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    s.count = total;
+    s.sum = _sum.load(std::memory_order_relaxed);
+    s.max = _max.load(std::memory_order_relaxed);
+    s.min = total == 0 ? 0 : _min.load(std::memory_order_relaxed);
+    if (total == 0) {
+        return s;
+    }
+    const auto percentile = [&](double p) -> std::uint64_t {
+        const auto target = static_cast<std::uint64_t>(p * static_cast<double>(total) + 0.5);
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < BUCKETS; ++i) {
+            seen += counts[i];
+            if (seen >= std::max<std::uint64_t>(target, 1)) {
+                return std::min(BucketUpper(i), s.max);
+            }
+        }
+        return s.max;
+    };
+    s.p50 = percentile(0.50);
+    s.p90 = percentile(0.90);
+    s.p99 = percentile(0.99);
+    s.p999 = percentile(0.999);
+    return s;
+}
+
+void MetricHistogram::reset()
+{
+    for (auto& b : _buckets) {
+        b.store(0, std::memory_order_relaxed);
+    }
+    _count.store(0, std::memory_order_relaxed);
+    _sum.store(0, std::memory_order_relaxed);
+    _min.store(std::numeric_limits<std::uint64_t>::max(), std::memory_order_relaxed);
+    _max.store(0, std::memory_order_relaxed);
+}
+
+void MetricHistogram::merge(const MetricHistogram& other)
+{
+    for (std::size_t i = 0; i < BUCKETS; ++i) {
+        if (const auto n = other._buckets[i].load(std::memory_order_relaxed)) {
+            _buckets[i].fetch_add(n, std::memory_order_relaxed);
+        }
+    }
+    _count.fetch_add(other._count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    _sum.fetch_add(other._sum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    const auto value = other._min.load(std::memory_order_relaxed);
+    auto lo = _min.load(std::memory_order_relaxed);
+    while (value < lo && !_min.compare_exchange_weak(lo, value, std::memory_order_relaxed)) { }
+    const auto top = other._max.load(std::memory_order_relaxed);
+    auto hi = _max.load(std::memory_order_relaxed);
+    while (top > hi && !_max.compare_exchange_weak(hi, top, std::memory_order_relaxed)) { }
+}
+
+QJsonObject MetricsSnapshot::toJson() const
+{
+    QJsonObject counterObj;
+    for (const auto& [key, value] : counters) {
+        counterObj.insert(QString::fromStdString(key), static_cast<qint64>(value));
+    }
+    QJsonObject histogramObj;
+    for (const auto& [key, h] : histograms) {
+        QJsonObject obj;
+        obj.insert("count", static_cast<qint64>(h.count));
+        obj.insert("sum", static_cast<qint64>(h.sum));
+        obj.insert("min", static_cast<qint64>(h.min));
+        obj.insert("max", static_cast<qint64>(h.max));
+        obj.insert("p50", static_cast<qint64>(h.p50));
+        obj.insert("p90", static_cast<qint64>(h.p90));
+        obj.insert("p99", static_cast<qint64>(h.p99));
+        obj.insert("p999", static_cast<qint64>(h.p999));
+        histogramObj.insert(QString::fromStdString(key), obj);
+    }
+    QJsonObject obj;
+    obj.insert("counters", counterObj);
+    obj.insert("histograms", histogramObj);
+    return obj;
+}
+
+PluginMetrics::PluginMetrics()
+{
+    const char* env = std::getenv("QPLUGIN_METRICS");
+    if (env != nullptr && *env != '\0' && *env != '0') {
+        s_enabled.store(true, std::memory_order_relaxed);
+    }
+}
+
+PluginMetrics::~PluginMetrics()
+{
+    stopDump();
+}
+
+PluginMetrics& PluginMetrics::Instance()
+{
+    static PluginMetrics instance;
+    return instance;
+}
+
+void PluginMetrics::setEnabled(bool on)
+{
+    Instance();
+    s_enabled.store(on, std::memory_order_relaxed);
+}
+
+template <typename T>
+T& PluginMetrics::ensure(GroupMap<T>& map, std::string_view group, std::string_view name)
+{
+    {
+        std::shared_lock lock(_mtx);
+        auto g = map.find(group);
+        if (g != map.end()) {
+            auto n = g->second.find(name);
+            if (n != g->second.end()) {
+                return *n->second;
+            }
+        }
+    }
+    std::unique_lock lock(_mtx);
+    auto& slot = map[std::string(group)][std::string(name)];
+    if (!slot) {
+        slot = std::make_unique<T>();
+    }
+    return *slot;
+}
+
+MetricCounter& PluginMetrics::counter(std::string_view group, std::string_view name)
+{
+    return ensure(_counters, group, name);
+}
+
+MetricHistogram& PluginMetrics::histogram(std::string_view group, std::string_view name)
+{
+    return ensure(_histograms, group, name);
+}
+
+MetricsSnapshot PluginMetrics::snapshot() const
+{
+    const auto keyOf = [](const std::string& group, const std::string& name) {
+        return name.empty() ? group : group + "/" + name;
+    };
+    MetricsSnapshot s;
+    std::shared_lock lock(_mtx);
+    for (const auto& [group, names] : _counters) {
+        for (const auto& [name, c] : names) {
+            s.counters.emplace(keyOf(group, name), c->value());
+        }
+    }
+    for (const auto& [group, names] : _histograms) {
+        for (const auto& [name, h] : names) {
+            s.histograms.emplace(keyOf(group, name), h->snapshot());
+        }
+    }
+    return s;
+}
+
+void PluginMetrics::reset()
+{
+    std::shared_lock lock(_mtx);
+    for (auto& [group, names] : _counters) {
+        for (auto& [name, c] : names) {
+            c->reset();
+        }
+    }
+    for (auto& [group, names] : _histograms) {
+        for (auto& [name, h] : names) {
+            h->reset();
+        }
+    }
+}
+
+void PluginMetrics::startDump(const QString& path, int msec)
+{
+    stopDump();
+    std::lock_guard lock(_dumpMtx);
+    _dumpStop = false;
+    _dumpPath = path;
+    _dumpMsec = msec;
+    _dumpThread = std::thread([this, path, msec]() {
+        std::unique_lock lock(_dumpMtx);
+        while (!_dumpStop) {
+            _dumpCv.wait_for(lock, std::chrono::milliseconds(msec), [this]() { return _dumpStop; });
+            lock.unlock();
+            QSaveFile file(path);
+            if (file.open(QIODevice::WriteOnly)) {
+                file.write(QJsonDocument(snapshot().toJson()).toJson());
+                file.commit();
+            }
+            lock.lock();
+        }
+    });
+}
+
+void PluginMetrics::stopDump()
+{
+    {
+        std::lock_guard lock(_dumpMtx);
+        _dumpStop = true;
+    }
+    _dumpCv.notify_all();
+    if (_dumpThread.joinable()) {
+        _dumpThread.join();
+    }
+}
+
+bool PluginMetrics::suspendDump()
+{
+    if (!_dumpThread.joinable()) {
+        return false;
+    }
+    stopDump();
+    return true;
+}
+
+void PluginMetrics::resumeDump()
+{
+    QString path;
+    int msec = 0;
+    {
+        std::lock_guard lock(_dumpMtx);
+        path = _dumpPath;
+        msec = _dumpMsec;
+    }
+    if (!path.isEmpty()) {
+        startDump(path, msec);
+    }
+}
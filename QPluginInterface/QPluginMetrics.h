@@ -0,0 +1,283 @@
+﻿#pragma once
+
+#include <QtCore/qglobal.h>
+
+#ifndef BUILD_STATIC
+#if defined(QPLUGININTERFACE_LIB)
+#define QPLUGININTERFACE_EXPORT Q_DECL_EXPORT
+#else
+#define QPLUGININTERFACE_EXPORT Q_DECL_IMPORT
+#endif
+#else
+#define QPLUGININTERFACE_EXPORT
+#endif
+
+#include <QString>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+QT_FORWARD_DECLARE_CLASS(QJsonObject)
+
+/**
+ * @brief 按线程分片的计数器，写入互不争用缓存行
+ */
+class QPLUGININTERFACE_EXPORT MetricCounter {
+public:
+    static constexpr std::size_t SHARDS = 16;
+
+    void add(std::uint64_t n = 1)
+    {
+        _shards[ShardIndex()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    std::uint64_t value() const;
+
+    void reset();
+
+private:
+    /**
+     * @brief 线程首次调用时按轮询分配分片
+     * @return
+     */
+    static std::size_t ShardIndex();
+
+    struct alignas(64) Shard {
+        std::atomic<std::uint64_t> value { 0 };
+    };
+    std::array<Shard, SHARDS> _shards;
+};
+
+/**
+ * @brief 直方图快照（单位纳秒）
+ */
+struct HistogramSnapshot {
+    std::uint64_t count = 0;
+    std::uint64_t sum = 0;
+    std::uint64_t min = 0;
+    std::uint64_t max = 0;
+    std::uint64_t p50 = 0;
+    std::uint64_t p90 = 0;
+    std::uint64_t p99 = 0;
+    std::uint64_t p999 = 0;
+};
+
+/**
+ * @brief HDR 风格对数-线性直方图：每个2的幂区间再分 8 档，相对误差不超过 12.5%
+ */
+class QPLUGININTERFACE_EXPORT MetricHistogram {
+public:
+    static constexpr int SUB_BITS = 3;
+    static constexpr std::size_t BUCKETS = 64 << SUB_BITS;
+
+    void record(std::uint64_t value);
+
+    HistogramSnapshot snapshot() const;
+
+    void reset();
+
+    /**
+     * @brief 累加另一直方图的计数，用于汇总各线程各自记录的直方图
+     * @param other
+     */
+    void merge(const MetricHistogram& other);
+
+    /**
+     * @brief 值所在桶下标
+     * @param value
+     * @return
+     */
+    static std::size_t BucketOf(std::uint64_t value);
+
+    /**
+     * @brief 桶的上界（含）
+     * @param index
+     * @return
+     */
+    static std::uint64_t BucketUpper(std::size_t index);
+
+private:
+    std::array<std::atomic<std::uint64_t>, BUCKETS> _buckets {};
+    std::atomic<std::uint64_t> _count { 0 };
+    std::atomic<std::uint64_t> _sum { 0 };
+    std::atomic<std::uint64_t> _min { std::numeric_limits<std::uint64_t>::max() };
+    std::atomic<std::uint64_t> _max { 0 };
+};
+
+/**
+ * @brief 全部指标快照，键为 "分组/名称"
+ */
+struct QPLUGININTERFACE_EXPORT MetricsSnapshot {
+    std::map<std::string, std::uint64_t> counters;
+    std::map<std::string, HistogramSnapshot> histograms;
+
+    QJsonObject toJson() const;
+};
+
+/**
+ * @brief 进程内指标注册表；关闭时各埋点只有一次原子读
+ */
+class QPLUGININTERFACE_EXPORT PluginMetrics {
+private:
+    PluginMetrics();
+
+public:
+    ~PluginMetrics();
+
+    static PluginMetrics& Instance();
+
+    /**
+     * @brief 是否采集（默认读取环境变量 QPLUGIN_METRICS）
+     * @return
+     */
+    static bool enabled()
+    {
+        return s_enabled.load(std::memory_order_relaxed);
+    }
+
+    static void setEnabled(bool on);
+
+    /**
+     * @brief 获取或创建计数器，返回的引用在进程内长期有效
+     * @param group 分组
+     * @param name 名称
+     * @return
+     */
+    MetricCounter& counter(std::string_view group, std::string_view name = {});
+
+    /**
+     * @brief 获取或创建直方图，返回的引用在进程内长期有效
+     * @param group 分组
+     * @param name 名称
+     * @return
+     */
+    MetricHistogram& histogram(std::string_view group, std::string_view name = {});
+
+    MetricsSnapshot snapshot() const;
+
+    /**
+     * @brief 清零所有指标（已缓存的引用仍然有效）
+     */
+    void reset();
+
+    /**
+     * @brief 后台线程周期性将快照写入 JSON 文件
+     * @param path 文件路径
+     * @param msec 间隔
+     */
+    void startDump(const QString& path, int msec);
+
+    void stopDump();
+
+    /**
+     * @brief 停止导出线程并保留参数，fork 之前调用
+     * @return 导出线程是否在运行
+     */
+    bool suspendDump();
+
+    /**
+     * @brief 以 startDump 的参数重新启动 suspendDump 停止的导出线程
+     */
+    void resumeDump();
+
+private:
+    struct StringHash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view s) const noexcept
+        {
+            return std::hash<std::string_view> {}(s);
+        }
+    };
+    template <typename T>
+    using NameMap = std::unordered_map<std::string, std::unique_ptr<T>, StringHash, std::equal_to<>>;
+    template <typename T>
+    using GroupMap = std::unordered_map<std::string, NameMap<T>, StringHash, std::equal_to<>>;
+
+    template <typename T>
+    T& ensure(GroupMap<T>& map, std::string_view group, std::string_view name);
+
+    static std::atomic_bool s_enabled;
+
+    mutable std::shared_mutex _mtx;
+    GroupMap<MetricCounter> _counters;
+    GroupMap<MetricHistogram> _histograms;
+
+    std::mutex _dumpMtx;
+    std::condition_variable _dumpCv;
+    std::thread _dumpThread;
+    bool _dumpStop = false;
+    QString _dumpPath;
+    int _dumpMsec = 0;
+};
+
+/**
+ * @brief 作用域计时，目标为空时不读时钟
+ */
+class MetricTimer {
+public:
+    explicit MetricTimer(MetricHistogram* histogram)
+        : _histogram(histogram)
+    {
+        if (_histogram) {
+            _start = std::chrono::steady_clock::now();
+        }
+    }
+
+    MetricTimer(const MetricTimer&) = delete;
+    MetricTimer& operator=(const MetricTimer&) = delete;
+
+    ~MetricTimer()
+    {
+        if (_histogram) {
+            _histogram->record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start).count());
+        }
+    }
+
+private:
+    MetricHistogram* _histogram = nullptr;
+    std::chrono::steady_clock::time_point _start;
+};
+
+/**
+ * @brief 开启时计数 +1；计数器在每个调用点首次执行时解析一次，GROUP、NAME 须为常量，
+ *        名称随调用变化的埋点自行缓存 counter() 返回的引用
+ */
+#ifndef PLUGIN_METRIC_COUNT
+#define PLUGIN_METRIC_COUNT(GROUP, NAME)                                                                  \
+    do {                                                                                                  \
+        if (PluginMetrics::enabled()) {                                                                   \
+            static auto& plugin_metric_counter = []() -> MetricCounter& {                                 \
+                return PluginMetrics::Instance().counter((GROUP), (NAME));                                \
+            }();                                                                                          \
+            plugin_metric_counter.add();                                                                  \
+        }                                                                                                 \
+    } while (0)
+#endif
+
+/**
+ * @brief 开启时对当前作用域计时；直方图在每个调用点首次执行时解析一次，GROUP、NAME 须为常量
+ */
+#ifndef PLUGIN_METRIC_TIME
+#define PLUGIN_METRIC_TIME_CONCAT_IMPL(a, b) a##b
+#define PLUGIN_METRIC_TIME_CONCAT(a, b) PLUGIN_METRIC_TIME_CONCAT_IMPL(a, b)
+#define PLUGIN_METRIC_TIME(GROUP, NAME)                                            \
+    MetricTimer PLUGIN_METRIC_TIME_CONCAT(metric_timer_, __LINE__)(               \
+        PluginMetrics::enabled()                                                   \
+            ? []() -> MetricHistogram* {                                           \
+                  static auto& histogram = PluginMetrics::Instance().histogram((GROUP), (NAME)); \
+                  return &histogram;                                               \
+              }()                                                                  \
+            : nullptr)
+#endif
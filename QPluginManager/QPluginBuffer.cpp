@@ -0,0 +1,354 @@
+﻿#include "QPluginBuffer.h"
+
+#include <QJsonArray>
+
+#include <algorithm>
+#include <bit>
+#include <new>
+
+#if defined(Q_OS_LINUX)
+#include <sys/mman.h>
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#include <Windows.h>
+#endif
+
+namespace {
+constexpr std::size_t BLOCK_ALIGN = 64;
+
+const char* backingName(PluginBufferBacking backing)
+{
+    return backing == PluginBufferBacking::SharedMemory ? "shm" : "heap";
+}
+
+/**
+ * @brief 申请块内存，共享内存不可用时退回堆
+ * @param block 已设置 capacity 与 backing
+ * @return 是否成功
+ */
+bool mapBlock(PluginBufferBlock* block)
+{
+    if (block->backing == PluginBufferBacking::SharedMemory) {
+#if defined(Q_OS_LINUX) && defined(MFD_CLOEXEC)
+        const int fd = memfd_create("qplugin-buffer", MFD_CLOEXEC);
+        if (fd >= 0) {
+            if (ftruncate(fd, static_cast<off_t>(block->capacity)) == 0) {
+                void* p = mmap(nullptr, block->capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                if (p != MAP_FAILED) {
+                    block->data = static_cast<char*>(p);
+                    block->handle = fd;
+                    return true;
+                }
+            }
+            close(fd);
+        }
+#elif defined(Q_OS_WIN)
+        const auto size = static_cast<std::uint64_t>(block->capacity);
+        HANDLE mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), nullptr);
+        if (mapping != nullptr) {
+            if (void* p = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, block->capacity)) {
+                block->data = static_cast<char*>(p);
+                block->handle = reinterpret_cast<qintptr>(mapping);
+                return true;
+            }
+            CloseHandle(mapping);
+        }
+#endif
+        block->backing = PluginBufferBacking::Heap;
+    }
+    block->data = static_cast<char*>(::operator new(block->capacity, std::align_val_t(BLOCK_ALIGN), std::nothrow));
+    block->handle = -1;
+    return block->data != nullptr;
+}
+
+void unmapBlock(PluginBufferBlock* block)
+{
+    if (block->data == nullptr) {
+        return;
+    }
+    if (block->handle == -1) {
+        ::operator delete(block->data, std::align_val_t(BLOCK_ALIGN));
+    } else {
+#if defined(Q_OS_LINUX)
+        munmap(block->data, block->capacity);
+        close(static_cast<int>(block->handle));
+#elif defined(Q_OS_WIN)
+        UnmapViewOfFile(block->data);
+        CloseHandle(reinterpret_cast<HANDLE>(block->handle));
+#endif
+    }
+    block->data = nullptr;
+    block->handle = -1;
+}
+}
+
+/**
+ * @brief 池的共享状态，池与全部在外的块共同持有
+ */
+class PluginBufferPoolCore {
+public:
+    struct SizeClass {
+        std::mutex mtx;
+        std::vector<PluginBufferBlock*> free;
+        std::atomic<std::uint64_t> allocations { 0 };
+        std::atomic<std::uint64_t> hits { 0 };
+        std::atomic_size_t inUse { 0 };
+    };
+
+    ~PluginBufferPoolCore()
+    {
+        trim();
+    }
+
+    SizeClass& at(PluginBufferBacking backing, std::size_t index)
+    {
+        return classes[static_cast<std::size_t>(backing)][index];
+    }
+
+    void trim()
+    {
+        for (auto&& row : classes) {
+            for (auto&& sizeClass : row) {
+                std::vector<PluginBufferBlock*> blocks;
+                {
+                    std::lock_guard lock(sizeClass.mtx);
+                    blocks.swap(sizeClass.free);
+                }
+                for (auto&& block : blocks) {
+                    unmapBlock(block);
+                    delete block;
+                }
+            }
+        }
+    }
+
+    std::array<std::array<SizeClass, PluginBufferPool::CLASSES>, 2> classes;
+    std::atomic_size_t maxCached { 8 };
+    std::atomic<std::uint64_t> oversized { 0 };
+};
+
+QJsonObject PluginBufferStats::toJson() const
+{
+    QJsonArray classList;
+    for (auto&& c : classes) {
+        QJsonObject obj;
+        obj.insert("blockSize", static_cast<qint64>(c.blockSize));
+        obj.insert("backing", backingName(c.backing));
+        obj.insert("allocations", static_cast<qint64>(c.allocations));
+        obj.insert("hits", static_cast<qint64>(c.hits));
+        obj.insert("inUse", static_cast<qint64>(c.inUse));
+        obj.insert("cached", static_cast<qint64>(c.cached));
+        classList.append(obj);
+    }
+    QJsonArray channelList;
+    for (auto&& c : channels) {
+        QJsonObject obj;
+        obj.insert("name", QString::fromStdString(c.name));
+        obj.insert("capacity", static_cast<qint64>(c.capacity));
+        obj.insert("depth", static_cast<qint64>(c.depth));
+        obj.insert("highWater", static_cast<qint64>(c.highWater));
+        obj.insert("pushed", static_cast<qint64>(c.pushed));
+        obj.insert("popped", static_cast<qint64>(c.popped));
+        obj.insert("rejected", static_cast<qint64>(c.rejected));
+        channelList.append(obj);
+    }
+    QJsonObject obj;
+    obj.insert("classes", classList);
+    obj.insert("channels", channelList);
+    obj.insert("oversized", static_cast<qint64>(oversized));
+    obj.insert("bytesInUse", static_cast<qint64>(bytesInUse));
+    obj.insert("bytesCached", static_cast<qint64>(bytesCached));
+    return obj;
+}
+
+void PluginBuffer::reset()
+{
+    if (_block && _block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        PluginBufferPool::recycle(_block);
+    }
+    _block = nullptr;
+}
+
+PluginBufferPool::PluginBufferPool(std::size_t maxCached)
+    : _core(std::make_shared<PluginBufferPoolCore>())
+{
+    _core->maxCached.store(maxCached, std::memory_order_relaxed);
+}
+
+PluginBufferPool::~PluginBufferPool() { }
+
+std::size_t PluginBufferPool::classOf(std::size_t size)
+{
+    if (size <= (std::size_t(1) << MIN_CLASS_BITS)) {
+        return 0;
+    }
+    const auto bits = static_cast<std::size_t>(std::bit_width(size - 1));
+    return std::min(bits - MIN_CLASS_BITS, CLASSES);
+}
+
+PluginBuffer PluginBufferPool::allocate(std::size_t size, PluginBufferBacking backing)
+{
+    const auto index = classOf(size);
+    PluginBufferBlock* block = nullptr;
+    if (index < CLASSES) {
+        {
+            auto&& requested = _core->at(backing, index);
+            std::lock_guard lock(requested.mtx);
+            if (!requested.free.empty()) {
+                block = requested.free.back();
+                requested.free.pop_back();
+            }
+        }
+        const bool hit = block != nullptr;
+        if (!hit) {
+            block = new PluginBufferBlock();
+            block->sizeClass = static_cast<int>(index);
+            block->backing = backing;
+            block->capacity = std::size_t(1) << (MIN_CLASS_BITS + index);
+            if (!mapBlock(block)) {
+                delete block;
+                return PluginBuffer();
+            }
+        }
+        // 共享内存不可用时块退回堆，各项计数都记在实际来源的尺寸档上
+        auto&& sizeClass = _core->at(block->backing, index);
+        sizeClass.allocations.fetch_add(1, std::memory_order_relaxed);
+        if (hit) {
+            sizeClass.hits.fetch_add(1, std::memory_order_relaxed);
+        }
+        sizeClass.inUse.fetch_add(1, std::memory_order_relaxed);
+        block->refs.store(1, std::memory_order_relaxed);
+    } else {
+        _core->oversized.fetch_add(1, std::memory_order_relaxed);
+        block = new PluginBufferBlock();
+        block->backing = backing;
+        block->capacity = size;
+        if (!mapBlock(block)) {
+            delete block;
+            return PluginBuffer();
+        }
+    }
+    block->size = size;
+    block->pool = _core;
+    return PluginBuffer(block);
+}
+
+void PluginBufferPool::recycle(PluginBufferBlock* block)
+{
+    // 先取出池引用，块归还后可能立即被其他线程复用
+    auto core = std::move(block->pool);
+    if (block->sizeClass >= 0 && core) {
+        auto&& sizeClass = core->at(block->backing, static_cast<std::size_t>(block->sizeClass));
+        sizeClass.inUse.fetch_sub(1, std::memory_order_relaxed);
+        std::unique_lock lock(sizeClass.mtx);
+        if (sizeClass.free.size() < core->maxCached.load(std::memory_order_relaxed)) {
+            block->size = 0;
+            sizeClass.free.push_back(block);
+            return;
+        }
+    }
+    unmapBlock(block);
+    delete block;
+}
+
+void PluginBufferPool::setMaxCached(std::size_t count)
+{
+    _core->maxCached.store(count, std::memory_order_relaxed);
+}
+
+void PluginBufferPool::trim()
+{
+    _core->trim();
+}
+
+std::vector<PluginBufferClassStats> PluginBufferPool::stats() const
+{
+    std::vector<PluginBufferClassStats> out;
+    for (auto backing : { PluginBufferBacking::Heap, PluginBufferBacking::SharedMemory }) {
+        for (std::size_t i = 0; i < CLASSES; i++) {
+            auto&& sizeClass = _core->at(backing, i);
+            PluginBufferClassStats s;
+            s.allocations = sizeClass.allocations.load(std::memory_order_relaxed);
+            s.inUse = sizeClass.inUse.load(std::memory_order_relaxed);
+            {
+                std::lock_guard lock(sizeClass.mtx);
+                s.cached = sizeClass.free.size();
+            }
+            if (s.allocations == 0 && s.inUse == 0 && s.cached == 0) {
+                continue;
+            }
+            s.blockSize = std::size_t(1) << (MIN_CLASS_BITS + i);
+            s.backing = backing;
+            s.hits = sizeClass.hits.load(std::memory_order_relaxed);
+            out.push_back(s);
+        }
+    }
+    return out;
+}
+
+std::uint64_t PluginBufferPool::oversized() const
+{
+    return _core->oversized.load(std::memory_order_relaxed);
+}
+
+PluginBufferChannel::PluginBufferChannel(std::string name, std::size_t capacity)
+    : _name(std::move(name))
+    , _ring(capacity)
+{
+}
+
+PluginBufferChannelStats PluginBufferChannel::stats() const
+{
+    PluginBufferChannelStats s;
+    s.name = _name;
+    s.capacity = _ring.capacity();
+    s.depth = _ring.size();
+    s.highWater = _highWater.load(std::memory_order_relaxed);
+    s.pushed = _pushed.load(std::memory_order_relaxed);
+    s.popped = _popped.load(std::memory_order_relaxed);
+    s.rejected = _rejected.load(std::memory_order_relaxed);
+    return s;
+}
+
+PluginBufferService::PluginBufferService()
+{
+    qRegisterMetaType<PluginBuffer>("PluginBuffer");
+}
+
+PluginBufferService::~PluginBufferService() { }
+
+PluginBufferPool& PluginBufferService::pool()
+{
+    return _pool;
+}
+
+PluginBuffer PluginBufferService::allocate(std::size_t size, PluginBufferBacking backing)
+{
+    return _pool.allocate(size, backing);
+}
+
+std::shared_ptr<PluginBufferChannel> PluginBufferService::channel(std::string_view name, std::size_t capacity)
+{
+    std::lock_guard lock(_mtx);
+    auto&& slot = _channels[std::string(name)];
+    if (!slot) {
+        slot = std::make_shared<PluginBufferChannel>(std::string(name), capacity);
+    }
+    return slot;
+}
+
+PluginBufferStats PluginBufferService::stats() const
+{
+    PluginBufferStats s;
+    s.classes = _pool.stats();
+    s.oversized = _pool.oversized();
+    for (auto&& c : s.classes) {
+        s.bytesInUse += c.inUse * c.blockSize;
+        s.bytesCached += c.cached * c.blockSize;
+    }
+    std::lock_guard lock(_mtx);
+    for (auto&& [name, channel] : _channels) {
+        s.channels.push_back(channel->stats());
+    }
+    return s;
+}
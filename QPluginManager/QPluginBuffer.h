@@ -0,0 +1,446 @@
+﻿#pragma once
+
+#include <QtCore/qglobal.h>
+
+#ifndef BUILD_STATIC
+#if defined(QPLUGINMANAGER_LIB)
+#define QPLUGINMANAGER_EXPORT Q_DECL_EXPORT
+#else
+#define QPLUGINMANAGER_EXPORT Q_DECL_IMPORT
+#endif
+#else
+#define QPLUGINMANAGER_EXPORT
+#endif
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QMetaType>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "QPluginEventBus.h"
+
+/**
+ * @brief 缓冲区内存来源
+ */
+enum class PluginBufferBacking {
+    /**
+     * @brief 进程堆，按缓存行对齐
+     */
+    Heap,
+    /**
+     * @brief 匿名共享内存（Linux memfd，Windows 页文件映射），可把 nativeHandle 传给其他进程映射；不支持时退回堆
+     */
+    SharedMemory,
+};
+
+class PluginBufferPoolCore;
+
+/**
+ * @brief 缓冲区块：计数与数据指针，由池分配并回收
+ */
+struct PluginBufferBlock {
+    std::atomic<std::uint32_t> refs { 1 };
+    /**
+     * @brief 尺寸档下标，超出最大档时为 -1（不缓存）
+     */
+    int sizeClass = -1;
+    PluginBufferBacking backing = PluginBufferBacking::Heap;
+    std::size_t capacity = 0;
+    std::size_t size = 0;
+    char* data = nullptr;
+    /**
+     * @brief 共享内存的 fd / HANDLE，堆内存为 -1
+     */
+    qintptr handle = -1;
+    /**
+     * @brief 块持有池，池在最后一个块归还后析构
+     */
+    std::shared_ptr<PluginBufferPoolCore> pool;
+};
+
+/**
+ * @brief 引用计数的缓冲区句柄：复制只增加计数，移动转移所有权，均不复制数据；最后一个句柄析构时归还到池
+ */
+class QPLUGINMANAGER_EXPORT PluginBuffer {
+public:
+    PluginBuffer() = default;
+
+    PluginBuffer(const PluginBuffer& other) noexcept
+        : _block(other._block)
+    {
+        if (_block) {
+            _block->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    PluginBuffer(PluginBuffer&& other) noexcept
+        : _block(std::exchange(other._block, nullptr))
+    {
+    }
+
+    PluginBuffer& operator=(const PluginBuffer& other) noexcept
+    {
+        if (this != &other) {
+            PluginBuffer(other).swap(*this);
+        }
+        return *this;
+    }
+
+    PluginBuffer& operator=(PluginBuffer&& other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            _block = std::exchange(other._block, nullptr);
+        }
+        return *this;
+    }
+
+    ~PluginBuffer()
+    {
+        reset();
+    }
+
+    void swap(PluginBuffer& other) noexcept
+    {
+        std::swap(_block, other._block);
+    }
+
+    /**
+     * @brief 放弃本句柄持有的引用
+     */
+    void reset();
+
+    bool isNull() const
+    {
+        return _block == nullptr;
+    }
+
+    explicit operator bool() const
+    {
+        return _block != nullptr;
+    }
+
+    char* data()
+    {
+        return _block ? _block->data : nullptr;
+    }
+
+    const char* data() const
+    {
+        return _block ? _block->data : nullptr;
+    }
+
+    /**
+     * @brief 有效数据长度
+     */
+    std::size_t size() const
+    {
+        return _block ? _block->size : 0;
+    }
+
+    /**
+     * @brief 设置有效数据长度，不超过 capacity
+     * @param size
+     */
+    void setSize(std::size_t size)
+    {
+        if (_block) {
+            _block->size = size < _block->capacity ? size : _block->capacity;
+        }
+    }
+
+    /**
+     * @brief 块容量，即所在尺寸档的大小
+     */
+    std::size_t capacity() const
+    {
+        return _block ? _block->capacity : 0;
+    }
+
+    /**
+     * @brief 是否只有本句柄持有；共享中的缓冲区按约定只读
+     */
+    bool isUnique() const
+    {
+        return _block && _block->refs.load(std::memory_order_acquire) == 1;
+    }
+
+    PluginBufferBacking backing() const
+    {
+        return _block ? _block->backing : PluginBufferBacking::Heap;
+    }
+
+    /**
+     * @brief 共享内存的 fd（Linux）或 HANDLE（Windows），堆内存为 -1
+     */
+    qintptr nativeHandle() const
+    {
+        return _block ? _block->handle : -1;
+    }
+
+    /**
+     * @brief 不复制数据的 QByteArray 视图，仅在本句柄存活期间有效
+     * @return 长度超出 QByteArray 上限（Qt5 为 2 GiB）时为空，此时使用 span
+     */
+    QByteArray view() const
+    {
+        using Size = decltype(QByteArray().size());
+        if (_block == nullptr || _block->size > static_cast<std::size_t>(std::numeric_limits<Size>::max())) {
+            return QByteArray();
+        }
+        return QByteArray::fromRawData(_block->data, static_cast<Size>(_block->size));
+    }
+
+    /**
+     * @brief 不限长度的只读视图，仅在本句柄存活期间有效
+     * @return
+     */
+    std::span<const char> span() const
+    {
+        return _block ? std::span<const char>(_block->data, _block->size) : std::span<const char>();
+    }
+
+private:
+    friend class PluginBufferPool;
+    explicit PluginBuffer(PluginBufferBlock* block)
+        : _block(block)
+    {
+    }
+
+    PluginBufferBlock* _block = nullptr;
+};
+
+Q_DECLARE_METATYPE(PluginBuffer)
+
+/**
+ * @brief 单个尺寸档计数
+ */
+struct PluginBufferClassStats {
+    std::size_t blockSize = 0;
+    PluginBufferBacking backing = PluginBufferBacking::Heap;
+    std::uint64_t allocations = 0;
+    /**
+     * @brief 从空闲链表取得（未向系统申请）的次数
+     */
+    std::uint64_t hits = 0;
+    std::size_t inUse = 0;
+    std::size_t cached = 0;
+};
+
+/**
+ * @brief 单条通道计数
+ */
+struct PluginBufferChannelStats {
+    std::string name;
+    std::size_t capacity = 0;
+    std::size_t depth = 0;
+    std::size_t highWater = 0;
+    std::uint64_t pushed = 0;
+    std::uint64_t popped = 0;
+    /**
+     * @brief 通道满时被拒绝的次数
+     */
+    std::uint64_t rejected = 0;
+};
+
+/**
+ * @brief 缓冲区服务统计
+ */
+struct QPLUGINMANAGER_EXPORT PluginBufferStats {
+    /**
+     * @brief 有过分配的尺寸档
+     */
+    std::vector<PluginBufferClassStats> classes;
+    std::vector<PluginBufferChannelStats> channels;
+    /**
+     * @brief 超出最大档、直接向系统申请的次数
+     */
+    std::uint64_t oversized = 0;
+    std::size_t bytesInUse = 0;
+    std::size_t bytesCached = 0;
+
+    QJsonObject toJson() const;
+};
+
+/**
+ * @brief 按 2 的幂尺寸档（4 KiB 起）缓存的缓冲区池，每档一条空闲链表，归还的块直接复用
+ */
+class QPLUGINMANAGER_EXPORT PluginBufferPool {
+public:
+    /**
+     * @brief 最小档 4 KiB
+     */
+    static constexpr std::size_t MIN_CLASS_BITS = 12;
+    /**
+     * @brief 档数，最大档 128 MiB
+     */
+    static constexpr std::size_t CLASSES = 16;
+
+    /**
+     * @param maxCached 每档保留的空闲块上限，超出时直接释放
+     */
+    explicit PluginBufferPool(std::size_t maxCached = 8);
+    ~PluginBufferPool();
+
+    PluginBufferPool(const PluginBufferPool&) = delete;
+    PluginBufferPool& operator=(const PluginBufferPool&) = delete;
+
+    /**
+     * @brief 分配缓冲区，容量向上取整到尺寸档，有效长度为 size
+     * @param size 字节数
+     * @param backing 内存来源
+     * @return 申请失败时为空
+     */
+    PluginBuffer allocate(std::size_t size, PluginBufferBacking backing = PluginBufferBacking::Heap);
+
+    /**
+     * @brief 每档保留的空闲块上限
+     * @param count
+     */
+    void setMaxCached(std::size_t count);
+
+    /**
+     * @brief 释放全部空闲块
+     */
+    void trim();
+
+    /**
+     * @brief 有过分配的尺寸档计数
+     * @return
+     */
+    std::vector<PluginBufferClassStats> stats() const;
+
+    /**
+     * @brief 超出最大档的分配次数
+     */
+    std::uint64_t oversized() const;
+
+    /**
+     * @brief 尺寸档下标
+     * @param size
+     * @return 超出最大档时为 CLASSES
+     */
+    static std::size_t classOf(std::size_t size);
+
+private:
+    friend class PluginBuffer;
+    static void recycle(PluginBufferBlock* block);
+
+    std::shared_ptr<PluginBufferPoolCore> _core;
+};
+
+/**
+ * @brief 生产者/消费者通道：传递缓冲区句柄，不复制数据；多生产者，单消费者
+ */
+class QPLUGINMANAGER_EXPORT PluginBufferChannel {
+public:
+    /**
+     * @param name 通道名
+     * @param capacity 容量，向上取整为 2 的幂
+     */
+    PluginBufferChannel(std::string name, std::size_t capacity);
+
+    PluginBufferChannel(const PluginBufferChannel&) = delete;
+    PluginBufferChannel& operator=(const PluginBufferChannel&) = delete;
+
+    /**
+     * @brief 放入缓冲区，成功时转移句柄所有权（任意线程）
+     * @param buffer
+     * @return 通道已满返回 false，buffer 保持不变
+     */
+    bool push(PluginBuffer&& buffer)
+    {
+        if (!_ring.tryPush(std::move(buffer))) {
+            _rejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        _pushed.fetch_add(1, std::memory_order_relaxed);
+        const auto depth = _ring.size();
+        auto hw = _highWater.load(std::memory_order_relaxed);
+        while (depth > hw && !_highWater.compare_exchange_weak(hw, depth, std::memory_order_relaxed)) { }
+        return true;
+    }
+
+    /**
+     * @brief 取出缓冲区（仅消费者线程）
+     * @param out
+     * @return 通道为空返回 false
+     */
+    bool pop(PluginBuffer& out)
+    {
+        if (!_ring.tryPop(out)) {
+            return false;
+        }
+        _popped.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    const std::string& name() const
+    {
+        return _name;
+    }
+
+    PluginBufferChannelStats stats() const;
+
+private:
+    std::string _name;
+    MpscRing<PluginBuffer> _ring;
+    std::atomic<std::uint64_t> _pushed { 0 };
+    std::atomic<std::uint64_t> _popped { 0 };
+    std::atomic<std::uint64_t> _rejected { 0 };
+    std::atomic_size_t _highWater { 0 };
+};
+
+/**
+ * @brief 插件间零拷贝缓冲区服务，由插件管理器提供：共享的缓冲区池与按名称获取的通道。
+ *        缓冲区句柄也可作为事件总线消息或 Qt 信号参数传递
+ */
+class QPLUGINMANAGER_EXPORT PluginBufferService {
+public:
+    PluginBufferService();
+    ~PluginBufferService();
+
+    PluginBufferService(const PluginBufferService&) = delete;
+    PluginBufferService& operator=(const PluginBufferService&) = delete;
+
+    PluginBufferPool& pool();
+
+    /**
+     * @brief 分配缓冲区，等同 pool().allocate
+     * @param size
+     * @param backing
+     * @return
+     */
+    PluginBuffer allocate(std::size_t size, PluginBufferBacking backing = PluginBufferBacking::Heap);
+
+    /**
+     * @brief 获取或创建通道
+     * @param name 通道名
+     * @param capacity 创建时的容量，已存在时忽略
+     * @return
+     */
+    std::shared_ptr<PluginBufferChannel> channel(std::string_view name, std::size_t capacity = 256);
+
+    /**
+     * @brief 池与全部通道的计数
+     * @return
+     */
+    PluginBufferStats stats() const;
+
+private:
+    PluginBufferPool _pool;
+    mutable std::mutex _mtx;
+    std::unordered_map<std::string, std::shared_ptr<PluginBufferChannel>> _channels;
+};
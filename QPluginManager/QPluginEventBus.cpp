@@ -0,0 +1,44 @@
+﻿#include "QPluginEventBus.h"
+
+#include "QPluginLogging.h"
+
+QPluginEventBus::QPluginEventBus() { }
+QPluginEventBus::~QPluginEventBus() { }
+
+std::vector<EventTopicStats> QPluginEventBus::stats() const
+{
+    std::shared_lock lock(_mtx);
+    std::vector<EventTopicStats> out;
+    out.reserve(_topics.size());
+    for (const auto& [name, t] : _topics) {
+        out.push_back(t->stats());
+    }
+    return out;
+}
+
+std::shared_ptr<EventTopicBase> QPluginEventBus::ensureTopic(std::string_view name, const char* typeKey, const std::function<std::shared_ptr<EventTopicBase>()>& factory)
+{
+    const std::string key(name);
+    {
+        std::shared_lock lock(_mtx);
+        auto it = _topics.find(key);
+        if (it != _topics.end()) {
+            if (it->second->typeKey() != typeKey) {
+                qCWarning(lcPluginManager) << "主题类型不一致:" << key.c_str() << it->second->typeKey().c_str() << typeKey;
+                return nullptr;
+            }
+            return it->second;
+        }
+    }
+    std::unique_lock lock(_mtx);
+    auto& slot = _topics[key];
+    if (!slot) {
+        slot = factory();
+        slot->_name = key;
+        slot->_typeKey = typeKey;
+    } else if (slot->typeKey() != typeKey) {
+        qCWarning(lcPluginManager) << "主题类型不一致:" << key.c_str() << slot->typeKey().c_str() << typeKey;
+        return nullptr;
+    }
+    return slot;
+}
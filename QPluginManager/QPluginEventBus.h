@@ -0,0 +1,654 @@
+﻿#pragma once
+
+#include <QtCore/qglobal.h>
+
+#ifndef BUILD_STATIC
+#if defined(QPLUGINMANAGER_LIB)
+#define QPLUGINMANAGER_EXPORT Q_DECL_EXPORT
+#else
+#define QPLUGINMANAGER_EXPORT Q_DECL_IMPORT
+#endif
+#else
+#define QPLUGINMANAGER_EXPORT
+#endif
+
+#include <QObject>
+#include <QPointer>
+#include <QThread>
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "AutoRegistered.h"
+
+/**
+ * @brief 订阅队列满时的背压策略
+ */
+enum class BackPressure {
+    /**
+     * @brief 丢弃本条消息并计数
+     */
+    DropNewest,
+    /**
+     * @brief 发布者阻塞等待消费者腾出空位（订阅者与发布者同线程时就地投递），最长等待 blockTimeout；
+     *        超时、context 已销毁或其线程没有事件循环时按 DropNewest 丢弃
+     */
+    Block,
+    /**
+     * @brief 拒绝本条消息，由 publish 返回值告知发布者
+     */
+    Reject,
+};
+
+/**
+ * @brief 订阅参数
+ */
+struct EventSubscribeOptions {
+    /**
+     * @brief 队列容量，向上取整为2的幂
+     */
+    std::size_t capacity = 1024;
+    /**
+     * @brief 单次投递的最大消息数
+     */
+    std::size_t batch = 64;
+    BackPressure policy = BackPressure::DropNewest;
+    /**
+     * @brief Block 策略下单条消息的最长等待时间
+     */
+    std::chrono::milliseconds blockTimeout { 100 };
+};
+
+/**
+ * @brief 单个订阅者计数
+ */
+struct EventSubscriberStats {
+    std::size_t depth = 0;
+    std::size_t capacity = 0;
+    std::size_t highWater = 0;
+    std::uint64_t delivered = 0;
+    std::uint64_t dropped = 0;
+    std::uint64_t batches = 0;
+};
+
+/**
+ * @brief 主题计数
+ */
+struct EventTopicStats {
+    std::string name;
+    std::string typeKey;
+    std::uint64_t published = 0;
+    std::vector<EventSubscriberStats> subscribers;
+};
+
+/**
+ * @brief 有界多生产者单消费者环形队列（Vyukov 序号槽算法）
+ * @tparam T 元素类型，需可默认构造
+ */
+template <typename T>
+class MpscRing {
+public:
+    explicit MpscRing(std::size_t capacity)
+    {
+        std::size_t cap = 2;
+        while (cap < capacity) {
+            cap <<= 1;
+        }
+        _mask = cap - 1;
+        _cells = std::make_unique<Cell[]>(cap);
+        for (std::size_t i = 0; i < cap; ++i) {
+            _cells[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief 入队（任意线程）
+     * @param value
+     * @return 队列已满返回 false
+     */
+    template <typename U>
+    bool tryPush(U&& value)
+    {
+        Cell* cell = nullptr;
+        auto pos = _head.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &_cells[pos & _mask];
+            const auto seq = cell->seq.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = _head.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::forward<U>(value);
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 出队（仅消费者线程）
+     * @param out
+     * @return 队列为空返回 false
+     */
+    bool tryPop(T& out)
+    {
+        const auto pos = _tail.load(std::memory_order_relaxed);
+        auto& cell = _cells[pos & _mask];
+        if (cell.seq.load(std::memory_order_acquire) != pos + 1) {
+            return false;
+        }
+        out = std::move(cell.value);
+        cell.seq.store(pos + _mask + 1, std::memory_order_release);
+        _tail.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    std::size_t size() const
+    {
+        const auto tail = _tail.load(std::memory_order_acquire);
+        const auto head = _head.load(std::memory_order_acquire);
+        return head > tail ? head - tail : 0;
+    }
+
+    std::size_t capacity() const
+    {
+        return _mask + 1;
+    }
+
+private:
+    struct Cell {
+        std::atomic_size_t seq { 0 };
+        T value {};
+    };
+
+    std::unique_ptr<Cell[]> _cells;
+    std::size_t _mask = 0;
+    alignas(64) std::atomic_size_t _head { 0 };
+    alignas(64) std::atomic_size_t _tail { 0 };
+};
+
+/**
+ * @brief 订阅者公共部分（计数与生命周期）
+ */
+class EventSubscriberBase {
+public:
+    virtual ~EventSubscriberBase() = default;
+
+    /**
+     * @brief 消费队列中的消息；同一时刻只能有一个线程消费，消费线程内可重入
+     * @param max 最多处理条数
+     * @return 实际处理条数，其他线程正在消费时为 0
+     */
+    virtual std::size_t drain(std::size_t max) = 0;
+
+    virtual EventSubscriberStats stats() const = 0;
+
+    void deactivate()
+    {
+        _active.store(false, std::memory_order_release);
+        wakePublishers();
+    }
+
+    bool isActive() const
+    {
+        return _active.load(std::memory_order_acquire);
+    }
+
+protected:
+    /**
+     * @brief 唤醒 Block 策略下等待空位的发布者；与等待侧的计数递增构成 Dekker 式配对，出队后调用
+     */
+    void wakePublishers()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (_waiters.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+        {
+            // 空临界区：等待者检查条件与进入等待之间不会错过通知
+            std::lock_guard lock(_spaceMtx);
+        }
+        _space.notify_all();
+    }
+
+    std::atomic_bool _active { true };
+    std::atomic_bool _scheduled { false };
+    /**
+     * @brief 正在消费的线程，空闲时为默认值
+     */
+    std::atomic<std::thread::id> _consumer {};
+    std::atomic_int _waiters { 0 };
+    std::mutex _spaceMtx;
+    std::condition_variable _space;
+    std::atomic<std::uint64_t> _delivered { 0 };
+    std::atomic<std::uint64_t> _dropped { 0 };
+    std::atomic<std::uint64_t> _batches { 0 };
+    std::atomic_size_t _highWater { 0 };
+};
+
+/**
+ * @brief 类型化订阅者：每个订阅者独占一条 MPSC 队列，按批投递到 context 所在线程
+ * @tparam T 消息类型
+ */
+template <typename T>
+class EventSubscriber final : public EventSubscriberBase, public std::enable_shared_from_this<EventSubscriber<T>> {
+public:
+    using Handler = std::function<void(const T&)>;
+
+    EventSubscriber(QObject* context, Handler handler, const EventSubscribeOptions& options)
+        : _ring(options.capacity)
+        , _handler(std::move(handler))
+        , _context(context)
+        , _polled(context == nullptr)
+        , _batch(options.batch == 0 ? 1 : options.batch)
+        , _policy(options.policy)
+        , _blockTimeout(options.blockTimeout)
+    {
+    }
+
+    /**
+     * @brief 发布侧入队
+     * @param value
+     * @return 是否被接收
+     */
+    bool offer(const T& value)
+    {
+        if (!isActive()) {
+            return false;
+        }
+        std::chrono::steady_clock::time_point deadline {};
+        while (!_ring.tryPush(value)) {
+            if (!isActive()) {
+                return false;
+            }
+            if (_policy != BackPressure::Block || !waitForSpace(deadline)) {
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+        const auto depth = _ring.size();
+        auto hw = _highWater.load(std::memory_order_relaxed);
+        while (depth > hw && !_highWater.compare_exchange_weak(hw, depth, std::memory_order_relaxed)) { }
+        schedule();
+        return true;
+    }
+
+    std::size_t drain(std::size_t max) override
+    {
+        // 单消费者：最外层调用登记当前线程；处理函数中阻塞发布触发的就地投递在同一线程内重入
+        const auto self = std::this_thread::get_id();
+        auto owner = std::thread::id {};
+        const bool outermost = _consumer.compare_exchange_strong(owner, self, std::memory_order_acquire, std::memory_order_relaxed);
+        assert((outermost || owner == self) && "EventSubscriber::drain: 多个线程同时消费同一订阅");
+        if (!outermost && owner != self) {
+            return 0;
+        }
+        std::size_t n = 0;
+        T value {};
+        while (n < max && _ring.tryPop(value)) {
+            if (isActive()) {
+                _handler(value);
+            }
+            ++n;
+        }
+        if (n > 0) {
+            _delivered.fetch_add(n, std::memory_order_relaxed);
+            _batches.fetch_add(1, std::memory_order_relaxed);
+            wakePublishers();
+        }
+        if (outermost) {
+            _consumer.store(std::thread::id {}, std::memory_order_release);
+        }
+        return n;
+    }
+
+    EventSubscriberStats stats() const override
+    {
+        EventSubscriberStats s;
+        s.depth = _ring.size();
+        s.capacity = _ring.capacity();
+        s.highWater = _highWater.load(std::memory_order_relaxed);
+        s.delivered = _delivered.load(std::memory_order_relaxed);
+        s.dropped = _dropped.load(std::memory_order_relaxed);
+        s.batches = _batches.load(std::memory_order_relaxed);
+        return s;
+    }
+
+private:
+    /**
+     * @brief Block 策略下等待一轮空位
+     * @param deadline 首次调用时设置
+     * @return 不会再有空位或已超时返回 false
+     */
+    bool waitForSpace(std::chrono::steady_clock::time_point& deadline)
+    {
+        if (!_polled) {
+            QObject* ctx = _context.data();
+            // 投递目标已销毁或所在线程没有事件循环，队列不会被消费
+            if (ctx == nullptr) {
+                return false;
+            }
+            // 订阅者在当前线程时等待会死锁，就地投递一批腾出空位
+            if (ctx->thread() == QThread::currentThread()) {
+                drain(_batch);
+                return true;
+            }
+            if (ctx->thread()->eventDispatcher() == nullptr) {
+                return false;
+            }
+        }
+        const auto now = std::chrono::steady_clock::now();
+        if (deadline == std::chrono::steady_clock::time_point {}) {
+            deadline = now + _blockTimeout;
+        } else if (now >= deadline) {
+            return false;
+        }
+        // 先登记再检查队列，消费者出队后看到登记即唤醒；满队列时睡眠到出队或超时
+        _waiters.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        {
+            std::unique_lock lock(_spaceMtx);
+            _space.wait_until(lock, deadline, [this]() { return _ring.size() < _ring.capacity() || !isActive(); });
+        }
+        _waiters.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @brief 队列由空转非空时投递一次事件，一次事件循环跳转消费一批消息
+     */
+    void schedule()
+    {
+        if (_polled || _scheduled.exchange(true, std::memory_order_acq_rel)) {
+            return;
+        }
+        QObject* ctx = _context.data();
+        if (ctx == nullptr) {
+            return;
+        }
+        std::weak_ptr<EventSubscriber<T>> weak = this->weak_from_this();
+        QMetaObject::invokeMethod(ctx, [weak]() {
+            if (auto self = weak.lock()) {
+                self->deliver();
+            } }, Qt::QueuedConnection);
+    }
+
+    void deliver()
+    {
+        // 先清标记再消费，保证之后入队的消息一定会触发新的投递
+        _scheduled.store(false, std::memory_order_release);
+        drain(_batch);
+        if (_ring.size() > 0) {
+            schedule();
+        }
+    }
+
+    MpscRing<T> _ring;
+    Handler _handler;
+    QPointer<QObject> _context;
+    bool _polled = false;
+    std::size_t _batch = 64;
+    BackPressure _policy = BackPressure::DropNewest;
+    std::chrono::milliseconds _blockTimeout { 100 };
+};
+
+/**
+ * @brief 主题公共部分
+ */
+class EventTopicBase {
+public:
+    virtual ~EventTopicBase() = default;
+
+    const std::string& name() const
+    {
+        return _name;
+    }
+
+    const std::string& typeKey() const
+    {
+        return _typeKey;
+    }
+
+    virtual EventTopicStats stats() const = 0;
+
+    virtual void unsubscribe(const std::shared_ptr<EventSubscriberBase>& subscriber) = 0;
+
+private:
+    friend class QPluginEventBus;
+
+    std::string _name;
+    std::string _typeKey;
+};
+
+/**
+ * @brief 订阅句柄，析构时自动退订
+ */
+class EventSubscription {
+public:
+    EventSubscription() = default;
+
+    EventSubscription(std::weak_ptr<EventTopicBase> topic, std::shared_ptr<EventSubscriberBase> subscriber)
+        : _topic(std::move(topic))
+        , _subscriber(std::move(subscriber))
+    {
+    }
+
+    EventSubscription(const EventSubscription&) = delete;
+    EventSubscription& operator=(const EventSubscription&) = delete;
+
+    EventSubscription(EventSubscription&& other) noexcept = default;
+
+    EventSubscription& operator=(EventSubscription&& other) noexcept
+    {
+        if (this != &other) {
+            unsubscribe();
+            _topic = std::move(other._topic);
+            _subscriber = std::move(other._subscriber);
+        }
+        return *this;
+    }
+
+    ~EventSubscription()
+    {
+        unsubscribe();
+    }
+
+    /**
+     * @brief 无 context 的订阅由调用线程主动拉取；同一订阅同一时刻只能由一个线程拉取
+     * @param max 最多处理条数
+     * @return 实际处理条数
+     */
+    std::size_t drain(std::size_t max = std::numeric_limits<std::size_t>::max())
+    {
+        return _subscriber ? _subscriber->drain(max) : 0;
+    }
+
+    EventSubscriberStats stats() const
+    {
+        return _subscriber ? _subscriber->stats() : EventSubscriberStats {};
+    }
+
+    bool isValid() const
+    {
+        return _subscriber != nullptr;
+    }
+
+    void unsubscribe()
+    {
+        if (!_subscriber) {
+            return;
+        }
+        _subscriber->deactivate();
+        if (auto topic = _topic.lock()) {
+            topic->unsubscribe(_subscriber);
+        }
+        _subscriber.reset();
+        _topic.reset();
+    }
+
+private:
+    std::weak_ptr<EventTopicBase> _topic;
+    std::shared_ptr<EventSubscriberBase> _subscriber;
+};
+
+/**
+ * @brief 类型化主题：订阅表写时复制，发布侧只做一次原子读
+ * @tparam T 消息类型
+ */
+template <typename T>
+class EventTopic final : public EventTopicBase, public std::enable_shared_from_this<EventTopic<T>> {
+    using SubscriberList = std::vector<std::shared_ptr<EventSubscriber<T>>>;
+
+public:
+    /**
+     * @brief 发布消息
+     * @param value
+     * @return 接收该消息的订阅者数
+     */
+    std::size_t publish(const T& value)
+    {
+        _published.fetch_add(1, std::memory_order_relaxed);
+        auto subs = _subscribers.load(std::memory_order_acquire);
+        std::size_t accepted = 0;
+        for (const auto& s : *subs) {
+            if (s->offer(value)) {
+                ++accepted;
+            }
+        }
+        return accepted;
+    }
+
+    /**
+     * @brief 订阅
+     * @param context 投递所在线程的对象；为空时需调用 EventSubscription::drain 拉取
+     * @param handler 消息处理函数
+     * @param options 队列与背压参数
+     * @return 订阅句柄
+     */
+    EventSubscription subscribe(QObject* context, typename EventSubscriber<T>::Handler handler, const EventSubscribeOptions& options = {})
+    {
+        auto sub = std::make_shared<EventSubscriber<T>>(context, std::move(handler), options);
+        {
+            std::lock_guard lock(_mtx);
+            auto next = std::make_shared<SubscriberList>(*_subscribers.load(std::memory_order_acquire));
+            next->push_back(sub);
+            _subscribers.store(std::move(next), std::memory_order_release);
+        }
+        return EventSubscription(this->weak_from_this(), sub);
+    }
+
+    void unsubscribe(const std::shared_ptr<EventSubscriberBase>& subscriber) override
+    {
+        std::lock_guard lock(_mtx);
+        auto next = std::make_shared<SubscriberList>(*_subscribers.load(std::memory_order_acquire));
+        std::erase_if(*next, [&](const auto& s) { return s == subscriber; });
+        _subscribers.store(std::move(next), std::memory_order_release);
+    }
+
+    EventTopicStats stats() const override
+    {
+        EventTopicStats s;
+        s.name = name();
+        s.typeKey = typeKey();
+        s.published = _published.load(std::memory_order_relaxed);
+        auto subs = _subscribers.load(std::memory_order_acquire);
+        s.subscribers.reserve(subs->size());
+        for (const auto& sub : *subs) {
+            s.subscribers.push_back(sub->stats());
+        }
+        return s;
+    }
+
+private:
+    std::mutex _mtx;
+    std::atomic<std::shared_ptr<const SubscriberList>> _subscribers { std::make_shared<const SubscriberList>() };
+    std::atomic<std::uint64_t> _published { 0 };
+};
+
+/**
+ * @brief 插件间发布/订阅总线，由插件管理器提供
+ */
+class QPLUGINMANAGER_EXPORT QPluginEventBus {
+public:
+    QPluginEventBus();
+    ~QPluginEventBus();
+
+    QPluginEventBus(const QPluginEventBus&) = delete;
+    QPluginEventBus& operator=(const QPluginEventBus&) = delete;
+
+    /**
+     * @brief 获取或创建主题
+     * @tparam T 消息类型
+     * @param name 主题名
+     * @return 同名主题类型不一致时返回空
+     */
+    template <typename T>
+    std::shared_ptr<EventTopic<T>> topic(std::string_view name)
+    {
+        auto base = ensureTopic(name, RegistryTypeKey<T>(), []() -> std::shared_ptr<EventTopicBase> {
+            return std::make_shared<EventTopic<T>>();
+        });
+        return std::static_pointer_cast<EventTopic<T>>(base);
+    }
+
+    /**
+     * @brief 发布到指定主题（热路径应缓存 topic() 的返回值）
+     * @tparam T 消息类型
+     * @param name 主题名
+     * @param value
+     * @return 接收该消息的订阅者数
+     */
+    template <typename T>
+    std::size_t publish(std::string_view name, const T& value)
+    {
+        auto t = topic<T>(name);
+        return t ? t->publish(value) : 0;
+    }
+
+    /**
+     * @brief 订阅指定主题
+     * @tparam T 消息类型
+     * @param name 主题名
+     * @param context 投递所在线程的对象
+     * @param handler 消息处理函数
+     * @param options 队列与背压参数
+     * @return 订阅句柄；主题类型不一致时无效
+     */
+    template <typename T>
+    EventSubscription subscribe(std::string_view name, QObject* context, std::function<void(const T&)> handler, const EventSubscribeOptions& options = {})
+    {
+        auto t = topic<T>(name);
+        return t ? t->subscribe(context, std::move(handler), options) : EventSubscription {};
+    }
+
+    /**
+     * @brief 所有主题的吞吐与队列深度计数
+     * @return
+     */
+    std::vector<EventTopicStats> stats() const;
+
+private:
+    std::shared_ptr<EventTopicBase> ensureTopic(std::string_view name, const char* typeKey, const std::function<std::shared_ptr<EventTopicBase>()>& factory);
+
+    mutable std::shared_mutex _mtx;
+    std::unordered_map<std::string, std::shared_ptr<EventTopicBase>> _topics;
+};
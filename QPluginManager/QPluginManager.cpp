@@ -1,13 +1,22 @@
 ﻿#include "QPluginManager.h"
 
-#include <QDebug>
-
+#include "QPluginLogging.h"
 #include "QPluginManagerImpl.h"
 
+namespace {
+thread_local QPluginManager* t_current = nullptr;
+}
+
 QPluginManager::QPluginManager()
 {
-    qDebug() << "QPluginManager::QPluginManager()";
-    this->_impl = new QPluginManagerImpl();
+    qPluginDebug(lcPluginManager) << "QPluginManager::QPluginManager()";
+    this->_impl = new QPluginManagerImpl(this, "default", true);
+}
+
+QPluginManager::QPluginManager(const QString& name)
+{
+    qPluginDebug(lcPluginManager) << "QPluginManager::QPluginManager()" << name;
+    this->_impl = new QPluginManagerImpl(this, name, false);
 }
 
 QPluginManager& QPluginManager::Instance()
@@ -16,12 +25,27 @@ QPluginManager& QPluginManager::Instance()
     return instance;
 }
 
+QPluginManager& QPluginManager::Current()
+{
+    return t_current ? *t_current : Instance();
+}
+
+QPluginManager* QPluginManager::contextOf(const QObject* plugin)
+{
+    return QPluginManagerImpl::ownerOf(plugin);
+}
+
 QPluginManager::~QPluginManager()
 {
-    qDebug() << "QPluginManager::~QPluginManager()";
+    qPluginDebug(lcPluginManager) << "QPluginManager::~QPluginManager()";
     delete this->_impl;
 }
 
+QString QPluginManager::name() const
+{
+    return this->_impl->name();
+}
+
 void QPluginManager::loadPlugin(const QString& path)
 {
     this->_impl->loadPlugin(path);
@@ -37,6 +61,11 @@ void QPluginManager::findLoadPlugins(const QString& path)
     this->_impl->findLoadPlugins(path);
 }
 
+PluginScanStats QPluginManager::rescan(bool retryRejected)
+{
+    return this->_impl->rescan(retryRejected);
+}
+
 bool QPluginManager::isLoad(const QString& name)
 {
     return this->_impl->isLoad(name);
@@ -70,4 +99,140 @@ bool QPluginManager::delayedInitialize()
 void QPluginManager::appendFilter(std::function<bool(PluginInterface* ptr)> fun)
 {
     return this->_impl->appendFilter(fun);
+}
+
+QPluginEventBus& QPluginManager::eventBus()
+{
+    return this->_impl->eventBus();
+}
+
+PluginBufferService& QPluginManager::buffers()
+{
+    return this->_impl->buffers();
+}
+
+PluginScheduler& QPluginManager::scheduler()
+{
+    return this->_impl->scheduler();
+}
+
+PluginTracer& QPluginManager::tracer()
+{
+    return this->_impl->tracer();
+}
+
+PluginWatchdog& QPluginManager::watchdog()
+{
+    return this->_impl->watchdog();
+}
+
+qint64 QPluginManager::forkWorker()
+{
+    return this->_impl->forkWorker();
+}
+
+PluginZygoteReport QPluginManager::zygoteReport() const
+{
+    return this->_impl->zygoteReport();
+}
+
+PluginMemoryReport QPluginManager::memoryReport() const
+{
+    return this->_impl->memoryReport();
+}
+
+void QPluginManager::startMemorySampler(int msec, int history)
+{
+    this->_impl->startMemorySampler(msec, history);
+}
+
+void QPluginManager::stopMemorySampler()
+{
+    this->_impl->stopMemorySampler();
+}
+
+void QPluginManager::prefetchPlugins(const QStringList& paths)
+{
+    this->_impl->prefetchPlugins(paths);
+}
+
+PluginPrefetchReport QPluginManager::prefetchReport() const
+{
+    return this->_impl->prefetchReport();
+}
+
+QStringList QPluginManager::loadOrder() const
+{
+    return this->_impl->loadOrder();
+}
+
+void QPluginManager::enableUsageProfile(const QString& path, int idleSessions)
+{
+    this->_impl->enableUsageProfile(path, idleSessions);
+}
+
+void QPluginManager::setActivation(const QString& name, PluginActivation activation)
+{
+    this->_impl->setActivation(name, activation);
+}
+
+PluginUsageProfile QPluginManager::usageProfile() const
+{
+    return this->_impl->usageProfile();
+}
+
+bool QPluginManager::saveUsageProfile() const
+{
+    return this->_impl->saveUsageProfile();
+}
+
+void QPluginManager::enableStateCache(const QString& dir)
+{
+    this->_impl->enableStateCache(dir);
+}
+
+PluginStateStats QPluginManager::stateCacheStats() const
+{
+    return this->_impl->stateCacheStats();
+}
+
+QList<PluginMetaData> QPluginManager::scanMetaData(const QString& path, bool recursive)
+{
+    return this->_impl->scanMetaData(path, recursive);
+}
+
+std::optional<PluginMetaData> QPluginManager::metaData(const QString& name) const
+{
+    return this->_impl->metaData(name);
+}
+
+QList<PluginMetaData> QPluginManager::pluginsByCategory(const QString& category) const
+{
+    return this->_impl->pluginsByCategory(category);
+}
+
+QList<PluginMetaData> QPluginManager::pluginsByVendor(const QString& vendor) const
+{
+    return this->_impl->pluginsByVendor(vendor);
+}
+
+QList<PluginMetaData> QPluginManager::pluginsInVersionRange(const QString& min, const QString& max, const QString& name) const
+{
+    return this->_impl->pluginsInVersionRange(min, max, name);
+}
+
+QList<PluginMetaData> QPluginManager::catalog() const
+{
+    return this->_impl->catalog();
+}
+
+QPluginManagerScope::QPluginManagerScope(QPluginManager& context)
+    : _previous(t_current)
+{
+    t_current = &context;
+}
+
+QPluginManagerScope::~QPluginManagerScope()
+{
+    t_current = _previous;
 }
\ No newline at end of file
@@ -15,8 +15,22 @@
 #include <QObject>
 
 #include <optional>
+#include <type_traits>
+#include <utility>
 
 #include "PluginInterface.h"
+#include "QPluginBuffer.h"
+#include "QPluginEventBus.h"
+#include "QPluginMemory.h"
+#include "QPluginMetaData.h"
+#include "QPluginPrefetch.h"
+#include "QPluginScanner.h"
+#include "QPluginScheduler.h"
+#include "QPluginStateCache.h"
+#include "QPluginTracer.h"
+#include "QPluginUsage.h"
+#include "QPluginWatchdog.h"
+#include "QPluginZygote.h"
 
 #ifndef QPLUGINMANAGER
 #define QPLUGINMANAGER QPluginManager::Instance()
@@ -32,18 +46,47 @@ protected:
 
 public:
     /**
-     * @brief 单例
+     * @brief 独立的插件管理上下文，拥有自己的插件表、过滤器、生命周期与插件实例；
+     *        动态库的根实例已属于其他上下文时，本上下文经 AUTO_REGISTER 注册的工厂另建实例，未注册工厂的插件被忽略
+     * @param name 上下文名
+     */
+    explicit QPluginManager(const QString& name);
+
+    QPluginManager(const QPluginManager&) = delete;
+    QPluginManager& operator=(const QPluginManager&) = delete;
+
+    /**
+     * @brief 单例，默认上下文
      * @return 自身对象引用
      */
     static QPluginManager& Instance();
 
+    /**
+     * @brief 当前线程的上下文：处于 QPluginManagerScope 内（包括插件各初始化阶段与 release）时为该作用域的上下文，否则为默认上下文
+     * @return
+     */
+    static QPluginManager& Current();
+
+    /**
+     * @brief 加载了指定插件的上下文
+     * @param plugin 插件实例
+     * @return 未由任何上下文加载时为空
+     */
+    static QPluginManager* contextOf(const QObject* plugin);
+
     /**
      * @brief 释放内部类
      */
     ~QPluginManager();
 
     /**
-     * @brief 加载指定路径下的单个插件
+     * @brief 上下文名，默认上下文为 "default"
+     * @return
+     */
+    QString name() const;
+
+    /**
+     * @brief 加载指定路径下的单个插件；插件包只加载一次动态库，逐项创建其中声明的插件
      * @param path 精确到dll路径全名称
      */
     void loadPlugin(const QString& path);
@@ -60,6 +103,15 @@ public:
      */
     void findLoadPlugins(const QString& path);
 
+    /**
+     * @brief 重新扫描 loadPlugins/findLoadPlugins 扫描过的目录，加载新安装的插件。
+     *        修改时间未变的目录不再列举，已加载的文件按路径跳过，此前被拒绝且未变化的文件不再读取；
+     *        再次调用 loadPlugins/findLoadPlugins 同样是增量的
+     * @param retryRejected 是否重新尝试此前被拒绝的文件，例如补齐了缺失的依赖库之后
+     * @return 扫描计数，可通过 toJson 导出
+     */
+    PluginScanStats rescan(bool retryRejected = false);
+
     /**
      * @brief 是否已经加载指定插件名
      * @param name 插件名
@@ -68,9 +120,10 @@ public:
     bool isLoad(const QString& name);
 
     /**
-     * @brief 获取加载的插件实例指针
+     * @brief 获取加载的插件实例指针；延后插件首次访问时先完成激活再返回，
+     *        其他线程访问时阻塞等待管理线程完成激活（需管理线程运行事件循环）
      * @param name 插件实例名
-     * @return 插件实例指针
+     * @return 插件实例指针；在管理线程派发的插件阶段中从其他线程访问未激活的延后插件时为空
      */
     std::optional<PluginInterface*> load(const QString& name);
 
@@ -105,4 +158,247 @@ public:
      * @param function
      */
     void appendFilter(std::function<bool(PluginInterface* ptr)> fun);
-};
\ No newline at end of file
+
+    /**
+     * @brief 插件间发布/订阅总线
+     * @return 总线引用
+     */
+    QPluginEventBus& eventBus();
+
+    /**
+     * @brief 插件间零拷贝缓冲区服务：按尺寸档复用的引用计数缓冲区（可选共享内存）与生产者/消费者通道，
+     *        句柄在插件间传递时不复制数据
+     * @return 服务引用
+     */
+    PluginBufferService& buffers();
+
+    /**
+     * @brief 插件共享的工作窃取调度器：按插件分组、优先级、后续任务与分组 CPU 时间统计，插件 release 前取消其分组。
+     *        插件在 initialize 等阶段中经 QPluginManager::Current().scheduler() 取得，以 objectName() 作为分组名
+     * @return 调度器引用
+     */
+    PluginScheduler& scheduler();
+
+    /**
+     * @brief 插件方法调用追踪（默认关闭）：经 invoke/call、CallPluginPtr 与调度器任务进入插件的调用按线程采样，
+     *        统计调用次数、耗时直方图与调用方插件，可导出火焰图折叠格式
+     * @return 追踪器引用
+     */
+    PluginTracer& tracer();
+
+    /**
+     * @brief 经追踪层调用插件的槽或 Q_INVOKABLE 方法，参数同 QMetaObject::invokeMethod；
+     *        插件在其他线程时按连接方式排队执行，耗时只含排队
+     * @param name 插件名
+     * @param method 方法名
+     * @param args 连接方式、Q_RETURN_ARG、Q_ARG 等
+     * @return 插件未加载或调用失败时返回 false
+     */
+    template <typename... Args>
+    bool invoke(const QString& name, const char* method, Args&&... args)
+    {
+        auto&& opt = this->load(name);
+        if (!opt.has_value()) {
+            return false;
+        }
+        PluginTraceScope scope(this->tracer(), name, method);
+        return QMetaObject::invokeMethod(opt.value(), method, std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief 经追踪层调用插件接口：实例经 qobject_cast 转为 T（Q_OBJECT 类或 Q_DECLARE_INTERFACE 声明的接口）后传给 fun
+     * @param name 插件名
+     * @param method 记录的方法名
+     * @param fun 以 T* 为参数的调用
+     * @return fun 无返回值时为是否已调用，否则为 std::optional 包装的返回值；插件未加载或不支持接口 T 时为空
+     */
+    template <typename T, typename F>
+    auto call(const QString& name, const char* method, F&& fun)
+    {
+        using R = std::invoke_result_t<F, T*>;
+        auto&& opt = this->load(name);
+        T* ptr = opt.has_value() ? qobject_cast<T*>(opt.value()) : nullptr;
+        if constexpr (std::is_void_v<R>) {
+            if (ptr == nullptr) {
+                return false;
+            }
+            PluginTraceScope scope(this->tracer(), name, method);
+            std::forward<F>(fun)(ptr);
+            return true;
+        } else {
+            if (ptr == nullptr) {
+                return std::optional<R>();
+            }
+            PluginTraceScope scope(this->tracer(), name, method);
+            return std::optional<R>(std::forward<F>(fun)(ptr));
+        }
+    }
+
+    /**
+     * @brief 初始化阶段看门狗：按插件与阶段设置预算，超时时采样调用栈并发出 overrun 信号，
+     *        可选将超时插件标记为失败并继续后续插件；需在 initializes 之前配置
+     * @return 看门狗引用
+     */
+    PluginWatchdog& watchdog();
+
+    /**
+     * @brief 孕育进程模式：在 findLoadPlugins、initializes、extensionsInitialized 之后调用，fork 出以写时复制方式
+     *        继承已初始化插件的工作进程，工作进程随后自行调用 delayedInitialize。
+     *        fork 前按加载逆序调用实现 PluginForkHooks 的插件（含按线程实例）的 beforeFork，停止全部上下文的后台线程、插件线程、
+     *        指标导出线程与全局 QThreadPool 的线程；fork 后工作进程替换调用线程事件分发器继承的唤醒描述符（Linux，插件创建的 eventfd 不变），
+     *        父子进程各自重启线程（指标导出只在孕育进程中重启），再按加载顺序调用 afterFork。fork 期间其他线程不应使用管理器与全局线程池，孕育进程之后只负责 fork 与回收工作进程。仅 Unix 可用
+     * @return 孕育进程中为工作进程号，工作进程中为 0，失败或平台不支持时为 -1
+     */
+    qint64 forkWorker();
+
+    /**
+     * @brief 孕育进程模式报告：工作进程启动耗时、孕育进程暂停时长，以及各进程的共享/私有内存
+     * @return 可通过 toJson 导出
+     */
+    PluginZygoteReport zygoteReport() const;
+
+    /**
+     * @brief 各插件内存账目：动态库 Rss/Pss 与 load/instance/各初始化阶段的堆增量；
+     *        堆增量按进程计量，阶段执行期间其他线程的分配同样计入该插件，仅在 PluginMemoryProbe::enabled() 时记录
+     * @return 内存报告，可通过 toJson 导出
+     */
+    PluginMemoryReport memoryReport() const;
+
+    /**
+     * @brief 启动周期采样，记录各插件动态库占用随时间的增长
+     * @param msec 采样间隔
+     * @param history 每个插件保留的采样数
+     */
+    void startMemorySampler(int msec = 60000, int history = 60);
+
+    /**
+     * @brief 停止周期采样
+     */
+    void stopMemorySampler();
+
+    /**
+     * @brief 后台预读插件文件到页缓存，主线程不等待；loadPlugins/findLoadPlugins 扫描后会自动预读
+     * @param paths 按预计加载顺序排列的文件路径，例如上次运行保存的 loadOrder()
+     */
+    void prefetchPlugins(const QStringList& paths);
+
+    /**
+     * @brief 各插件文件的预读耗时、加载耗时及节省时间估计
+     * @return 预读报告，可通过 toJson 导出
+     */
+    PluginPrefetchReport prefetchReport() const;
+
+    /**
+     * @brief 本次运行的插件加载顺序，可保存下来供下次启动时 prefetchPlugins
+     * @return 文件路径列表
+     */
+    QStringList loadOrder() const;
+
+    /**
+     * @brief 启用使用画像：记录每次会话中经 load()/GetPluginPtr 访问过的插件，release 时写入画像文件；
+     *        之后启动时，近 idleSessions 个会话未使用的插件移出 initializes/extensionsInitialized，
+     *        在 delayedInitialize 之后逐个激活或首次 load 时激活，其余按使用频度优先初始化。
+     *        元信息 Required 为 true 的插件不会延后。需在 initializes 之前调用
+     * @param path 画像文件路径，为空时使用应用本地数据目录下的 QPluginUsage.json
+     * @param idleSessions 连续未使用的会话数阈值
+     */
+    void enableUsageProfile(const QString& path = QString(), int idleSessions = 5);
+
+    /**
+     * @brief 覆盖插件激活方式，优先于画像文件中的 overrides；只作用于本进程，不写入画像文件
+     * @param name 插件名
+     * @param activation 激活方式，Auto 取消覆盖
+     */
+    void setActivation(const QString& name, PluginActivation activation);
+
+    /**
+     * @brief 含本会话访问记录的使用画像
+     * @return
+     */
+    PluginUsageProfile usageProfile() const;
+
+    /**
+     * @brief 立即保存使用画像
+     * @return 未启用或写入失败时返回 false
+     */
+    bool saveUsageProfile() const;
+
+    /**
+     * @brief 启用初始化检查点缓存：extensionsInitialized 之后导出实现 PluginStateHooks 的插件的 saveState 并在后台写入；
+     *        之后启动时，插件文件（路径、大小、修改时间）、元信息 Version 与 stateKey 均未变化的插件在 initialize 之前调用 restoreState，
+     *        由插件决定跳过哪些初始化步骤；文件变化、格式版本变化或数据损坏时条目作废并按冷启动处理。需在 initializes 之前调用
+     * @param dir 缓存目录，为空时使用应用本地数据目录下的 QPluginState
+     */
+    void enableStateCache(const QString& dir = QString());
+
+    /**
+     * @brief 检查点缓存计数：命中、作废、写入字节与耗时
+     * @return 可通过 toJson 导出
+     */
+    PluginStateStats stateCacheStats() const;
+
+    /**
+     * @brief 读取目录下全部插件的元信息（不加载插件）并加入元信息目录，供下列查询使用
+     * @param path 目录
+     * @param recursive 是否递归子目录
+     * @return 读取到的元信息
+     */
+    QList<PluginMetaData> scanMetaData(const QString& path, bool recursive = true);
+
+    /**
+     * @brief 按名称获取元信息，已加载的插件以实际加载的文件为准，否则取目录中版本最高者
+     * @param name 插件名
+     * @return
+     */
+    std::optional<PluginMetaData> metaData(const QString& name) const;
+
+    /**
+     * @brief 按 Descriptions.Category 查询（大小写不敏感）
+     * @param category 分类
+     * @return
+     */
+    QList<PluginMetaData> pluginsByCategory(const QString& category) const;
+
+    /**
+     * @brief 按 Descriptions.Vendor 查询（大小写不敏感）
+     * @param vendor 厂商
+     * @return
+     */
+    QList<PluginMetaData> pluginsByVendor(const QString& vendor) const;
+
+    /**
+     * @brief 版本在闭区间 [min, max] 内的插件，按版本升序
+     * @param min 最低版本，如 "1.2"
+     * @param max 最高版本，如 "2.0.0"
+     * @param name 非空时只匹配该插件名
+     * @return
+     */
+    QList<PluginMetaData> pluginsInVersionRange(const QString& min, const QString& max, const QString& name = QString()) const;
+
+    /**
+     * @brief 元信息目录中的全部插件（含已加载与仅扫描的）
+     * @return
+     */
+    QList<PluginMetaData> catalog() const;
+};
+
+/**
+ * @brief 在作用域内把当前线程的 QPluginManager::Current() 切换为指定上下文
+ */
+class QPLUGINMANAGER_EXPORT QPluginManagerScope {
+public:
+    explicit QPluginManagerScope(QPluginManager& context);
+    ~QPluginManagerScope();
+
+    QPluginManagerScope(const QPluginManagerScope&) = delete;
+    QPluginManagerScope& operator=(const QPluginManagerScope&) = delete;
+
+private:
+    QPluginManager* _previous = nullptr;
+};
+
+// 经追踪层调用插件方法，插件名即类名，例：CallPluginPtr(QLogPluginTest, setLevel, 2)
+#ifndef CallPluginPtr
+#define CallPluginPtr(className, method, ...) \
+    QPluginManager::Current().call<className>(#className, #method, [&](className* p) { return p->method(__VA_ARGS__); })
+#endif // !CallPluginPtr
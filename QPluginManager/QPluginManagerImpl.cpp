@@ -1,138 +1,1051 @@
 ﻿#include "QPluginManagerImpl.h"
 
+#include <QAbstractEventDispatcher>
 #include <QCoreApplication>
+#include <QDateTime>
 #include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
 #include <QFileInfo>
 #include <QLibrary>
+#include <QSet>
+#include <QStandardPaths>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
 
 #include <algorithm>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#if defined(Q_OS_UNIX)
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#if defined(Q_OS_LINUX)
+#include <sys/eventfd.h>
+#endif
+
+#include "PluginForkHooks.h"
+#include "PluginStateHooks.h"
+#include "QPluginLogging.h"
+
+namespace {
+/**
+ * @brief {插件实例，上下文}，同一动态库的插件实例在进程内唯一，只能属于一个上下文
+ */
+struct PluginOwners {
+    std::mutex mtx;
+    QHash<const QObject*, QPluginManager*> map;
+};
+
+PluginOwners& owners()
+{
+    static PluginOwners instance;
+    return instance;
+}
+
+/**
+ * @brief 释放一个按线程创建的实例，需在实例所属线程调用
+ * @param owner 所属上下文，插件已卸载时为空
+ * @param ptr 实例
+ */
+void destroyThreadInstance(QPluginManager* owner, PluginInterface* ptr)
+{
+    {
+        std::lock_guard lock(owners().mtx);
+        owners().map.remove(ptr);
+    }
+    if (owner) {
+        QPluginManagerScope scope(*owner);
+        ptr->release();
+    } else {
+        // 插件卸载之后释放，上下文可能已经销毁
+        ptr->release();
+    }
+    delete ptr;
+}
+
+/**
+ * @brief 在实例所属线程取走并释放实例；线程退出与卸载投递的释放先到者执行，另一方看不到实例
+ * @param instances
+ * @param ptr
+ */
+void releaseThreadInstance(const std::shared_ptr<PluginThreadInstances>& instances, PluginInterface* ptr)
+{
+    QPluginManager* owner = nullptr;
+    {
+        std::lock_guard lock(instances->mtx);
+        auto&& list = instances->instances;
+        auto it = std::find(list.begin(), list.end(), ptr);
+        if (it == list.end()) {
+            return;
+        }
+        list.erase(it);
+        owner = instances->owner;
+    }
+    destroyThreadInstance(owner, ptr);
+}
+
+/**
+ * @brief 当前线程的按线程实例缓存，线程退出时释放仍由本线程持有的实例
+ */
+struct ThreadInstanceCache {
+    struct Entry {
+        PluginInterface* ptr = nullptr;
+        /**
+         * @brief 工厂创建失败时为空，ptr 为共享实例
+         */
+        std::weak_ptr<PluginThreadInstances> instances;
+    };
+
+    std::unordered_map<quint64, Entry> entries;
+
+    ~ThreadInstanceCache()
+    {
+        for (auto&& [id, entry] : entries) {
+            if (auto instances = entry.instances.lock()) {
+                releaseThreadInstance(instances, entry.ptr);
+            }
+        }
+    }
+};
+
+thread_local ThreadInstanceCache t_instances;
+
+/**
+ * @brief 本线程正在执行的、由管理线程阻塞派发的调用层数；大于 0 时管理线程正在等待本线程
+ */
+thread_local int t_dispatched = 0;
+
+/**
+ * @brief 其他线程等待派发调用时检查卸载标志的间隔
+ */
+constexpr int DISPATCH_POLL_MS = 10;
+
+/**
+ * @brief 派发到管理线程的调用在此时间内未开始即撤回：管理线程没有运行事件循环或正阻塞等待其他线程
+ */
+constexpr int DISPATCH_START_MS = 1000;
+
+/**
+ * @brief 进程内存活的上下文；fork 期间持有 mtx，停止全部上下文的线程
+ */
+struct LiveContexts {
+    std::mutex mtx;
+    QList<QPluginManagerImpl*> list;
+};
+
+LiveContexts& contexts()
+{
+    static LiveContexts instance;
+    return instance;
+}
+
+#if defined(Q_OS_LINUX)
+/**
+ * @brief 本进程的 eventfd 及其计数，计数读自 /proc/self/fdinfo
+ */
+QHash<int, quint64> eventDescriptors()
+{
+    QHash<int, quint64> fds;
+    for (auto&& entry : QDir("/proc/self/fd").entryList(QDir::AllEntries | QDir::System | QDir::NoDotAndDotDot)) {
+        bool ok = false;
+        const int fd = entry.toInt(&ok);
+        if (!ok) {
+            continue;
+        }
+        char target[64] = {};
+        const auto length = readlink(QByteArray("/proc/self/fd/").append(entry.toLatin1()).constData(), target, sizeof(target) - 1);
+        if (length <= 0 || strcmp(target, "anon_inode:[eventfd]") != 0) {
+            continue;
+        }
+        QFile info(QString("/proc/self/fdinfo/%1").arg(fd));
+        if (!info.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+        for (auto&& line : info.readAll().split('\n')) {
+            if (line.startsWith("eventfd-count:")) {
+                fds.insert(fd, line.mid(int(strlen("eventfd-count:"))).trimmed().toULongLong(nullptr, 16));
+            }
+        }
+    }
+    return fds;
+}
+#endif
+
+/**
+ * @brief 识别调用线程事件分发器的唤醒描述符：唤醒一次分发器，计数增加的 eventfd 即为它。
+ *        只在其他线程停止后调用；已有未处理的唤醒时分发器不再写入，无法识别
+ * @return 描述符号，未识别或非 Linux 平台时为空
+ */
+QList<int> dispatcherDescriptors()
+{
+    QList<int> fds;
+#if defined(Q_OS_LINUX)
+    auto&& dispatcher = QAbstractEventDispatcher::instance();
+    if (dispatcher == nullptr) {
+        return fds;
+    }
+    const auto before = eventDescriptors();
+    dispatcher->wakeUp();
+    const auto after = eventDescriptors();
+    for (auto it = after.cbegin(); it != after.cend(); ++it) {
+        if (before.contains(it.key()) && it.value() > before.value(it.key())) {
+            fds.append(it.key());
+        }
+    }
+#endif
+    return fds;
+}
+
+/**
+ * @brief 工作进程中替换继承的唤醒描述符：与孕育进程指向同一对象，一方的唤醒会落到另一方。
+ *        dup3 原子替换同号描述符，持有描述符号的分发器无需感知；插件自己创建的 eventfd 不在其中，保持不变
+ * @param fds dispatcherDescriptors 在 fork 前识别的描述符
+ * @return 替换的个数
+ */
+int renewEventDescriptors(const QList<int>& fds)
+{
+    int renewed = 0;
+#if defined(Q_OS_LINUX)
+    for (auto&& fd : fds) {
+        const int status = fcntl(fd, F_GETFL);
+        const int flags = fcntl(fd, F_GETFD);
+        // 新描述符带一次唤醒：fork 前的探测唤醒随旧描述符留在孕育进程
+        const int fresh = eventfd(1, (status >= 0 && (status & O_NONBLOCK) ? EFD_NONBLOCK : 0) | EFD_CLOEXEC);
+        if (fresh < 0) {
+            continue;
+        }
+        if (dup3(fresh, fd, flags >= 0 && (flags & FD_CLOEXEC) ? O_CLOEXEC : 0) == fd) {
+            renewed++;
+        }
+        close(fresh);
+    }
+#else
+    Q_UNUSED(fds);
+#endif
+    return renewed;
+}
+
+/**
+ * @brief 读者计数分片，线程首次读取时轮询分配
+ */
+std::size_t readerShard(std::size_t shards)
+{
+    static std::atomic_size_t next { 0 };
+    thread_local const std::size_t index = next.fetch_add(1, std::memory_order_relaxed);
+    return index % shards;
+}
+}
+
+PluginTableDomain::Reader::Reader(const PluginTableDomain& domain)
+{
+    // 先登记再读指针：登记晚于写侧检查的读者必然读到新快照
+    const auto parity = domain._epoch.load(std::memory_order_seq_cst) & 1;
+    _slot = &domain._shards[readerShard(SHARDS)].readers[parity];
+    _slot->fetch_add(1, std::memory_order_seq_cst);
+    _table = domain._current.load(std::memory_order_seq_cst);
+}
+
+PluginTableDomain::Reader::~Reader()
+{
+    _slot->fetch_sub(1, std::memory_order_release);
+}
+
+PluginTableDomain::PluginTableDomain()
+    : _current(new PluginTable())
+{
+}
+
+PluginTableDomain::~PluginTableDomain()
+{
+    delete _current.load(std::memory_order_relaxed);
+}
+
+void PluginTableDomain::publish(const PluginTable* table)
+{
+    const auto old = _current.exchange(table, std::memory_order_seq_cst);
+    const auto parity = _epoch.fetch_add(1, std::memory_order_seq_cst) & 1;
+    // 读侧临界区只做查找，等待很短
+    for (auto&& shard : _shards) {
+        while (shard.readers[parity].load(std::memory_order_acquire) != 0) {
+            std::this_thread::yield();
+        }
+    }
+    delete old;
+}
+
+void PluginTableDomain::resetReaders()
+{
+    for (auto&& shard : _shards) {
+        shard.readers[0].store(0, std::memory_order_relaxed);
+        shard.readers[1].store(0, std::memory_order_relaxed);
+    }
+}
+
+QPluginManagerImpl::QPluginManagerImpl(QPluginManager* owner, const QString& name, bool isDefault)
+    : _owner(owner)
+    , _name(name)
+    , _default(isDefault)
+    , _scheduler(owner)
+    , _scanner(PLUGIN_SUFFIX)
+{
+    // QPLUGIN_LOG_SINK=<文件>，为空时写入 stderr：日志改由后台线程批量写出
+    if (_default && qEnvironmentVariableIsSet("QPLUGIN_LOG_SINK") && !PluginLogSink::Instance().isInstalled()) {
+        PluginLogSink::Instance().install(qEnvironmentVariable("QPLUGIN_LOG_SINK"));
+    }
+    std::lock_guard lock(contexts().mtx);
+    contexts().list.append(this);
+}
+
+QString QPluginManagerImpl::name() const
+{
+    return _name;
+}
+
+QPluginManager* QPluginManagerImpl::ownerOf(const QObject* plugin)
+{
+    auto&& o = owners();
+    std::lock_guard lock(o.mtx);
+    return o.map.value(plugin);
+}
 
 void QPluginManagerImpl::release()
 {
-    qDebug() << "QPluginManagerImpl::~QPluginManagerImpl()";
-    for (size_t i = 0; i < _paths.size(); i++) {
-        QString path = _paths.at(i);
-        if (_pathNameMap.contains(path)) {
-            QString name = _pathNameMap[path];
-            if (name == "QPluginManager") {
+    qPluginDebug(lcPluginManager) << "QPluginManagerImpl::release()";
+    // 之后管理线程会等待插件线程与任务，其他线程上正在进行的激活撤回尚未开始的阶段
+    _draining.store(true, std::memory_order_release);
+    _prefetcher.cancel();
+    _states.flush();
+    {
+        std::lock_guard lock(_writeMtx);
+        if (!_usagePath.isEmpty()) {
+            this->saveUsageProfile();
+        }
+    }
+    // 阶段超时后仍未返回的插件所在线程，不能等待其退出
+    QSet<QThread*> stuck;
+    for (size_t i = 0;; i++) {
+        PluginInterface* ptr = nullptr;
+        QThread* thread = nullptr;
+        QString name;
+        QString path;
+        std::shared_ptr<PluginThreadInstances> perThread;
+        std::shared_ptr<PluginPhaseCall> hung;
+        {
+            // 写锁只保护记录表与快照；以下的取消、等待与跨线程释放都不持有它，插件线程可在其中调用加锁的接口
+            std::lock_guard lock(_writeMtx);
+            if (i >= _records.size()) {
+                break;
+            }
+            auto&& record = _records[i];
+            if (record.name == "QPluginManager" || record.ptr == nullptr) {
+                continue;
+            }
+            // 释放回调中可能访问记录表，先取出所需字段
+            ptr = std::exchange(record.ptr, nullptr);
+            thread = std::exchange(record.thread, nullptr);
+            name = record.name;
+            path = record.path;
+            perThread = record.perThread;
+            hung = record.hung;
+            _byName.remove(record.name);
+            // 先发布不含该插件的快照，再释放实例
+            this->publish();
+        }
+        {
+            std::lock_guard ownersLock(owners().mtx);
+            owners().map.remove(ptr);
+        }
+        // 丢弃排队中的任务并等待执行中的任务返回，之后插件不再有后台任务
+        _scheduler.cancel(name);
+        if (perThread) {
+            closeThreadInstances(perThread);
+        }
+        if (hung) {
+            std::lock_guard callLock(hung->mtx);
+            if (!hung->done) {
+                // 实例与线程随进程结束回收
+                qCWarning(lcPluginManager) << "插件阶段未返回，跳过卸载:" << name;
+                stuck.insert(ptr->thread());
+                if (thread) {
+                    thread->quit();
+                }
                 continue;
             }
-            _objMap[name]->release();
-            _objMap[name]->deleteLater();
-            _objMap.remove(name);
-            _pathNameMap.remove(path);
-            qInfo() << "卸载插件:" << path;
+        }
+        auto&& home = QThread::currentThread();
+        runOnPluginThread(ptr, [this, ptr, home]() {
+            QPluginManagerScope scope(*_owner);
+            ptr->release();
+            // 移回管理线程，保证 deleteLater 在仍在运行的事件循环中执行
+            ptr->moveToThread(home);
+        });
+        ptr->deleteLater();
+        if (thread) {
+            thread->quit();
+            thread->wait();
+            delete thread;
+        }
+        // 释放完成，同名插件再次加载后的提交开启新分组
+        _scheduler.reopen(name);
+        qCInfo(lcPluginManager) << "卸载插件:" << path;
+    }
+    QList<QThread*> poolThreads;
+    // 快照引用记录，发布空快照并等旧快照的读者离开之后再释放记录
+    std::deque<PluginRecord> records;
+    {
+        std::lock_guard lock(_writeMtx);
+        records.swap(_records);
+        _byName.clear();
+        _byPath.clear();
+        this->publish();
+        _initOrder.clear();
+        poolThreads.swap(_poolThreads);
+        _poolNext = 0;
+    }
+    // 其他线程上进行中的激活仍引用旧记录；尚未开始的阶段已撤回，等它们返回
+    while (_activations.load(std::memory_order_acquire) > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(DISPATCH_POLL_MS));
+    }
+    // 共享线程在全部插件释放之后再退出
+    for (auto&& thread : poolThreads) {
+        thread->quit();
+        if (!stuck.contains(thread)) {
+            thread->wait();
+            delete thread;
         }
     }
-    _pathNameMap.clear();
-    _objMap.clear();
-    // 等待消息执行结束
+    _scheduler.shutdown();
+    _draining.store(false, std::memory_order_release);
+    // 等待消息执行结束；RegisterQClass 创建的全局对象与进程同生存期，不在此析构
     QCoreApplication::processEvents();
+    PluginLogSink::Instance().flush();
 }
 
 QPluginManagerImpl::~QPluginManagerImpl()
 {
-    qDebug() << "QPluginManagerImpl::~QPluginManagerImpl()";
+    qPluginDebug(lcPluginManager) << "QPluginManagerImpl::~QPluginManagerImpl()";
+    {
+        std::lock_guard lock(contexts().mtx);
+        contexts().list.removeOne(this);
+    }
+    // 独立上下文可在程序运行中销毁，自行卸载插件；默认上下文在 aboutToQuit 时卸载
+    if (!_default && !_records.empty()) {
+        this->release();
+    }
 }
 
 void QPluginManagerImpl::loadPlugin(const QString& path)
 {
     QFileInfo fileInfo(path);
     if (!fileInfo.isFile() || fileInfo.suffix() != PLUGIN_SUFFIX) {
-        qDebug() << "不是dll文件";
+        qPluginDebug(lcPluginManager) << "不是dll文件";
         return;
     }
-    qDebug() << "加载插件路径:" << path;
-    if (this->_paths.contains(path)) {
-        qDebug() << "定制插件已加载:" << path;
-        return;
+    qPluginDebug(lcPluginManager) << "加载插件路径:" << path;
+    // 加载动态库期间只持有扫描锁，写锁只在登记与发布时持有
+    std::lock_guard scanLock(_scanMtx);
+    // 动态库静态初始化中的全部 AUTO_REGISTER 在本函数结束时一次提交
+    RegistryBatch batch;
+    {
+        std::lock_guard lock(_writeMtx);
+        if (this->_byPath.contains(path)) {
+            qPluginDebug(lcPluginManager) << "定制插件已加载:" << path;
+            return;
+        }
     }
-    QSharedPointer<QPluginLoader> loader(new QPluginLoader(path));
-    if (loader->isLoaded()) {
-        qDebug() << "普通插件已加载:" << path;
+    const QPair<qint64, qint64> signature(fileInfo.lastModified().toMSecsSinceEpoch(), fileInfo.size());
+    if (auto it = _rejected.constFind(path); it != _rejected.cend() && it.value() == signature) {
+        qPluginDebug(lcPluginManager) << "文件未变化，跳过此前无法加载的插件:" << path;
         return;
     }
+    switch (this->loadLibrary(path)) {
+    case LoadOutcome::Loaded:
+        _rejected.remove(path);
+        break;
+    case LoadOutcome::Invalid:
+        _rejected.insert(path, signature);
+        break;
+    case LoadOutcome::Declined:
+        // 取决于当前状态（筛选器、重名、其他上下文），下次扫描重新尝试
+        _rejected.remove(path);
+        break;
+    }
+}
+
+QPluginManagerImpl::LoadOutcome QPluginManagerImpl::loadLibrary(const QString& path)
+{
+    // 元信息解析与 load 都会读取文件，一并计入加载耗时
+    const bool warm = _prefetcher.beginLoad(path);
+    QElapsedTimer loadTimer;
+    loadTimer.start();
+    // 同一路径的 QPluginLoader 共用进程内的动态库与根实例；其他上下文已加载时 load 只增加引用计数
+    QSharedPointer<QPluginLoader> loader(new QPluginLoader(path));
     auto&& meta = loader->metaData().value("MetaData").toObject();
-    if (meta.isEmpty() || !meta.contains(NAME) || !(meta.value("Interface").toString() == "PluginInterface")) {
-        return;
+    const bool isBundle = meta.value("Plugins").isArray();
+    QList<PluginMetaData> entries;
+    for (auto&& parsed : PluginMetaData::fromJsonList(meta, path)) {
+        if (parsed.isValid()) {
+            entries.append(parsed);
+        }
     }
+    if (entries.isEmpty()) {
+        return LoadOutcome::Invalid;
+    }
+    {
+        std::lock_guard lock(_writeMtx);
+        for (auto&& parsed : entries) {
+            _catalog.insert(parsed);
+        }
+    }
+    // 堆探测默认关闭，关闭时不读取进程堆计数，heapDeltas 留空
+    const bool probe = PluginMemoryProbe::enabled();
+    const auto heapBytes = [probe]() { return probe ? PluginMemoryProbe::heapBytes() : 0; };
+    auto heap = heapBytes();
     if (!loader->load()) {
-        qDebug() << "加载失败:" << loader->errorString();
+        qCWarning(lcPluginManager) << "加载失败:" << loader->errorString();
         loader->unload();
-        return;
+        // 动态库静态初始化期间注册的工厂随库卸载失效
+        if (const auto removed = RegistryHub::Instance().revertBatch()) {
+            qCInfo(lcPluginManager) << "撤销卸载动态库的注册项:" << removed << path;
+        }
+        return LoadOutcome::Invalid;
+    }
+    const auto loadUs = loadTimer.nsecsElapsed() / 1000;
+    _prefetcher.endLoad(path, warm, loadUs);
+    if (PluginMetrics::enabled()) {
+        PluginMetrics::Instance().histogram("manager.load", warm ? "warm" : "cold").record(static_cast<std::uint64_t>(loadUs));
     }
-    if (QObject* obj = loader->instance()) {
+    const auto loadHeap = heapBytes() - heap;
+    heap = heapBytes();
+    QObject* obj = loader->instance();
+    if (obj == nullptr) {
+        return LoadOutcome::Invalid;
+    }
+    const auto instanceHeap = heapBytes() - heap;
+    qPluginDebug(lcPluginManager) << "元信息:" << meta;
+    if (!isBundle) {
         if (!obj->inherits("PluginInterface")) {
+            return LoadOutcome::Invalid;
+        }
+        auto&& record = makeRecord(entries.first());
+        // 独立插件的其余实例由 AUTO_REGISTER 注册的工厂创建，键缺省为实例类名
+        const auto key = (record.meta.className.isEmpty() ? QString(obj->metaObject()->className()) : record.meta.className).toStdString();
+        auto ptr = reinterpret_cast<PluginInterface*>(obj);
+        std::unique_ptr<PluginInterface> own;
+        if (auto&& other = ownerOf(obj); other && other != _owner) {
+            // 根实例属于其他上下文，本上下文经工厂另建实例，与按线程实例相同
+            heap = heapBytes();
+            own = StaticRegistry<PluginInterface>::create(key);
+            if (!own) {
+                qCWarning(lcPluginManager) << "插件已由上下文" << other->name() << "加载且未注册工厂，忽略:" << record.name;
+                return LoadOutcome::Declined;
+            }
+            if (probe) {
+                record.memory.heapDeltas["instance"] = heapBytes() - heap;
+            }
+            ptr = own.get();
+        } else if (probe) {
+            record.memory.heapDeltas["load"] = loadHeap;
+            record.memory.heapDeltas["instance"] = instanceHeap;
+        }
+        if (record.meta.perThread) {
+            record.perThread = this->makeThreadInstances(record.name, [key]() {
+                return StaticRegistry<PluginInterface>::create(key);
+            });
+        }
+        std::lock_guard lock(_writeMtx);
+        if (!this->admit(std::move(record), ptr, loader)) {
+            return LoadOutcome::Declined;
+        }
+        // 实例由记录接管，卸载时随 deleteLater 释放
+        (void)own.release();
+        this->publish();
+        return LoadOutcome::Loaded;
+    }
+    auto&& bundle = qobject_cast<PluginBundle*>(obj);
+    if (bundle == nullptr) {
+        qCWarning(lcPluginManager) << "插件包根对象未继承 PluginBundle，忽略:" << path;
+        return LoadOutcome::Invalid;
+    }
+    qCInfo(lcPluginManager) << "加载插件包:" << entries.first().bundle << entries.size() << "项";
+    // 动态库只加载一次，各项由包内工厂创建后逐项筛选与登记，最后统一发布一次快照
+    bool admitted = false;
+    bool declined = false;
+    for (auto&& parsed : entries) {
+        heap = heapBytes();
+        auto instance = bundle->create(parsed.className);
+        if (!instance) {
+            qCWarning(lcPluginManager) << "插件包中未注册:" << parsed.className << path;
+            continue;
+        }
+        auto&& record = makeRecord(parsed);
+        if (probe) {
+            record.memory.heapDeltas["instance"] = heapBytes() - heap;
+        }
+        if (record.meta.perThread) {
+            record.perThread = this->makeThreadInstances(record.name, [bundle, className = parsed.className]() {
+                return bundle->create(className);
+            });
+        }
+        if (!admitted && probe) {
+            // 动态库本身的开销记在第一项
+            record.memory.heapDeltas["load"] = loadHeap + instanceHeap;
+        }
+        auto&& ptr = instance.release();
+        std::lock_guard lock(_writeMtx);
+        if (this->admit(std::move(record), ptr, loader)) {
+            admitted = true;
+        } else {
+            declined = true;
+            delete ptr;
+        }
+    }
+    if (admitted) {
+        std::lock_guard lock(_writeMtx);
+        this->publish();
+        return LoadOutcome::Loaded;
+    }
+    return declined ? LoadOutcome::Declined : LoadOutcome::Invalid;
+}
+
+std::shared_ptr<PluginThreadInstances> QPluginManagerImpl::makeThreadInstances(const QString& name, std::function<std::unique_ptr<PluginInterface>()> factory)
+{
+    static std::atomic<quint64> next { 0 };
+    auto instances = std::make_shared<PluginThreadInstances>();
+    instances->id = ++next;
+    instances->name = name;
+    instances->owner = _owner;
+    instances->factory = std::move(factory);
+    return instances;
+}
+
+PluginInterface* QPluginManagerImpl::threadInstance(PluginInterface* shared, const std::shared_ptr<PluginThreadInstances>& instances)
+{
+    if (!instances->ready.load(std::memory_order_acquire) || shared->thread() == QThread::currentThread()) {
+        return shared;
+    }
+    // 热路径：本线程已有实例，无锁返回
+    auto&& cache = t_instances.entries;
+    if (auto it = cache.find(instances->id); it != cache.end()) {
+        return it->second.ptr;
+    }
+    QPluginManager* owner = nullptr;
+    {
+        std::lock_guard lock(instances->mtx);
+        if (instances->closed) {
+            return shared;
+        }
+        owner = instances->owner;
+    }
+    auto instance = instances->factory();
+    if (!instance) {
+        qCWarning(lcPluginManager) << "按线程实例化失败，未注册工厂，使用共享实例:" << instances->name;
+        cache.emplace(instances->id, ThreadInstanceCache::Entry { shared, {} });
+        return shared;
+    }
+    auto&& ptr = instance.release();
+    ptr->setObjectName(instances->name);
+    {
+        std::lock_guard lock(owners().mtx);
+        owners().map.insert(ptr, owner);
+    }
+    // 在本线程按共享实例的顺序执行各初始化阶段，预算与共享实例相同
+    const auto& name = instances->name;
+    const bool fail = _watchdog->failOnOverrun();
+    bool failed = false;
+    const auto initPhase = [this, &name, fail, &failed](const char* phase, const std::function<void()>& fun) {
+        if (failed) {
             return;
         }
-        auto&& ptr = reinterpret_cast<PluginInterface*>(obj);
-        ptr->setObjectName(meta.value(NAME).toString());
-        for (auto&& filter : this->_filters) {
-            if (!filter(ptr)) {
-                qInfo() << "忽略加载插件名称:" << meta.value(NAME).toString();
-                return;
+        const auto budget = _watchdog->budget(name, phase);
+        MetricHistogram* metric = nullptr;
+        if (PluginMetrics::enabled()) {
+            metric = &PluginMetrics::Instance().histogram(std::string("manager.phase.") + phase, name.toStdString());
+        }
+        failed = this->runArmed(name, phase, budget, metric, fun) && fail && budget > 0;
+    };
+    initPhase("initialize", [ptr, &instances]() {
+        QString error;
+        ptr->initialize(instances->args, error);
+    });
+    initPhase("extensionsInitialize", [ptr]() { ptr->extensionsInitialize(); });
+    initPhase("delayedInitialize", [ptr]() { ptr->delayedInitialize(); });
+    if (failed) {
+        qCWarning(lcPluginManager) << "按线程实例初始化超时，使用共享实例:" << name;
+        destroyThreadInstance(owner, ptr);
+        cache.emplace(instances->id, ThreadInstanceCache::Entry { shared, {} });
+        return shared;
+    }
+    bool kept = false;
+    {
+        std::lock_guard lock(instances->mtx);
+        if (!instances->closed) {
+            instances->instances.push_back(ptr);
+            kept = true;
+        }
+    }
+    if (!kept) {
+        // 创建期间插件已卸载
+        destroyThreadInstance(nullptr, ptr);
+        return shared;
+    }
+    cache.emplace(instances->id, ThreadInstanceCache::Entry { ptr, instances });
+    if (PluginMetrics::enabled()) {
+        PluginMetrics::Instance().counter("manager.perThread", instances->name.toStdString()).add();
+    }
+    qPluginDebug(lcPluginManager) << "创建线程实例:" << instances->name << QThread::currentThread();
+    return ptr;
+}
+
+bool QPluginManagerImpl::runArmed(const QString& name, const char* phase, qint64 budget, MetricHistogram* metric, const std::function<void()>& fun)
+{
+    QPluginManagerScope scope(*_owner);
+    MetricTimer timer(metric);
+    const auto token = _watchdog->arm(name, phase, budget);
+    fun();
+    return _watchdog->disarm(token);
+}
+
+void QPluginManagerImpl::closeThreadInstances(const std::shared_ptr<PluginThreadInstances>& instances)
+{
+    QPluginManager* owner = nullptr;
+    std::vector<PluginInterface*> local;
+    std::vector<PluginInterface*> remote;
+    {
+        std::lock_guard lock(instances->mtx);
+        instances->closed = true;
+        // 之后在其他线程释放的实例不进入上下文作用域，上下文可能先于这些线程销毁
+        owner = std::exchange(instances->owner, nullptr);
+        auto&& list = instances->instances;
+        for (auto it = list.begin(); it != list.end();) {
+            if ((*it)->thread() == QThread::currentThread()) {
+                local.push_back(*it);
+                it = list.erase(it);
+            } else {
+                remote.push_back(*it);
+                ++it;
             }
         }
-        qDebug() << "元信息:" << meta;
-        qInfo() << "加载插件名称:" << meta.value(NAME).toString();
-        _pathNameMap.insert(path, meta.value(NAME).toString());
-        _objMap.insert(meta.value(NAME).toString(), ptr);
-        _paths.push_back(path);
+    }
+    for (auto&& ptr : local) {
+        destroyThreadInstance(owner, ptr);
+    }
+    for (auto&& ptr : remote) {
+        {
+            // 所属上下文随卸载失效，load 不再路由到它
+            std::lock_guard lock(owners().mtx);
+            owners().map.remove(ptr);
+        }
+        // QObject 只能在所属线程释放：有事件循环的线程投递释放，其余（及事件未执行即退出的线程）由线程退出时的缓存释放
+        if (QAbstractEventDispatcher::instance(ptr->thread())) {
+            QMetaObject::invokeMethod(ptr, [instances, ptr]() { releaseThreadInstance(instances, ptr); }, Qt::QueuedConnection);
+        }
+    }
+    if (!local.empty() || !remote.empty()) {
+        qCInfo(lcPluginManager) << "释放线程实例:" << instances->name << local.size() << "，交由所属线程释放:" << remote.size();
     }
 }
 
-void QPluginManagerImpl::loadPlugins(const QString& path)
+PluginRecord QPluginManagerImpl::makeRecord(const PluginMetaData& meta)
 {
-    QDir pluginsDir(path);
-    for (auto&& p : pluginsDir.entryList(QDir::AllEntries | QDir::NoDotAndDotDot)) {
-        QFileInfo fi(path + "/" + p);
-        if (fi.isFile() && fi.suffix() == PLUGIN_SUFFIX) {
-            this->loadPlugin(path + "/" + p);
+    PluginRecord record;
+    record.path = meta.path;
+    record.name = meta.name;
+    record.meta = meta;
+    record.memory.name = record.name;
+    record.memory.path = record.path;
+    return record;
+}
+
+bool QPluginManagerImpl::admit(PluginRecord record, PluginInterface* ptr, const QSharedPointer<QPluginLoader>& loader)
+{
+    ptr->setObjectName(record.name);
+    QList<std::function<bool(PluginInterface*)>> filters;
+    {
+        std::lock_guard filterLock(_filterMtx);
+        filters = _filters;
+    }
+    for (auto&& filter : filters) {
+        if (!filter(ptr)) {
+            qCInfo(lcPluginManager) << "忽略加载插件名称:" << record.name;
+            return false;
+        }
+    }
+    qCInfo(lcPluginManager) << "加载插件名称:" << record.name;
+    if (_byName.contains(record.name)) {
+        qCWarning(lcPluginManager) << "插件名称重复，忽略:" << record.name << record.path;
+        return false;
+    }
+    {
+        auto&& o = owners();
+        std::lock_guard ownersLock(o.mtx);
+        // 各上下文持有各自的实例，同一实例不会登记到两个上下文
+        if (auto&& other = o.map.value(ptr); other && other != _owner) {
+            qCWarning(lcPluginManager) << "插件实例已属于上下文" << other->name() << "，忽略:" << record.name;
+            return false;
         }
+        o.map.insert(ptr, _owner);
+    }
+    record.ptr = ptr;
+    record.loader = loader;
+    record.usage = std::make_shared<PluginUsageCounter>();
+    auto&& affinity = record.meta.threadAffinity.toLower();
+    if (affinity == "dedicated") {
+        record.affinity = PluginThreadAffinity::Dedicated;
+    } else if (affinity == "pool") {
+        record.affinity = PluginThreadAffinity::Pool;
+    }
+    const int index = static_cast<int>(_records.size());
+    _byName.insert(record.name, index);
+    // 插件包的各项共用路径，路径指向第一项
+    if (!_byPath.contains(record.path)) {
+        _byPath.insert(record.path, index);
     }
+    _records.push_back(std::move(record));
+    return true;
 }
 
-void QPluginManagerImpl::findLoadPlugins(const QString& path)
+void QPluginManagerImpl::scanPlugins(const QString& path, bool recursive, QStringList& out)
 {
     QDir pluginsDir(path);
     for (auto&& p : pluginsDir.entryList(QDir::AllEntries | QDir::NoDotAndDotDot)) {
         QFileInfo fi(path + "/" + p);
         // 如果是目录
         if (fi.isDir()) {
-            findLoadPlugins(path + "/" + p);
+            if (recursive) {
+                scanPlugins(path + "/" + p, recursive, out);
+            }
         } else if (fi.isFile() && fi.suffix() == PLUGIN_SUFFIX) {
-            this->loadPlugin(path + "/" + p);
+            out.append(path + "/" + p);
+        }
+    }
+}
+
+void QPluginManagerImpl::scanLoad(const QString& path, bool recursive, PluginScanStats& stats)
+{
+    QStringList paths;
+    _scanner.scan(path, recursive, paths, stats);
+    QStringList candidates;
+    std::size_t before = 0;
+    {
+        std::lock_guard lock(_writeMtx);
+        before = _records.size();
+        for (auto&& p : paths) {
+            if (_byPath.contains(p)) {
+                stats.skipped++;
+                continue;
+            }
+            candidates.append(p);
+        }
+    }
+    for (auto it = candidates.begin(); it != candidates.end();) {
+        // 按文件自身的修改时间与大小判断，目录未变化时文件也可能被原地替换
+        if (auto rejected = _rejected.constFind(*it); rejected != _rejected.cend()) {
+            const QFileInfo fi(*it);
+            if (rejected.value() == qMakePair(fi.lastModified().toMSecsSinceEpoch(), fi.size())) {
+                stats.skipped++;
+                it = candidates.erase(it);
+                continue;
+            }
         }
+        ++it;
+    }
+    stats.candidates += static_cast<int>(candidates.size());
+    // 先按加载顺序交给后台预读，主线程随即开始加载
+    _prefetcher.prefetch(candidates);
+    // 整个扫描只重建并发布一次快照
+    this->beginPublish();
+    for (auto&& p : candidates) {
+        this->loadPlugin(p);
     }
+    this->endPublish();
+    std::lock_guard lock(_writeMtx);
+    stats.loaded += static_cast<int>(_records.size() - before);
+}
+
+void QPluginManagerImpl::loadPlugins(const QString& path)
+{
+    std::lock_guard lock(_scanMtx);
+    if (!_scanRoots.contains(path)) {
+        _scanRoots.insert(path, false);
+    }
+    PluginScanStats stats;
+    this->scanLoad(path, false, stats);
+}
+
+void QPluginManagerImpl::findLoadPlugins(const QString& path)
+{
+    std::lock_guard lock(_scanMtx);
+    _scanRoots.insert(path, true);
+    PluginScanStats stats;
+    this->scanLoad(path, true, stats);
+}
+
+PluginScanStats QPluginManagerImpl::rescan(bool retryRejected)
+{
+    std::lock_guard lock(_scanMtx);
+    QElapsedTimer timer;
+    timer.start();
+    if (retryRejected) {
+        _rejected.clear();
+    }
+    PluginScanStats stats;
+    this->beginPublish();
+    for (auto it = _scanRoots.cbegin(); it != _scanRoots.cend(); ++it) {
+        this->scanLoad(it.key(), it.value(), stats);
+    }
+    this->endPublish();
+    stats.elapsedUs = timer.nsecsElapsed() / 1000;
+    if (PluginMetrics::enabled()) {
+        PluginMetrics::Instance().histogram("manager.scan", "rescan").record(static_cast<std::uint64_t>(stats.elapsedUs));
+    }
+    qCInfo(lcPluginManager) << "重新扫描插件目录:" << stats.directories << "个目录，重新列举" << stats.listed << "个，新加载" << stats.loaded << "个插件，耗时" << stats.elapsedUs << "us";
+    return stats;
 }
 
 bool QPluginManagerImpl::isLoad(const QString& name)
 {
-    return _objMap.contains(name) && _objMap[name] != nullptr;
+    bool loaded = false;
+    {
+        const PluginTableDomain::Reader table(_table);
+        const auto it = table->objs.constFind(name);
+        loaded = it != table->objs.cend() && it->ptr != nullptr;
+    }
+    if (PluginMetrics::enabled()) {
+        static auto& calls = PluginMetrics::Instance().counter("manager.isLoad", "calls");
+        static auto& misses = PluginMetrics::Instance().counter("manager.isLoad", "misses");
+        calls.add();
+        if (!loaded) {
+            misses.add();
+        }
+    }
+    return loaded;
 }
 
 std::optional<PluginInterface*> QPluginManagerImpl::load(const QString& name)
 {
-    if (_objMap.contains(name) && _objMap[name] != nullptr) {
-        return { _objMap[name] };
+    if (PluginMetrics::enabled()) {
+        static auto& calls = PluginMetrics::Instance().counter("manager.load", "calls");
+        calls.add();
+    }
+    PluginInterface* ptr = nullptr;
+    PluginRecord* record = nullptr;
+    bool pending = false;
+    std::shared_ptr<PluginThreadInstances> perThread;
+    {
+        // 临界区内只查找与读标志；激活与按线程实例化可能发布快照，在临界区之外执行
+        const PluginTableDomain::Reader table(_table);
+        const auto it = table->objs.constFind(name);
+        if (it != table->objs.cend() && it->ptr) {
+            ptr = it->ptr;
+            record = it->record;
+            auto&& usage = *it->usage;
+            // 每个插件每会话只写一次
+            if (!usage.used.load(std::memory_order_relaxed) && !usage.used.exchange(true, std::memory_order_relaxed)) {
+                const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _sessionStart).count();
+                usage.firstAccessMs.store(ms, std::memory_order_relaxed);
+            }
+            pending = usage.pending.load(std::memory_order_acquire);
+            if (pending) {
+                _activations.fetch_add(1, std::memory_order_acq_rel);
+            }
+            if (it->perThread) {
+                perThread = it->perThread;
+            }
+        }
+    }
+    if (ptr) {
+        if (pending) {
+            // 延后插件首次访问即激活，返回时已完成初始化；激活失败的插件不再出现在快照中
+            const bool activated = this->activate(*record);
+            _activations.fetch_sub(1, std::memory_order_acq_rel);
+            if (!activated) {
+                return { std::nullopt };
+            }
+            const PluginTableDomain::Reader fresh(_table);
+            if (!fresh->objs.contains(name)) {
+                return { std::nullopt };
+            }
+        }
+        if (perThread) {
+            return { threadInstance(ptr, perThread) };
+        }
+        return { ptr };
+    }
+    if (PluginMetrics::enabled()) {
+        static auto& misses = PluginMetrics::Instance().counter("manager.load", "misses");
+        misses.add();
     }
     return { std::nullopt };
 }
 
 QList<QString> QPluginManagerImpl::pluginNames() const
 {
-    return _objMap.keys();
+    const PluginTableDomain::Reader table(_table);
+    return table->names;
 }
 
 bool QPluginManagerImpl::initializes(const QStringList& args, QString& error)
 {
-    QObject::connect(qApp, &QCoreApplication::aboutToQuit, [this]() {
-        qDebug() << "Application is about to quit.";
+    QObject::connect(qApp, &QCoreApplication::aboutToQuit, this, [this]() {
+        qPluginDebug(lcPluginManager) << "Application is about to quit.";
         this->release();
     });
-    for (auto&& plugin : _objMap) {
-        if (plugin) {
-            plugin->initialize(args, error);
+    // 排序只读写记录表，持写锁完成；阶段执行期间不持有
+    std::unique_lock lock(_writeMtx);
+    const int count = static_cast<int>(_records.size());
+    for (int i = 0; i < count; i++) {
+        this->assignThread(i);
+    }
+    _initArgs = args;
+    _initOrder.clear();
+    if (_usagePath.isEmpty()) {
+        for (int i = 0; i < count; i++) {
+            _initOrder.append(i);
+        }
+    } else {
+        QList<QString> names;
+        for (auto&& record : _records) {
+            names.append(record.name);
+        }
+        // 近 K 个会话未使用的插件移出关键路径，其余按使用频度排序
+        for (auto&& name : _profile.prioritize(names)) {
+            const int index = _byName.value(name);
+            auto&& record = _records[index];
+            const auto forced = _activation.value(name, PluginActivation::Auto);
+            const bool deferred = forced == PluginActivation::Auto ? _profile.isDeferred(name, _idleSessions) : forced == PluginActivation::Deferred;
+            if (!record.meta.required && deferred) {
+                record.state = PluginState::Deferred;
+                record.usage->pending.store(true, std::memory_order_release);
+                qCInfo(lcPluginManager) << "延后激活插件:" << name;
+            } else {
+                _initOrder.append(index);
+            }
+        }
+    }
+    const auto order = _initOrder;
+    lock.unlock();
+    for (auto&& index : order) {
+        auto&& record = this->recordAt(index);
+        // 超时放弃等待时阶段仍可能在插件线程上运行，参数按值持有
+        auto phaseError = std::make_shared<QString>(error);
+        this->restoreState(record);
+        if (this->runPhase(record, "initialize", [args, phaseError](PluginInterface* plugin) {
+                plugin->initialize(args, *phaseError);
+            })) {
+            error = *phaseError;
+            std::lock_guard stateLock(_writeMtx);
+            record.state = PluginState::Initialized;
+            if (auto&& perThread = record.perThread) {
+                perThread->open(args);
+            }
         }
     }
     return true;
@@ -140,30 +1053,910 @@ bool QPluginManagerImpl::initializes(const QStringList& args, QString& error)
 
 bool QPluginManagerImpl::extensionsInitialized()
 {
-    auto&& values = _objMap.values();
-    auto rbegin = std::make_reverse_iterator(values.end());
-    auto rend = std::make_reverse_iterator(values.begin());
-
-    std::for_each(rbegin, rend, [](const auto& plugin) {
-        plugin->extensionsInitialize();
-    });
+    QList<int> order;
+    {
+        std::lock_guard lock(_writeMtx);
+        order = _initOrder;
+    }
+    for (auto it = order.crbegin(); it != order.crend(); ++it) {
+        this->runPhase(this->recordAt(*it), "extensionsInitialize", [](PluginInterface* plugin) {
+            plugin->extensionsInitialize();
+        });
+    }
+    if (_states.isEnabled()) {
+        for (auto&& index : order) {
+            this->saveState(this->recordAt(index));
+        }
+        QStringList names;
+        {
+            std::lock_guard lock(_writeMtx);
+            for (auto&& record : _records) {
+                names.append(record.name);
+            }
+        }
+        _states.prune(names);
+    }
     return true;
 }
 
 bool QPluginManagerImpl::delayedInitialize()
 {
     QMetaObject::invokeMethod(this, [this]() {
-        auto&& values = _objMap.values();
-        auto rbegin = std::make_reverse_iterator(values.end());
-        auto rend = std::make_reverse_iterator(values.begin());
+        QList<int> order;
+        {
+            std::lock_guard lock(_writeMtx);
+            order = _initOrder;
+        }
+        for (auto it = order.crbegin(); it != order.crend(); ++it) {
+            this->runPhase(this->recordAt(*it), "delayedInitialize", [](PluginInterface* plugin) {
+                plugin->delayedInitialize();
+            });
+        }
+        this->activateDeferred(); }, Qt::QueuedConnection);
+    return true;
+}
 
-        std::for_each(rbegin, rend, [](const auto& plugin) {
+bool QPluginManagerImpl::activate(PluginRecord& record)
+{
+    std::shared_ptr<PluginUsageCounter> usage;
+    PluginInterface* plugin = nullptr;
+    QString name;
+    QStringList args;
+    {
+        std::lock_guard lock(_writeMtx);
+        usage = record.usage;
+        plugin = record.ptr;
+        name = record.name;
+        args = _initArgs;
+    }
+    if (plugin == nullptr) {
+        return false;
+    }
+    {
+        std::unique_lock lock(usage->activationMtx);
+        if (!usage->pending.load(std::memory_order_acquire)) {
+            return true;
+        }
+        if (usage->activating) {
+            if (usage->activator == std::this_thread::get_id()) {
+                // 激活方在阶段中再次访问，与非延后插件在初始化期间的行为一致
+                return true;
+            }
+            if (t_dispatched > 0 || plugin->thread() == QThread::currentThread()) {
+                // 激活方可能正阻塞等待本线程执行阶段，此时等待必然死锁
+                qCWarning(lcPluginManager) << "插件阶段中访问正在激活的延后插件，返回空:" << name;
+                return false;
+            }
+            usage->activated.wait(lock, [&usage]() { return !usage->activating; });
+            return !usage->pending.load(std::memory_order_acquire);
+        }
+        if (_draining.load(std::memory_order_acquire) && QThread::currentThread() != this->thread()) {
+            qCWarning(lcPluginManager) << "管理线程正在卸载，不再激活延后插件:" << name;
+            return false;
+        }
+        usage->activating = true;
+        usage->activator = std::this_thread::get_id();
+    }
+    bool ok = false;
+    bool settled = true;
+    if (plugin->thread() != QThread::currentThread() && QAbstractEventDispatcher::instance(plugin->thread()) == nullptr) {
+        // 插件线程没有事件循环，阶段永远不会执行，标记为失败而不是让访问方阻塞
+        qCWarning(lcPluginManager) << "插件线程没有事件循环，无法激活:" << name;
+        std::lock_guard lock(_writeMtx);
+        record.state = PluginState::Failed;
+        this->publish();
+    } else {
+        // 阶段在插件线程上阻塞执行，期间不持写锁，插件线程上的加载与查找不会与之互相等待
+        qCInfo(lcPluginManager) << "激活延后插件:" << name;
+        this->restoreState(record);
+        ok = this->runPhase(record, "initialize", [args](PluginInterface* plugin) {
+            QString error;
+            plugin->initialize(args, error);
+        }) && this->runPhase(record, "extensionsInitialize", [](PluginInterface* plugin) {
+            plugin->extensionsInitialize();
+        }) && this->runPhase(record, "delayedInitialize", [](PluginInterface* plugin) {
             plugin->delayedInitialize();
-        }); }, Qt::QueuedConnection);
-    return true;
+        });
+        if (ok) {
+            this->saveState(record);
+        }
+        std::lock_guard lock(_writeMtx);
+        if (ok) {
+            record.state = PluginState::Activated;
+            if (auto&& perThread = record.perThread) {
+                perThread->open(args);
+            }
+        }
+        // 阶段被撤回时保持未激活，失败的插件已从快照移除
+        settled = ok || record.state == PluginState::Failed;
+    }
+    {
+        std::lock_guard lock(usage->activationMtx);
+        if (settled) {
+            usage->pending.store(false, std::memory_order_release);
+        }
+        usage->activating = false;
+        usage->activator = std::thread::id();
+    }
+    usage->activated.notify_all();
+    return ok;
+}
+
+void QPluginManagerImpl::activateDeferred()
+{
+    std::lock_guard lock(_writeMtx);
+    for (auto&& record : _records) {
+        if (record.ptr && record.usage->pending.load(std::memory_order_acquire)) {
+            {
+                // 其他线程正在激活的插件由其完成，不在此等待
+                std::lock_guard activationLock(record.usage->activationMtx);
+                if (record.usage->activating) {
+                    continue;
+                }
+            }
+            // 每轮事件循环只激活一个，保持界面响应；其间记录表可能清空，按名称重新查找
+            QTimer::singleShot(0, this, [this, name = record.name]() {
+                PluginRecord* next = nullptr;
+                {
+                    std::lock_guard lock(_writeMtx);
+                    if (auto it = _byName.constFind(name); it != _byName.cend()) {
+                        next = &_records[it.value()];
+                    }
+                }
+                if (next) {
+                    this->activate(*next);
+                }
+                this->activateDeferred();
+            });
+            return;
+        }
+    }
 }
 
 void QPluginManagerImpl::appendFilter(std::function<bool(PluginInterface* ptr)> fun)
 {
-    this->_filters.append(fun);
-}
\ No newline at end of file
+    std::lock_guard lock(_filterMtx);
+    this->_filters.append(std::move(fun));
+}
+
+void QPluginManagerImpl::assignThread(int index)
+{
+    auto&& record = _records[index];
+    if (record.ptr == nullptr || record.ptr->thread() != QThread::currentThread()) {
+        // 已经移入工作线程
+        return;
+    }
+    QThread* target = nullptr;
+    switch (record.affinity) {
+    case PluginThreadAffinity::Dedicated:
+        target = new QThread();
+        target->setObjectName(record.name);
+        target->start();
+        record.thread = target;
+        break;
+    case PluginThreadAffinity::Pool:
+        if (_poolThreads.isEmpty()) {
+            for (int i = 0; i < std::max(1, QThread::idealThreadCount()); i++) {
+                auto&& thread = new QThread();
+                thread->setObjectName(QString("QPluginPool-%1").arg(i));
+                thread->start();
+                _poolThreads.append(thread);
+            }
+        }
+        target = _poolThreads.at(_poolNext++ % _poolThreads.size());
+        break;
+    default:
+        return;
+    }
+    qPluginDebug(lcPluginManager) << "插件移入线程:" << record.name << target->objectName();
+    record.ptr->moveToThread(target);
+}
+
+void QPluginManagerImpl::publish()
+{
+    // 只推迟批次所在线程的发布；其他线程（如卸载）必须立即发布
+    if (_publishBatch > 0 && _publishThread == std::this_thread::get_id()) {
+        _publishPending = true;
+        return;
+    }
+    _publishPending = false;
+    auto table = new PluginTable();
+    table->objs.reserve(static_cast<int>(_records.size()));
+    for (auto&& record : _records) {
+        if (record.ptr && record.state != PluginState::Failed) {
+            table->objs.insert(record.name, PluginSlot { record.ptr, record.usage, record.perThread, &record });
+            table->names.append(record.name);
+        }
+    }
+    _table.publish(table);
+}
+
+void QPluginManagerImpl::beginPublish()
+{
+    std::lock_guard lock(_writeMtx);
+    if (_publishBatch++ == 0) {
+        _publishThread = std::this_thread::get_id();
+    }
+}
+
+void QPluginManagerImpl::endPublish()
+{
+    std::lock_guard lock(_writeMtx);
+    if (--_publishBatch == 0) {
+        _publishThread = std::thread::id();
+        if (_publishPending) {
+            this->publish();
+        }
+    }
+}
+
+void QPluginManagerImpl::runOnPluginThread(PluginInterface* ptr, const std::function<void()>& fun)
+{
+    if (ptr->thread() == QThread::currentThread()) {
+        fun();
+    } else {
+        QMetaObject::invokeMethod(ptr, [&fun]() {
+            ++t_dispatched;
+            fun();
+            --t_dispatched; }, Qt::BlockingQueuedConnection);
+    }
+}
+
+bool QPluginManagerImpl::callOnPluginThread(PluginInterface* ptr, const std::function<void()>& fun)
+{
+    if (ptr->thread() == QThread::currentThread()) {
+        fun();
+        return true;
+    }
+    auto call = std::make_shared<PluginPhaseCall>();
+    QMetaObject::invokeMethod(ptr, [call, &fun]() {
+        {
+            std::lock_guard lock(call->mtx);
+            if (call->cancelled) {
+                return;
+            }
+            call->started = true;
+        }
+        ++t_dispatched;
+        fun();
+        --t_dispatched;
+        {
+            std::lock_guard lock(call->mtx);
+            call->done = true;
+        }
+        call->cv.notify_all(); }, Qt::QueuedConnection);
+    const auto since = std::chrono::steady_clock::now();
+    std::unique_lock lock(call->mtx);
+    while (!call->cv.wait_for(lock, std::chrono::milliseconds(DISPATCH_POLL_MS), [&call]() { return call->done; })) {
+        if (!call->started && this->withdraws(ptr, since)) {
+            // 撤回后 fun 不会再被访问
+            call->cancelled = true;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool QPluginManagerImpl::withdraws(PluginInterface* ptr, std::chrono::steady_clock::time_point since) const
+{
+    if (QThread::currentThread() == this->thread()) {
+        return false;
+    }
+    if (_draining.load(std::memory_order_acquire)) {
+        return true;
+    }
+    return ptr->thread() == this->thread() && std::chrono::steady_clock::now() - since >= std::chrono::milliseconds(DISPATCH_START_MS);
+}
+
+PluginRecord& QPluginManagerImpl::recordAt(int index)
+{
+    std::lock_guard lock(_writeMtx);
+    return _records[index];
+}
+
+bool QPluginManagerImpl::runPhase(PluginRecord& record, const char* phase, const std::function<void(PluginInterface*)>& fun)
+{
+    PluginInterface* plugin = nullptr;
+    QString name;
+    MetricHistogram* phaseMetric = nullptr;
+    {
+        std::lock_guard lock(_writeMtx);
+        plugin = record.ptr;
+        if (plugin == nullptr || record.state == PluginState::Failed) {
+            return false;
+        }
+        name = record.name;
+        if (PluginMetrics::enabled()) {
+            auto& metric = record.phaseMetrics[QByteArray(phase)];
+            if (metric == nullptr) {
+                metric = &PluginMetrics::Instance().histogram(std::string("manager.phase.") + phase, name.toStdString());
+            }
+            phaseMetric = metric;
+        }
+    }
+    const auto budget = _watchdog->budget(name, phase);
+    const bool fail = budget > 0 && _watchdog->failOnOverrun();
+    bool overran = false;
+    bool dispatched = true;
+    std::shared_ptr<PluginPhaseCall> hung;
+    const bool probe = PluginMemoryProbe::enabled();
+    const auto before = probe ? PluginMemoryProbe::heapBytes() : 0;
+    {
+        MetricTimer timer(phaseMetric);
+        if (fail && plugin->thread() != QThread::currentThread()) {
+            // 其他线程上的阶段在预算耗尽后不再等待，调用状态由执行线程继续持有
+            auto call = std::make_shared<PluginPhaseCall>();
+            call->fun = fun;
+            QMetaObject::invokeMethod(plugin, [call, plugin, owner = _owner, watchdog = _watchdog, name, phase, budget]() {
+                {
+                    std::lock_guard lock(call->mtx);
+                    if (call->cancelled) {
+                        return;
+                    }
+                    call->started = true;
+                }
+                QPluginManagerScope scope(*owner);
+                const auto token = watchdog->arm(name, phase, budget);
+                call->fun(plugin);
+                const bool late = watchdog->disarm(token);
+                {
+                    std::lock_guard lock(call->mtx);
+                    call->done = true;
+                    call->overran = late;
+                }
+                call->cv.notify_all(); }, Qt::QueuedConnection);
+            const auto since = std::chrono::steady_clock::now();
+            const auto deadline = since + std::chrono::milliseconds(budget);
+            std::unique_lock lock(call->mtx);
+            while (!call->done) {
+                if (!call->started && this->withdraws(plugin, since)) {
+                    call->cancelled = true;
+                    dispatched = false;
+                    break;
+                }
+                const auto now = std::chrono::steady_clock::now();
+                if (now >= deadline) {
+                    overran = true;
+                    hung = call;
+                    break;
+                }
+                call->cv.wait_until(lock, std::min(deadline, now + std::chrono::milliseconds(DISPATCH_POLL_MS)));
+            }
+            if (call->done) {
+                overran = call->overran;
+            }
+        } else {
+            dispatched = this->callOnPluginThread(plugin, [this, plugin, &fun, &name, phase, budget, &overran]() {
+                overran = this->runArmed(name, phase, budget, nullptr, [plugin, &fun]() { fun(plugin); });
+            });
+        }
+    }
+    if (!dispatched) {
+        qCWarning(lcPluginManager) << "插件线程未能开始执行，撤回插件阶段:" << name << phase;
+        return false;
+    }
+    const auto delta = probe ? PluginMemoryProbe::heapBytes() - before : 0;
+    std::lock_guard lock(_writeMtx);
+    if (probe) {
+        record.memory.heapDeltas[phase] = delta;
+    }
+    if (hung) {
+        record.hung = hung;
+    }
+    if (overran && fail) {
+        qCWarning(lcPluginManager) << "插件阶段超时，标记为失败:" << name << phase;
+        record.state = PluginState::Failed;
+        // 从插件表中移除，依赖它的插件经 GetPluginPtr 取不到实例
+        this->publish();
+        return false;
+    }
+    return true;
+}
+
+void QPluginManagerImpl::restoreState(PluginRecord& record)
+{
+    PluginInterface* plugin = nullptr;
+    QString name;
+    QString path;
+    QString version;
+    {
+        std::lock_guard lock(_writeMtx);
+        plugin = record.ptr;
+        if (plugin == nullptr || record.state == PluginState::Failed || record.path.isEmpty()) {
+            return;
+        }
+        name = record.name;
+        path = record.path;
+        version = record.meta.version.toString();
+    }
+    const auto hooks = qobject_cast<PluginStateHooks*>(plugin);
+    if (hooks == nullptr || !_states.isEnabled()) {
+        return;
+    }
+    bool restored = false;
+    this->callOnPluginThread(plugin, [this, hooks, &name, &path, &version, &restored]() {
+        QPluginManagerScope scope(*_owner);
+        const auto fingerprint = PluginStateCache::fingerprint(path, version, hooks->stateKey());
+        restored = _states.read(name, fingerprint, [hooks](const QByteArray& state) {
+            return hooks->restoreState(state);
+        });
+    });
+    {
+        std::lock_guard lock(_writeMtx);
+        record.stateRestored = restored;
+    }
+    if (restored) {
+        qCInfo(lcPluginManager) << "由检查点恢复插件:" << name;
+    }
+}
+
+void QPluginManagerImpl::saveState(PluginRecord& record)
+{
+    PluginInterface* plugin = nullptr;
+    QString name;
+    QString path;
+    QString version;
+    {
+        std::lock_guard lock(_writeMtx);
+        plugin = record.ptr;
+        if (plugin == nullptr || record.stateRestored || record.state == PluginState::Failed || record.path.isEmpty()) {
+            return;
+        }
+        name = record.name;
+        path = record.path;
+        version = record.meta.version.toString();
+    }
+    const auto hooks = qobject_cast<PluginStateHooks*>(plugin);
+    if (hooks == nullptr || !_states.isEnabled()) {
+        return;
+    }
+    QByteArray fingerprint;
+    QByteArray state;
+    this->callOnPluginThread(plugin, [this, hooks, &path, &version, &fingerprint, &state]() {
+        QPluginManagerScope scope(*_owner);
+        fingerprint = PluginStateCache::fingerprint(path, version, hooks->stateKey());
+        state = hooks->saveState();
+    });
+    if (!state.isEmpty()) {
+        _states.write(name, fingerprint, state);
+    }
+}
+
+PluginBufferService& QPluginManagerImpl::buffers()
+{
+    return _buffers;
+}
+
+PluginScheduler& QPluginManagerImpl::scheduler()
+{
+    return _scheduler;
+}
+
+PluginTracer& QPluginManagerImpl::tracer()
+{
+    return _tracer;
+}
+
+PluginWatchdog& QPluginManagerImpl::watchdog()
+{
+    return *_watchdog;
+}
+
+PluginMemoryReport QPluginManagerImpl::memoryReport() const
+{
+    PluginMemoryReport report;
+    report.timestamp = QDateTime::currentMSecsSinceEpoch();
+    report.processRss = PluginMemoryProbe::processRss();
+    std::lock_guard lock(_writeMtx);
+    QStringList paths;
+    for (auto&& record : _records) {
+        paths.append(record.path);
+    }
+    auto&& usage = PluginMemoryProbe::dsoUsage(paths);
+    for (auto&& record : _records) {
+        auto info = record.memory;
+        info.dso = usage.value(QFileInfo(record.path).canonicalFilePath());
+        report.plugins.append(info);
+    }
+    return report;
+}
+
+void QPluginManagerImpl::startMemorySampler(int msec, int history)
+{
+    if (_memorySampler == nullptr) {
+        _memorySampler = new QTimer(this);
+        QObject::connect(_memorySampler, &QTimer::timeout, this, [this]() {
+            const auto now = QDateTime::currentMSecsSinceEpoch();
+            std::lock_guard lock(_writeMtx);
+            QStringList paths;
+            for (auto&& record : _records) {
+                paths.append(record.path);
+            }
+            auto&& usage = PluginMemoryProbe::dsoUsage(paths);
+            for (auto&& record : _records) {
+                auto&& dso = usage.value(QFileInfo(record.path).canonicalFilePath());
+                auto&& samples = record.memory.samples;
+                samples.append({ now, dso.rss, dso.pss });
+                while (samples.size() > _memoryHistory) {
+                    samples.removeFirst();
+                }
+            }
+        });
+    }
+    _memoryHistory = std::max(1, history);
+    _memorySampler->start(msec);
+}
+
+void QPluginManagerImpl::stopMemorySampler()
+{
+    if (_memorySampler) {
+        _memorySampler->stop();
+    }
+}
+
+void QPluginManagerImpl::prefetchPlugins(const QStringList& paths)
+{
+    _prefetcher.prefetch(paths);
+}
+
+PluginPrefetchReport QPluginManagerImpl::prefetchReport() const
+{
+    return _prefetcher.report();
+}
+
+QStringList QPluginManagerImpl::loadOrder() const
+{
+    std::lock_guard lock(_writeMtx);
+    QStringList paths;
+    for (auto&& record : _records) {
+        paths.append(record.path);
+    }
+    return paths;
+}
+
+void QPluginManagerImpl::enableUsageProfile(const QString& path, int idleSessions)
+{
+    std::lock_guard lock(_writeMtx);
+    const QString file = _default ? QString("QPluginUsage.json") : QString("QPluginUsage-%1.json").arg(_name);
+    _usagePath = path.isEmpty()
+        ? QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/" + file
+        : path;
+    _idleSessions = std::max(1, idleSessions);
+    if (!_profile.load(_usagePath)) {
+        qCWarning(lcPluginManager) << "使用画像无法解析，重新记录:" << _usagePath;
+        _profile.sessions = 0;
+        _profile.records.clear();
+    }
+    _profile.beginSession();
+}
+
+void QPluginManagerImpl::enableStateCache(const QString& dir)
+{
+    std::lock_guard lock(_writeMtx);
+    const QString sub = _default ? QString("QPluginState") : QString("QPluginState-%1").arg(_name);
+    _states.setDirectory(dir.isEmpty()
+            ? QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/" + sub
+            : dir);
+}
+
+PluginStateStats QPluginManagerImpl::stateCacheStats() const
+{
+    return _states.stats();
+}
+
+void QPluginManagerImpl::setActivation(const QString& name, PluginActivation activation)
+{
+    std::lock_guard lock(_writeMtx);
+    // 代码中的覆盖只作用于本进程，不写入画像文件
+    if (activation == PluginActivation::Auto) {
+        _activation.remove(name);
+    } else {
+        _activation.insert(name, activation);
+    }
+}
+
+void QPluginManagerImpl::mergeUsage()
+{
+    for (auto&& record : _records) {
+        _profile.markSeen(record.name);
+        if (record.usage->used.load(std::memory_order_relaxed)) {
+            _profile.markUsed(record.name, record.usage->firstAccessMs.load(std::memory_order_relaxed));
+        }
+    }
+}
+
+PluginUsageProfile QPluginManagerImpl::usageProfile()
+{
+    std::lock_guard lock(_writeMtx);
+    this->mergeUsage();
+    return _profile;
+}
+
+bool QPluginManagerImpl::saveUsageProfile()
+{
+    std::lock_guard lock(_writeMtx);
+    if (_usagePath.isEmpty()) {
+        return false;
+    }
+    this->mergeUsage();
+    return _profile.save(_usagePath);
+}
+
+QList<PluginMetaData> QPluginManagerImpl::scanMetaData(const QString& path, bool recursive)
+{
+    QStringList paths;
+    scanPlugins(path, recursive, paths);
+    QList<PluginMetaData> out;
+    for (auto&& p : paths) {
+        // 只读取元信息段，不加载动态库；插件包展开为各项
+        out.append(PluginMetaData::readAll(p));
+    }
+    std::lock_guard lock(_writeMtx);
+    for (auto&& meta : out) {
+        _catalog.insert(meta);
+    }
+    return out;
+}
+
+std::optional<PluginMetaData> QPluginManagerImpl::metaData(const QString& name) const
+{
+    std::lock_guard lock(_writeMtx);
+    // 已加载的插件以实际加载的文件为准
+    auto it = _byName.constFind(name);
+    if (it != _byName.cend()) {
+        return _records[it.value()].meta;
+    }
+    if (auto&& meta = _catalog.find(name)) {
+        return *meta;
+    }
+    return std::nullopt;
+}
+
+QList<PluginMetaData> QPluginManagerImpl::pluginsByCategory(const QString& category) const
+{
+    std::lock_guard lock(_writeMtx);
+    return _catalog.byCategory(category);
+}
+
+QList<PluginMetaData> QPluginManagerImpl::pluginsByVendor(const QString& vendor) const
+{
+    std::lock_guard lock(_writeMtx);
+    return _catalog.byVendor(vendor);
+}
+
+QList<PluginMetaData> QPluginManagerImpl::pluginsInVersionRange(const QString& min, const QString& max, const QString& name) const
+{
+    std::lock_guard lock(_writeMtx);
+    return _catalog.inVersionRange(PluginVersion::parse(min), PluginVersion::parse(max), name);
+}
+
+QList<PluginMetaData> QPluginManagerImpl::catalog() const
+{
+    std::lock_guard lock(_writeMtx);
+    return _catalog.all();
+}
+
+QPluginEventBus& QPluginManagerImpl::eventBus()
+{
+    return this->_eventBus;
+}
+
+QList<QThread*> QPluginManagerImpl::pluginThreads() const
+{
+    QList<QThread*> threads;
+    for (auto&& record : _records) {
+        if (record.thread) {
+            threads.append(record.thread);
+        }
+    }
+    threads.append(_poolThreads);
+    return threads;
+}
+
+void QPluginManagerImpl::runForkHooks(bool before, bool child)
+{
+    // 持写锁取出实例，钩子在锁外执行
+    std::vector<std::pair<PluginInterface*, std::shared_ptr<PluginThreadInstances>>> plugins;
+    {
+        std::lock_guard lock(_writeMtx);
+        for (auto&& record : _records) {
+            if (record.ptr && record.state != PluginState::Failed && record.name != "QPluginManager") {
+                plugins.emplace_back(record.ptr, record.perThread);
+            }
+        }
+    }
+    if (before) {
+        std::reverse(plugins.begin(), plugins.end());
+    }
+    for (auto&& [ptr, perThread] : plugins) {
+        // 按线程实例在共享实例之前停止、之后恢复
+        std::vector<PluginInterface*> instances;
+        if (perThread) {
+            std::lock_guard lock(perThread->mtx);
+            instances = perThread->instances;
+        }
+        if (!before) {
+            instances.insert(instances.begin(), ptr);
+        } else {
+            instances.push_back(ptr);
+        }
+        for (auto&& instance : instances) {
+            auto hooks = qobject_cast<PluginForkHooks*>(instance);
+            if (hooks == nullptr) {
+                continue;
+            }
+            if (child && instance != ptr && instance->thread() != QThread::currentThread()) {
+                // 工作进程中只有 fork 线程，其他线程的实例不再被使用
+                continue;
+            }
+            runOnPluginThread(instance, [this, hooks, before, child]() {
+                QPluginManagerScope scope(*_owner);
+                if (before) {
+                    hooks->beforeFork();
+                } else {
+                    hooks->afterFork(child);
+                }
+            });
+        }
+    }
+}
+
+QList<QThread*> QPluginManagerImpl::suspendThreads()
+{
+    _draining.store(true, std::memory_order_release);
+    _prefetcher.cancel();
+    _states.suspend();
+    _watchdog->suspend();
+    _scheduler.suspend();
+    QList<QThread*> threads;
+    {
+        std::lock_guard lock(_writeMtx);
+        threads = this->pluginThreads();
+    }
+    for (auto&& thread : threads) {
+        thread->quit();
+    }
+    for (auto&& thread : threads) {
+        thread->wait();
+    }
+    return threads;
+}
+
+void QPluginManagerImpl::resumeThreads(const QList<QThread*>& threads, bool child)
+{
+    for (auto&& thread : threads) {
+        thread->start();
+    }
+    _scheduler.resume(child);
+    _draining.store(false, std::memory_order_release);
+}
+
+qint64 QPluginManagerImpl::forkWorker()
+{
+#if defined(Q_OS_UNIX)
+    const auto begin = std::chrono::steady_clock::now();
+    {
+        // 写锁只在检查期间持有；钩子与线程等待在锁外进行，插件线程可在其中调用加锁的接口
+        std::lock_guard lock(_writeMtx);
+        // 阶段超时后仍未返回的插件所在线程无法停止，fork 出的进程中状态不确定
+        for (auto&& record : _records) {
+            if (auto&& call = record.hung) {
+                std::lock_guard callLock(call->mtx);
+                if (!call->done) {
+                    qCWarning(lcPluginManager) << "插件阶段未返回，不能 fork:" << record.name;
+                    _zygote.failures++;
+                    return -1;
+                }
+            }
+            if (!record.perThread) {
+                continue;
+            }
+            std::lock_guard instancesLock(record.perThread->mtx);
+            for (auto&& instance : record.perThread->instances) {
+                // 钩子需在实例所在线程执行，没有事件循环的线程无法投递
+                if (qobject_cast<PluginForkHooks*>(instance) && instance->thread() != QThread::currentThread()
+                    && QAbstractEventDispatcher::instance(instance->thread()) == nullptr) {
+                    qCWarning(lcPluginManager) << "按线程实例所在线程没有事件循环，不能执行 fork 钩子:" << record.name;
+                    _zygote.failures++;
+                    return -1;
+                }
+            }
+        }
+    }
+    this->runForkHooks(true, false);
+    // 子进程只保留调用 fork 的线程：停止全部上下文的后台线程与插件线程，fork 之后在父子进程中各自重启；
+    // 持有上下文列表的锁直到重启，期间上下文不会销毁，同时只有一个 fork 在进行
+    std::unique_lock contextsLock(contexts().mtx);
+    QList<QPair<QPluginManagerImpl*, QList<QThread*>>> stopped;
+    for (auto&& context : contexts().list) {
+        stopped.append({ context, context->suspendThreads() });
+    }
+    // 指标文件只由孕育进程写出，工作进程不重启导出线程
+    const bool dumping = PluginMetrics::Instance().suspendDump();
+    // 全局线程池等待任务结束后回收全部线程，否则子进程中的线程池以为仍有空闲线程
+    QThreadPool::globalInstance()->waitForDone();
+    const auto wakeups = dispatcherDescriptors();
+    PluginLogSink::Instance().suspend();
+    const auto forkedAt = QDateTime::currentMSecsSinceEpoch();
+    const pid_t pid = fork();
+    const int error = errno;
+    const bool child = pid == 0;
+    if (child) {
+        // 在重启线程之前替换，新线程的事件分发器自行创建描述符
+        const auto renewed = renewEventDescriptors(wakeups);
+        qPluginDebug(lcPluginManager) << "工作进程替换继承的唤醒描述符:" << renewed << "/" << wakeups.size();
+        for (auto&& [context, threads] : stopped) {
+            context->_table.resetReaders();
+        }
+    }
+    PluginLogSink::Instance().resume();
+    for (auto&& [context, threads] : stopped) {
+        context->resumeThreads(threads, child);
+    }
+    contextsLock.unlock();
+    if (dumping && !child) {
+        PluginMetrics::Instance().resumeDump();
+    }
+    if (child) {
+        qint64 forks = 0;
+        {
+            std::lock_guard lock(_writeMtx);
+            forks = _zygote.forks;
+            _zygote = PluginZygoteReport();
+            _zygote.isWorker = true;
+            _zygote.parentPid = getppid();
+        }
+        this->runForkHooks(false, true);
+        const auto spawnUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count();
+        {
+            std::lock_guard lock(_writeMtx);
+            _zygote.spawnUs = spawnUs;
+        }
+        if (PluginMetrics::enabled()) {
+            PluginMetrics::Instance().histogram("manager.zygote", "spawn").record(static_cast<std::uint64_t>(spawnUs));
+        }
+        qCInfo(lcPluginManager) << "工作进程就绪:" << getpid() << "耗时" << spawnUs << "us，孕育进程已创建" << forks << "个工作进程";
+        return 0;
+    }
+    this->runForkHooks(false, false);
+    const auto pauseUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count();
+    std::lock_guard lock(_writeMtx);
+    if (pid < 0) {
+        qCWarning(lcPluginManager) << "fork 失败:" << strerror(error);
+        _zygote.failures++;
+        return -1;
+    }
+    PluginWorkerProcess worker;
+    worker.pid = pid;
+    worker.forkedAt = forkedAt;
+    worker.pauseUs = pauseUs;
+    _zygote.workers.append(worker);
+    _zygote.forks++;
+    if (PluginMetrics::enabled()) {
+        PluginMetrics::Instance().histogram("manager.zygote", "pause").record(static_cast<std::uint64_t>(pauseUs));
+    }
+    qCInfo(lcPluginManager) << "创建工作进程:" << pid << "孕育进程暂停" << pauseUs << "us";
+    return pid;
+#else
+    std::lock_guard lock(_writeMtx);
+    qCWarning(lcPluginManager) << "当前平台不支持 fork";
+    _zygote.failures++;
+    return -1;
+#endif
+}
+
+PluginZygoteReport QPluginManagerImpl::zygoteReport() const
+{
+    std::lock_guard lock(_writeMtx);
+    auto report = _zygote;
+    report.memory = PluginMemoryProbe::processMemory();
+    for (auto&& worker : report.workers) {
+#if defined(Q_OS_UNIX)
+        worker.alive = kill(static_cast<pid_t>(worker.pid), 0) == 0;
+#endif
+        if (worker.alive) {
+            worker.memory = PluginMemoryProbe::processMemory(worker.pid);
+        }
+    }
+    return report;
+}
@@ -6,42 +6,687 @@
 #pragma execution_character_set("utf-8")
 #endif
 
+#include <QHash>
 #include <QPluginLoader>
 #include <QSharedPointer>
+#include <QThread>
+#include <QTimer>
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <thread>
+#include <vector>
 
+#include "PluginBundle.h"
+#include "QPluginBuffer.h"
 #include "QPluginManager.h"
+#include "QPluginMemory.h"
+#include "QPluginMetaData.h"
+#include "QPluginPrefetch.h"
+#include "QPluginScanner.h"
+#include "QPluginScheduler.h"
+#include "QPluginStateCache.h"
+#include "QPluginTracer.h"
+#include "QPluginUsage.h"
+#include "QPluginWatchdog.h"
+#include "QPluginZygote.h"
 
+#if defined(Q_OS_WIN)
 constexpr auto PLUGIN_SUFFIX = "dll";
-constexpr auto NAME = "Name";
+#elif defined(Q_OS_MACOS)
+constexpr auto PLUGIN_SUFFIX = "dylib";
+#else
+constexpr auto PLUGIN_SUFFIX = "so";
+#endif
+
+/**
+ * @brief 插件线程归属，由元信息 ThreadAffinity 声明
+ */
+enum class PluginThreadAffinity {
+    /**
+     * @brief 留在加载线程（默认）
+     */
+    Main,
+    /**
+     * @brief 独占一个工作线程
+     */
+    Dedicated,
+    /**
+     * @brief 共享线程池中的线程
+     */
+    Pool,
+};
+
+/**
+ * @brief 本会话内的插件访问记录，load 热路径读取 used（宽松）与 pending（获取）两个标志
+ */
+struct PluginUsageCounter {
+    std::atomic_bool used { false };
+    /**
+     * @brief 首次访问距启动的毫秒数
+     */
+    std::atomic<qint64> firstAccessMs { -1 };
+    /**
+     * @brief 延后激活且尚未激活，全部阶段结束后才清除
+     */
+    std::atomic_bool pending { false };
+    /**
+     * @brief 激活守卫：同一时刻只有一个线程执行阶段，其他线程在 activated 上等待其结束
+     */
+    std::mutex activationMtx;
+    std::condition_variable activated;
+    bool activating = false;
+    std::thread::id activator;
+};
+
+/**
+ * @brief 按线程实例化的插件：各线程首次经 load 访问时由工厂创建并初始化自己的实例，存入线程缓存；
+ *        实例总在所属线程释放：线程退出时，或插件卸载时投递到该线程的事件循环
+ */
+struct PluginThreadInstances {
+    /**
+     * @brief 进程内唯一编号，线程缓存以此为键
+     */
+    quint64 id = 0;
+    QString name;
+    /**
+     * @brief 所属上下文，卸载时置空
+     */
+    QPluginManager* owner = nullptr;
+    std::function<std::unique_ptr<PluginInterface>()> factory;
+    /**
+     * @brief 共享实例完成 initialize 后置位，此前各线程使用共享实例
+     */
+    std::atomic_bool ready { false };
+    /**
+     * @brief 新实例的 initialize 参数，在 ready 之前写入
+     */
+    QStringList args;
+    std::mutex mtx;
+    /**
+     * @brief 各线程持有、尚未释放的实例
+     */
+    std::vector<PluginInterface*> instances;
+    /**
+     * @brief 插件已卸载，不再创建新实例
+     */
+    bool closed = false;
+
+    /**
+     * @brief 共享实例初始化完成，开始按线程创建实例
+     * @param initArgs initialize 参数
+     */
+    void open(const QStringList& initArgs)
+    {
+        if (!ready.load(std::memory_order_acquire)) {
+            args = initArgs;
+            ready.store(true, std::memory_order_release);
+        }
+    }
+};
+
+struct PluginRecord;
+
+/**
+ * @brief 插件表中的一项
+ */
+struct PluginSlot {
+    PluginInterface* ptr = nullptr;
+    std::shared_ptr<PluginUsageCounter> usage;
+    /**
+     * @brief 按线程实例化时非空
+     */
+    std::shared_ptr<PluginThreadInstances> perThread;
+    /**
+     * @brief 对应的记录，地址在快照存续期间不变
+     */
+    PluginRecord* record = nullptr;
+};
+
+/**
+ * @brief 只读插件表快照，每次加载/卸载整体替换，读线程无锁访问
+ */
+struct PluginTable {
+    /**
+     * @brief {对象名，插件项}Hash表
+     */
+    QHash<QString, PluginSlot> objs;
+    /**
+     * @brief 按加载顺序排列的插件名
+     */
+    QList<QString> names;
+};
+
+/**
+ * @brief 插件表快照的发布与回收：读侧在按线程分片的计数上登记当前纪元后读取裸指针，不取锁也不修改共享引用计数；
+ *        写侧换入新快照后翻转纪元，等旧纪元的读者全部离开再删除旧快照。写侧需串行调用，读侧期间不能发布
+ */
+class PluginTableDomain {
+public:
+    /**
+     * @brief 读侧临界区，存续期间快照有效
+     */
+    class Reader {
+    public:
+        explicit Reader(const PluginTableDomain& domain);
+        ~Reader();
+
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        const PluginTable* operator->() const
+        {
+            return _table;
+        }
+
+    private:
+        std::atomic<std::uint64_t>* _slot = nullptr;
+        const PluginTable* _table = nullptr;
+    };
+
+    PluginTableDomain();
+    ~PluginTableDomain();
+
+    PluginTableDomain(const PluginTableDomain&) = delete;
+    PluginTableDomain& operator=(const PluginTableDomain&) = delete;
+
+    /**
+     * @brief 换入新快照并在旧快照的读者离开后删除它
+     * @param table 新快照，由本对象接管
+     */
+    void publish(const PluginTable* table);
+
+    /**
+     * @brief 清零读者计数；fork 出的工作进程只有 fork 线程，其他线程在 fork 时登记的计数不会再离开
+     */
+    void resetReaders();
+
+private:
+    static constexpr std::size_t SHARDS = 16;
+
+    struct alignas(64) Shard {
+        std::atomic<std::uint64_t> readers[2] = {};
+    };
+
+    mutable std::array<Shard, SHARDS> _shards;
+    std::atomic<std::uint64_t> _epoch { 0 };
+    std::atomic<const PluginTable*> _current;
+};
+
+/**
+ * @brief 插件生命周期状态
+ */
+enum class PluginState {
+    /**
+     * @brief 已加载，未初始化
+     */
+    Loaded,
+    /**
+     * @brief 已在关键路径上初始化
+     */
+    Initialized,
+    /**
+     * @brief 延后激活，尚未激活
+     */
+    Deferred,
+    /**
+     * @brief 延后插件已激活
+     */
+    Activated,
+    /**
+     * @brief 阶段超时被看门狗判定失败，跳过后续阶段且不再出现在插件表中
+     */
+    Failed,
+};
+
+/**
+ * @brief 在其他线程执行、可放弃等待的一次阶段调用；调用方超时离开后由执行线程继续持有
+ */
+struct PluginPhaseCall {
+    std::mutex mtx;
+    std::condition_variable cv;
+    /**
+     * @brief 执行线程开始执行时置位；此前调用方可置 cancelled 撤回
+     */
+    bool started = false;
+    bool cancelled = false;
+    bool done = false;
+    bool overran = false;
+    std::function<void(PluginInterface*)> fun;
+};
+
+/**
+ * @brief 插件记录，按加载顺序连续存放
+ */
+struct PluginRecord {
+    QString path;
+    /**
+     * @brief 插件名，索引键与快照共享同一份隐式共享数据
+     */
+    QString name;
+    PluginInterface* ptr = nullptr;
+    QSharedPointer<QPluginLoader> loader;
+    /**
+     * @brief 解析后的元信息
+     */
+    PluginMetaData meta;
+    PluginThreadAffinity affinity = PluginThreadAffinity::Main;
+    PluginState state = PluginState::Loaded;
+    /**
+     * @brief 独占线程，仅 Dedicated 有效
+     */
+    QThread* thread = nullptr;
+    /**
+     * @brief 内存账目
+     */
+    PluginMemoryInfo memory;
+    /**
+     * @brief 本会话访问记录
+     */
+    std::shared_ptr<PluginUsageCounter> usage;
+    /**
+     * @brief 超时后放弃等待的阶段调用，未返回前不能在其线程上执行 release
+     */
+    std::shared_ptr<PluginPhaseCall> hung;
+    /**
+     * @brief 元信息 PerThread 为 true 时的按线程实例表
+     */
+    std::shared_ptr<PluginThreadInstances> perThread;
+    /**
+     * @brief {阶段名，耗时直方图}，每个阶段首次执行时解析一次
+     */
+    QHash<QByteArray, MetricHistogram*> phaseMetrics;
+    /**
+     * @brief 本会话是否由检查点恢复，恢复的插件不再重新导出
+     */
+    bool stateRestored = false;
+};
 
 class QPluginManagerImpl : public QObject {
     Q_OBJECT
 private:
     /**
-     * @brief 加载器{路径，对象名}Map表
+     * @brief 所属的对外上下文
+     */
+    QPluginManager* _owner = nullptr;
+    QString _name;
+    /**
+     * @brief 是否为默认上下文；进程级全局对象只由默认上下文析构
+     */
+    bool _default = false;
+
+    /**
+     * @brief 插件记录表，唯一的加载顺序，各阶段均按此顺序（或其逆序）遍历。
+     *        追加不移动已有记录：持写锁取出的引用在其他线程登记新插件时仍然有效；下标访问与遍历需持有写锁
      */
-    QMap<QString, QString> _pathNameMap;
+    std::deque<PluginRecord> _records;
     /**
-     * @brief {对象名，指针}Map表
+     * @brief {对象名，记录下标}Hash表
      */
-    QMap<QString, PluginInterface*> _objMap;
+    QHash<QString, int> _byName;
     /**
-     * @brief 加载顺序表
+     * @brief {路径，记录下标}Hash表
      */
-    QList<QString> _paths;
+    QHash<QString, int> _byPath;
 
+    /**
+     * @brief 当前发布的插件表快照
+     */
+    PluginTableDomain _table;
+    /**
+     * @brief 写侧互斥（登记、卸载、发布），不阻塞读侧；加载动态库期间不持有
+     */
+    mutable std::recursive_mutex _writeMtx;
+    /**
+     * @brief 串行化插件加载与目录扫描，保护 _scanner、_scanRoots、_rejected；先于 _writeMtx 加锁
+     */
+    std::recursive_mutex _scanMtx;
+    /**
+     * @brief 大于 0 时批次所在线程的 publish 只记下待发布，由最外层批次结束时统一发布一次
+     */
+    int _publishBatch = 0;
+    std::thread::id _publishThread;
+    bool _publishPending = false;
+
+    /**
+     * @brief 筛选器，读取时复制（隐式共享）后在锁外调用
+     */
     QList<std::function<bool(PluginInterface*)>> _filters;
+    mutable std::mutex _filterMtx;
+
+    /**
+     * @brief 共享线程池，按需创建
+     */
+    QList<QThread*> _poolThreads;
+    int _poolNext = 0;
+
+    QTimer* _memorySampler = nullptr;
+    int _memoryHistory = 0;
+
+    /**
+     * @brief 插件间发布/订阅总线
+     */
+    QPluginEventBus _eventBus;
+
+    /**
+     * @brief 插件间零拷贝缓冲区
+     */
+    PluginBufferService _buffers;
+
+    /**
+     * @brief 插件共享的工作窃取调度器，插件卸载时取消其任务分组
+     */
+    PluginScheduler _scheduler;
+
+    /**
+     * @brief 插件方法调用追踪，默认关闭
+     */
+    PluginTracer _tracer;
+
+    /**
+     * @brief 插件文件页缓存预读
+     */
+    PluginPrefetcher _prefetcher;
+
+    /**
+     * @brief 增量目录扫描，需持有 _scanMtx
+     */
+    PluginDirectoryScanner _scanner;
+    /**
+     * @brief loadPlugins/findLoadPlugins 扫描过的目录，{目录，是否递归}，rescan 时重新扫描
+     */
+    QHash<QString, bool> _scanRoots;
+    /**
+     * @brief 无法加载的文件，{路径，{修改时间，大小}}；只记录文件本身的问题（无有效元信息、动态库加载失败等），
+     *        文件未变化时不再创建 QPluginLoader 读取。被筛选、重名等取决于当前状态的拒绝不记录
+     */
+    QHash<QString, QPair<qint64, qint64>> _rejected;
+
+    /**
+     * @brief 已读取的插件元信息目录，含未加载的插件
+     */
+    PluginCatalog _catalog;
+
+    /**
+     * @brief 阶段超时看门狗；放弃等待的阶段调用仍持有它
+     */
+    std::shared_ptr<PluginWatchdog> _watchdog = std::make_shared<PluginWatchdog>();
+
+    /**
+     * @brief 使用画像，_usagePath 为空时不启用
+     */
+    PluginUsageProfile _profile;
+    /**
+     * @brief setActivation 设置的覆盖，优先于画像文件中的 overrides，不随画像保存
+     */
+    QMap<QString, PluginActivation> _activation;
+    QString _usagePath;
+    int _idleSessions = 5;
+    const std::chrono::steady_clock::time_point _sessionStart = std::chrono::steady_clock::now();
+    /**
+     * @brief 关键路径上的初始化顺序（记录下标，不含延后插件）；未启用画像时即加载顺序
+     */
+    QList<int> _initOrder;
+    QStringList _initArgs;
+
+    /**
+     * @brief 孕育进程模式计数与已创建的工作进程
+     */
+    PluginZygoteReport _zygote;
+
+    /**
+     * @brief 卸载进行中：管理线程会阻塞等待插件线程与后台任务，其他线程发起的激活不再开始，尚未开始的阶段撤回
+     */
+    std::atomic_bool _draining { false };
+
+    /**
+     * @brief 在快照临界区内登记、仍引用记录的激活数，卸载等其归零后再释放记录
+     */
+    std::atomic_int _activations { 0 };
+
+    /**
+     * @brief 初始化检查点缓存，未设置目录时不启用
+     */
+    PluginStateCache _states;
 
 protected:
     void release();
 
+    /**
+     * @brief 由 _records 生成新快照并原子发布，需持有写锁；批次内推迟到批次结束。
+     *        返回前等待旧快照的读者离开，之后才能释放旧快照引用的记录
+     */
+    void publish();
+
+    /**
+     * @brief 开始合并发布，与 endPublish 成对调用，可嵌套；只推迟本线程的发布
+     */
+    void beginPublish();
+
+    /**
+     * @brief 结束合并发布，最外层结束且有待发布时发布一次
+     */
+    void endPublish();
+
+    /**
+     * @brief 由元信息生成未登记的插件记录
+     * @param meta
+     * @return
+     */
+    static PluginRecord makeRecord(const PluginMetaData& meta);
+
+    /**
+     * @brief 筛选、查重并登记插件实例，不发布快照，需持有写锁
+     * @param record 由 makeRecord 生成的记录
+     * @param ptr 插件实例
+     * @param loader 所在动态库，插件包的各项共用
+     * @return 被筛选或重名时返回 false，实例未被接管
+     */
+    bool admit(PluginRecord record, PluginInterface* ptr, const QSharedPointer<QPluginLoader>& loader);
+
+    /**
+     * @brief loadLibrary 的结果
+     */
+    enum class LoadOutcome {
+        /**
+         * @brief 至少登记了一个插件
+         */
+        Loaded,
+        /**
+         * @brief 文件本身无法提供插件，文件不变时结果不变
+         */
+        Invalid,
+        /**
+         * @brief 被筛选、重名或已属于其他上下文，状态变化后可能成功
+         */
+        Declined,
+    };
+
+    /**
+     * @brief 读取元信息、加载动态库并登记其中的插件，需持有 _scanMtx；登记与发布时自行加写锁
+     * @param path 插件文件
+     * @return
+     */
+    LoadOutcome loadLibrary(const QString& path);
+
+    /**
+     * @brief 增量扫描目录并加载新出现的插件文件：已加载的文件按路径哈希跳过，
+     *        此前被拒绝的文件在所在目录未变化时跳过，需持有写锁
+     * @param path 目录
+     * @param recursive 是否递归子目录
+     * @param stats 累加计数
+     */
+    void scanLoad(const QString& path, bool recursive, PluginScanStats& stats);
+
+    /**
+     * @brief 对实现 PluginForkHooks 的实例在其所在线程调用钩子：beforeFork 按加载逆序、先按线程实例后共享实例，
+     *        afterFork 顺序相反；工作进程中只对 fork 线程上的按线程实例调用。持写锁取出实例，钩子在锁外执行
+     * @param before 是否为 beforeFork
+     * @param child afterFork 的参数
+     */
+    void runForkHooks(bool before, bool child);
+
+    /**
+     * @brief 插件线程与共享线程，fork 前后停止与重启，需持有写锁
+     * @return
+     */
+    QList<QThread*> pluginThreads() const;
+
+    /**
+     * @brief fork 前停止本上下文的后台线程与插件线程，不持写锁等待线程退出；期间其他线程发起的激活撤回
+     * @return 停止的插件线程，交给 resumeThreads 重启
+     */
+    QList<QThread*> suspendThreads();
+
+    /**
+     * @brief fork 后在父子进程中各自重启 suspendThreads 停止的线程
+     * @param threads suspendThreads 的返回值
+     * @param child 是否为工作进程，工作进程丢弃任务队列
+     */
+    void resumeThreads(const QList<QThread*>& threads, bool child);
+
+    /**
+     * @brief 创建按线程实例表
+     * @param name 插件名
+     * @param factory 实例工厂
+     * @return
+     */
+    std::shared_ptr<PluginThreadInstances> makeThreadInstances(const QString& name, std::function<std::unique_ptr<PluginInterface>()> factory);
+
+    /**
+     * @brief 当前线程的插件实例：插件所在线程与初始化完成之前返回共享实例，其他线程首次访问时创建并缓存。
+     *        新实例的初始化阶段在本线程执行，与共享实例一样受看门狗预算约束；启用 failOnOverrun 时超时的实例被释放，本线程改用共享实例
+     * @param shared 共享实例
+     * @param instances 按线程实例表
+     * @return
+     */
+    PluginInterface* threadInstance(PluginInterface* shared, const std::shared_ptr<PluginThreadInstances>& instances);
+
+    /**
+     * @brief 在当前线程执行一个初始化阶段，登记看门狗预算并记录阶段耗时
+     * @param name 插件名
+     * @param phase 阶段名
+     * @param budget 预算，0 时不登记
+     * @param metric 阶段耗时指标，为空时不计时
+     * @param fun 执行函数
+     * @return 是否超出预算
+     */
+    bool runArmed(const QString& name, const char* phase, qint64 budget, MetricHistogram* metric, const std::function<void()>& fun);
+
+    /**
+     * @brief 卸载时停止创建实例：本线程的实例立即释放，其他线程的实例投递到所属线程释放，无事件循环的线程在退出时释放
+     * @param instances
+     */
+    static void closeThreadInstances(const std::shared_ptr<PluginThreadInstances>& instances);
+
+    /**
+     * @brief 按线程归属将插件移入对应线程，需在插件当前所在线程调用
+     * @param index 记录下标
+     */
+    void assignThread(int index);
+
+    /**
+     * @brief 持写锁按下标取出记录
+     * @param index 记录下标
+     * @return 引用在记录表清空之前有效
+     */
+    PluginRecord& recordAt(int index);
+
+    /**
+     * @brief 在插件所在线程同步执行
+     * @param ptr 插件实例指针
+     * @param fun 执行函数
+     */
+    static void runOnPluginThread(PluginInterface* ptr, const std::function<void()>& fun);
+
+    /**
+     * @brief 在插件所在线程同步执行，供任意线程发起的激活使用；尚未开始的调用满足 withdraws 时撤回，
+     *        不等待可能不再运行的事件循环
+     * @param ptr 插件实例指针
+     * @param fun 执行函数
+     * @return 调用被撤回时返回 false
+     */
+    bool callOnPluginThread(PluginInterface* ptr, const std::function<void()>& fun);
+
+    /**
+     * @brief 其他线程派发的调用是否撤回：管理线程正在卸载，或派发到管理线程的调用超过 DISPATCH_START_MS 仍未开始
+     * @param ptr 插件实例指针
+     * @param since 派发时刻
+     */
+    bool withdraws(PluginInterface* ptr, std::chrono::steady_clock::time_point since) const;
+
+    /**
+     * @brief 在插件所在线程执行初始化阶段，启用堆探测时记录堆增量；记录字段的读写持有写锁。
+     *        阶段受看门狗预算约束，启用 failOnOverrun 时超时的插件标记为 Failed，
+     *        运行在其他线程的插件超时后不再等待，fun 需按值持有所需数据
+     * @param record 插件记录
+     * @param phase 阶段名
+     * @param fun 执行函数
+     * @return 插件已失败、本阶段超时判定失败或调用被撤回时返回 false
+     */
+    bool runPhase(PluginRecord& record, const char* phase, const std::function<void(PluginInterface*)>& fun);
+
+    /**
+     * @brief 对实现 PluginStateHooks 的插件在其所在线程由检查点恢复，结果记入 stateRestored
+     * @param record 插件记录
+     */
+    void restoreState(PluginRecord& record);
+
+    /**
+     * @brief 对实现 PluginStateHooks 的插件在其所在线程导出检查点并交给后台写入，已恢复的插件跳过
+     * @param record 插件记录
+     */
+    void saveState(PluginRecord& record);
+
+    /**
+     * @brief 按加载顺序列出目录下的插件文件
+     * @param path 目录
+     * @param recursive 是否递归子目录
+     * @param out 输出列表
+     */
+    static void scanPlugins(const QString& path, bool recursive, QStringList& out);
+
+    /**
+     * @brief 激活延后的插件（initialize、extensionsInitialize、delayedInitialize），可在任意线程调用。
+     *        首个调用方在本线程执行激活，阶段派发到插件线程；同时到达的其他线程等待其结束，
+     *        激活方自身在阶段中再次访问时直接返回
+     * @param record 经快照取得的插件记录
+     * @return 插件已激活返回 true；激活失败、被撤回，或等待会与激活方互相阻塞时返回 false
+     */
+    bool activate(PluginRecord& record);
+
+    /**
+     * @brief 逐个事件循环轮次激活剩余的延后插件
+     */
+    void activateDeferred();
+
+    /**
+     * @brief 合并本会话访问记录到画像，需持有写锁
+     */
+    void mergeUsage();
+
 public:
+    QPluginManagerImpl(QPluginManager* owner, const QString& name, bool isDefault);
     ~QPluginManagerImpl() override;
 
+    QString name() const;
+
+    /**
+     * @brief 加载了指定插件的上下文
+     * @param plugin 插件实例
+     * @return
+     */
+    static QPluginManager* ownerOf(const QObject* plugin);
+
     /**
-     * @brief 加载指定路径下的单个插件
+     * @brief 加载指定路径下的单个插件；插件包只加载一次动态库，逐项创建其中声明的插件
      * @param path 精确到dll路径全名称
      */
     void loadPlugin(const QString& path);
@@ -58,6 +703,13 @@ public:
      */
     void findLoadPlugins(const QString& path);
 
+    /**
+     * @brief 重新扫描 loadPlugins/findLoadPlugins 扫描过的目录，只加载新增的插件文件
+     * @param retryRejected 是否重新尝试此前被拒绝的文件
+     * @return 扫描计数
+     */
+    PluginScanStats rescan(bool retryRejected);
+
     /**
      * @brief 是否已经加载指定插件名
      * @param name 插件名
@@ -103,4 +755,143 @@ public:
      * @param function
      */
     void appendFilter(std::function<bool(PluginInterface* ptr)> fun);
+
+    /**
+     * @brief 插件间发布/订阅总线
+     * @return 总线引用
+     */
+    QPluginEventBus& eventBus();
+
+    /**
+     * @brief 插件间零拷贝缓冲区服务
+     * @return
+     */
+    PluginBufferService& buffers();
+
+    /**
+     * @brief 插件共享的任务调度器
+     * @return
+     */
+    PluginScheduler& scheduler();
+
+    /**
+     * @brief 插件方法调用追踪
+     * @return
+     */
+    PluginTracer& tracer();
+
+    /**
+     * @brief 阶段超时看门狗
+     * @return
+     */
+    PluginWatchdog& watchdog();
+
+    /**
+     * @brief 各插件内存账目
+     * @return 内存报告
+     */
+    PluginMemoryReport memoryReport() const;
+
+    /**
+     * @brief 启动周期采样
+     * @param msec 采样间隔
+     * @param history 每个插件保留的采样数
+     */
+    void startMemorySampler(int msec, int history);
+
+    /**
+     * @brief 停止周期采样
+     */
+    void stopMemorySampler();
+
+    /**
+     * @brief 后台预读插件文件
+     * @param paths 按预计加载顺序排列的文件路径
+     */
+    void prefetchPlugins(const QStringList& paths);
+
+    /**
+     * @brief 预读与加载耗时
+     * @return 预读报告
+     */
+    PluginPrefetchReport prefetchReport() const;
+
+    /**
+     * @brief 插件加载顺序
+     * @return 文件路径列表
+     */
+    QStringList loadOrder() const;
+
+    /**
+     * @brief 启用使用画像
+     * @param path 画像文件路径
+     * @param idleSessions 连续未使用的会话数阈值
+     */
+    void enableUsageProfile(const QString& path, int idleSessions);
+
+    /**
+     * @brief 设置激活方式覆盖
+     * @param name 插件名
+     * @param activation 激活方式
+     */
+    void setActivation(const QString& name, PluginActivation activation);
+
+    /**
+     * @brief 合并本会话后的使用画像
+     * @return
+     */
+    PluginUsageProfile usageProfile();
+
+    /**
+     * @brief 保存使用画像
+     * @return
+     */
+    bool saveUsageProfile();
+
+    /**
+     * @brief 读取目录下插件的元信息并加入目录，不加载插件
+     * @param path 目录
+     * @param recursive 是否递归子目录
+     * @return 读取到的元信息
+     */
+    QList<PluginMetaData> scanMetaData(const QString& path, bool recursive);
+
+    /**
+     * @brief 按名称获取元信息
+     * @param name 插件名
+     * @return
+     */
+    std::optional<PluginMetaData> metaData(const QString& name) const;
+
+    QList<PluginMetaData> pluginsByCategory(const QString& category) const;
+
+    QList<PluginMetaData> pluginsByVendor(const QString& vendor) const;
+
+    QList<PluginMetaData> pluginsInVersionRange(const QString& min, const QString& max, const QString& name) const;
+
+    QList<PluginMetaData> catalog() const;
+
+    /**
+     * @brief fork 出继承已初始化插件的工作进程
+     * @return 父进程中为工作进程号，工作进程中为 0，失败时为 -1
+     */
+    qint64 forkWorker();
+
+    /**
+     * @brief 孕育进程模式报告
+     * @return
+     */
+    PluginZygoteReport zygoteReport() const;
+
+    /**
+     * @brief 启用初始化检查点缓存
+     * @param dir 缓存目录
+     */
+    void enableStateCache(const QString& dir);
+
+    /**
+     * @brief 检查点缓存计数
+     * @return
+     */
+    PluginStateStats stateCacheStats() const;
 };
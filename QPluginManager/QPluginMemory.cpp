@@ -0,0 +1,201 @@
+﻿#include "QPluginMemory.h"
+
+#include <QFile>
+#include <QFileInfo>
+
+#include <cstdlib>
+#include <utility>
+
+#if defined(Q_OS_LINUX)
+#include <malloc.h>
+#elif defined(Q_OS_WIN)
+#include <Windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#endif
+
+namespace {
+bool heapProbeFromEnv()
+{
+    const char* env = std::getenv("QPLUGIN_HEAP_PROBE");
+    return env != nullptr && *env != '\0' && *env != '0';
+}
+}
+
+std::atomic_bool PluginMemoryProbe::s_enabled { heapProbeFromEnv() };
+
+QJsonObject PluginMemoryInfo::toJson() const
+{
+    QJsonObject heap;
+    for (auto it = heapDeltas.begin(); it != heapDeltas.end(); ++it) {
+        heap.insert(it.key(), it.value());
+    }
+    QJsonArray history;
+    for (auto&& s : samples) {
+        history.append(QJsonArray { s.timestamp, s.rss, s.pss });
+    }
+    QJsonObject obj;
+    obj.insert("name", name);
+    obj.insert("path", path);
+    obj.insert("rssKB", dso.rss);
+    obj.insert("pssKB", dso.pss);
+    obj.insert("heap", heap);
+    if (!history.isEmpty()) {
+        obj.insert("samples", history);
+        obj.insert("rssGrowthKB", samples.last().rss - samples.first().rss);
+    }
+    return obj;
+}
+
+QJsonObject PluginProcessMemory::toJson() const
+{
+    QJsonObject obj;
+    obj.insert("rssKB", rss);
+    obj.insert("pssKB", pss);
+    obj.insert("sharedCleanKB", sharedClean);
+    obj.insert("sharedDirtyKB", sharedDirty);
+    obj.insert("privateCleanKB", privateClean);
+    obj.insert("privateDirtyKB", privateDirty);
+    return obj;
+}
+
+QJsonObject PluginMemoryReport::toJson() const
+{
+    QJsonArray list;
+    for (auto&& p : plugins) {
+        list.append(p.toJson());
+    }
+    QJsonObject obj;
+    obj.insert("timestamp", timestamp);
+    obj.insert("processRssKB", processRss);
+    obj.insert("plugins", list);
+    return obj;
+}
+
+void PluginMemoryProbe::setEnabled(bool on)
+{
+    s_enabled.store(on, std::memory_order_relaxed);
+}
+
+qint64 PluginMemoryProbe::heapBytes()
+{
+#if defined(Q_OS_LINUX) && defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    auto&& info = mallinfo2();
+    return static_cast<qint64>(info.uordblks + info.hblkhd);
+#elif defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS_EX pmc {};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&pmc), sizeof(pmc))) {
+        return static_cast<qint64>(pmc.PrivateUsage);
+    }
+    return 0;
+#else
+    return 0;
+#endif
+}
+
+qint64 PluginMemoryProbe::processRss()
+{
+#if defined(Q_OS_LINUX)
+    QFile file("/proc/self/status");
+    if (!file.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    for (auto&& line : file.readAll().split('\n')) {
+        if (line.startsWith("VmRSS:")) {
+            return line.mid(6).trimmed().split(' ').first().toLongLong();
+        }
+    }
+    return 0;
+#elif defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS pmc {};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+        return static_cast<qint64>(pmc.WorkingSetSize / 1024);
+    }
+    return 0;
+#else
+    return 0;
+#endif
+}
+
+QHash<QString, PluginDsoUsage> PluginMemoryProbe::dsoUsage(const QStringList& paths)
+{
+    QHash<QString, PluginDsoUsage> out;
+#if defined(Q_OS_LINUX)
+    QHash<QByteArray, QString> wanted;
+    for (auto&& p : paths) {
+        auto&& canonical = QFileInfo(p).canonicalFilePath();
+        if (!canonical.isEmpty()) {
+            wanted.insert(canonical.toUtf8(), canonical);
+            out.insert(canonical, {});
+        }
+    }
+    if (wanted.isEmpty()) {
+        return out;
+    }
+    QFile file("/proc/self/smaps");
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        return out;
+    }
+    PluginDsoUsage* current = nullptr;
+    for (auto&& line : file.readAll().split('\n')) {
+        if (line.isEmpty()) {
+            continue;
+        }
+        const int colon = line.indexOf(':');
+        const int space = line.indexOf(' ');
+        // 映射头形如 "7f00-7f10 r-xp 00000000 08:01 123  /path/libfoo.so"
+        if (space > 0 && (colon < 0 || colon > space)) {
+            current = nullptr;
+            auto&& fields = line.simplified().split(' ');
+            if (fields.size() >= 6) {
+                auto&& it = wanted.constFind(fields.mid(5).join(' '));
+                if (it != wanted.constEnd()) {
+                    current = &out[it.value()];
+                }
+            }
+            continue;
+        }
+        if (current == nullptr) {
+            continue;
+        }
+        if (line.startsWith("Rss:")) {
+            current->rss += line.mid(4).trimmed().split(' ').first().toLongLong();
+        } else if (line.startsWith("Pss:")) {
+            current->pss += line.mid(4).trimmed().split(' ').first().toLongLong();
+        }
+    }
+#else
+    Q_UNUSED(paths);
+#endif
+    return out;
+}
+
+PluginProcessMemory PluginMemoryProbe::processMemory(qint64 pid)
+{
+    PluginProcessMemory out;
+#if defined(Q_OS_LINUX)
+    QFile file(pid == 0 ? QString("/proc/self/smaps_rollup") : QString("/proc/%1/smaps_rollup").arg(pid));
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        return out;
+    }
+    const std::pair<QByteArray, qint64*> fields[] {
+        { "Rss:", &out.rss },
+        { "Pss:", &out.pss },
+        { "Shared_Clean:", &out.sharedClean },
+        { "Shared_Dirty:", &out.sharedDirty },
+        { "Private_Clean:", &out.privateClean },
+        { "Private_Dirty:", &out.privateDirty },
+    };
+    for (auto&& line : file.readAll().split('\n')) {
+        for (auto&& [key, value] : fields) {
+            if (line.startsWith(key)) {
+                *value = line.mid(key.size()).trimmed().split(' ').first().toLongLong();
+                break;
+            }
+        }
+    }
+#else
+    Q_UNUSED(pid);
+#endif
+    return out;
+}
@@ -0,0 +1,145 @@
+﻿#pragma once
+
+#include <QtCore/qglobal.h>
+
+#ifndef BUILD_STATIC
+#if defined(QPLUGINMANAGER_LIB)
+#define QPLUGINMANAGER_EXPORT Q_DECL_EXPORT
+#else
+#define QPLUGINMANAGER_EXPORT Q_DECL_IMPORT
+#endif
+#else
+#define QPLUGINMANAGER_EXPORT
+#endif
+
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+#include <atomic>
+
+/**
+ * @brief 插件动态库映射的内存占用（KB）
+ */
+struct PluginDsoUsage {
+    qint64 rss = 0;
+    qint64 pss = 0;
+};
+
+/**
+ * @brief 进程内存按共享与私有划分（KB），仅 Linux 可用；fork 出的工作进程中，Shared 为与孕育进程共享的写时复制页
+ */
+struct QPLUGINMANAGER_EXPORT PluginProcessMemory {
+    qint64 rss = 0;
+    qint64 pss = 0;
+    qint64 sharedClean = 0;
+    qint64 sharedDirty = 0;
+    qint64 privateClean = 0;
+    qint64 privateDirty = 0;
+
+    qint64 shared() const
+    {
+        return sharedClean + sharedDirty;
+    }
+
+    qint64 privateBytes() const
+    {
+        return privateClean + privateDirty;
+    }
+
+    QJsonObject toJson() const;
+};
+
+/**
+ * @brief 周期采样点
+ */
+struct PluginMemorySample {
+    qint64 timestamp = 0;
+    qint64 rss = 0;
+    qint64 pss = 0;
+};
+
+/**
+ * @brief 单个插件的内存账目
+ */
+struct QPLUGINMANAGER_EXPORT PluginMemoryInfo {
+    QString name;
+    QString path;
+    /**
+     * @brief 动态库映射占用（KB），仅 Linux 可用
+     */
+    PluginDsoUsage dso;
+    /**
+     * @brief 各阶段堆增量（字节），键为 load/instance/initialize/extensionsInitialize/delayedInitialize。
+     *        取自进程级计数，同一时段内其他线程的分配与释放也计入，多线程运行时只作估计；未启用 PluginMemoryProbe 时为空
+     */
+    QMap<QString, qint64> heapDeltas;
+    /**
+     * @brief 周期采样历史
+     */
+    QList<PluginMemorySample> samples;
+
+    QJsonObject toJson() const;
+};
+
+/**
+ * @brief 内存探测工具
+ */
+class QPLUGINMANAGER_EXPORT PluginMemoryProbe {
+public:
+    /**
+     * @brief 是否在加载、实例化与各初始化阶段记录堆增量（默认读取环境变量 QPLUGIN_HEAP_PROBE）。
+     *        heapBytes 每次调用都遍历全部 arena，关闭时这些路径上不调用
+     * @return
+     */
+    static bool enabled()
+    {
+        return s_enabled.load(std::memory_order_relaxed);
+    }
+
+    static void setEnabled(bool on);
+
+    /**
+     * @brief 当前进程已分配堆字节数（Linux: mallinfo2，Windows: PrivateUsage），为全部线程之和
+     * @return 不支持的平台返回 0
+     */
+    static qint64 heapBytes();
+
+    /**
+     * @brief 当前进程常驻内存（KB）
+     * @return
+     */
+    static qint64 processRss();
+
+    /**
+     * @brief 单次遍历 /proc/self/smaps 统计各动态库的 Rss/Pss
+     * @param paths 动态库路径
+     * @return {规范路径，占用}
+     */
+    static QHash<QString, PluginDsoUsage> dsoUsage(const QStringList& paths);
+
+    /**
+     * @brief 读取 /proc/<pid>/smaps_rollup 统计进程的共享与私有内存
+     * @param pid 进程号，0 为当前进程
+     * @return 进程不存在或平台不支持时全为 0
+     */
+    static PluginProcessMemory processMemory(qint64 pid = 0);
+
+private:
+    static std::atomic_bool s_enabled;
+};
+
+/**
+ * @brief 内存报告
+ */
+struct QPLUGINMANAGER_EXPORT PluginMemoryReport {
+    qint64 timestamp = 0;
+    qint64 processRss = 0;
+    QList<PluginMemoryInfo> plugins;
+
+    QJsonObject toJson() const;
+};
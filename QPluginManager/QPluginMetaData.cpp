@@ -0,0 +1,301 @@
+﻿#include "QPluginMetaData.h"
+
+#include <QJsonArray>
+#include <QJsonValue>
+#include <QPluginLoader>
+#include <QRegularExpression>
+#include <QSet>
+#include <QStringList>
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+/**
+ * @brief 已解析为字段的键，其余归入 custom
+ */
+const QStringList& knownKeys()
+{
+    static const QStringList keys {
+        "Name", "Interface", "Version", "CompatVersion", "Experimental",
+        "DisabledByDefault", "Required", "ThreadAffinity", "Descriptions",
+        "Dependencies", "Bundle", "Class", "PerThread"
+    };
+    return keys;
+}
+
+/**
+ * @brief 按包内依赖排序，被依赖项在前；包外依赖不参与排序，循环依赖的项保持声明顺序
+ * @param entries 声明顺序
+ * @return
+ */
+QList<PluginMetaData> sortByDependencies(const QList<PluginMetaData>& entries)
+{
+    QSet<QString> names;
+    for (auto&& m : entries) {
+        names.insert(m.name);
+    }
+    QList<PluginMetaData> sorted;
+    sorted.reserve(entries.size());
+    QSet<QString> placed;
+    std::vector<bool> done(entries.size(), false);
+    bool progressed = true;
+    while (progressed && sorted.size() < entries.size()) {
+        progressed = false;
+        for (int i = 0; i < entries.size(); i++) {
+            if (done[i]) {
+                continue;
+            }
+            auto&& m = entries[i];
+            const bool ready = std::all_of(m.dependencies.cbegin(), m.dependencies.cend(), [&](const QString& dep) {
+                return dep == m.name || !names.contains(dep) || placed.contains(dep);
+            });
+            if (ready) {
+                sorted.append(m);
+                placed.insert(m.name);
+                done[i] = true;
+                progressed = true;
+            }
+        }
+    }
+    for (int i = 0; i < entries.size(); i++) {
+        if (!done[i]) {
+            sorted.append(entries[i]);
+        }
+    }
+    return sorted;
+}
+}
+
+PluginVersion PluginVersion::parse(const QString& text)
+{
+    static const QRegularExpression re("^\\s*v?(\\d+)(?:\\.(\\d+))?(?:\\.(\\d+))?");
+    PluginVersion v;
+    auto&& match = re.match(text);
+    if (match.hasMatch()) {
+        v.major = match.captured(1).toInt();
+        v.minor = match.captured(2).toInt();
+        v.patch = match.captured(3).toInt();
+    }
+    return v;
+}
+
+QString PluginVersion::toString() const
+{
+    return QString("%1.%2.%3").arg(major).arg(minor).arg(patch);
+}
+
+PluginMetaData PluginMetaData::fromJson(const QJsonObject& meta, const QString& path)
+{
+    PluginMetaData m;
+    m.path = path;
+    m.name = meta.value("Name").toString();
+    m.interfaceName = meta.value("Interface").toString();
+    m.version = PluginVersion::parse(meta.value("Version").toString());
+    m.compatVersion = PluginVersion::parse(meta.value("CompatVersion").toString());
+    m.experimental = meta.value("Experimental").toBool();
+    m.disabledByDefault = meta.value("DisabledByDefault").toBool();
+    m.required = meta.value("Required").toBool();
+    m.threadAffinity = meta.value("ThreadAffinity").toString();
+    m.perThread = meta.value("PerThread").toBool();
+    for (auto&& dep : meta.value("Dependencies").toArray()) {
+        m.dependencies.append(dep.toString());
+    }
+    m.bundle = meta.value("Bundle").toString();
+    m.className = meta.value("Class").toString();
+    auto&& desc = meta.value("Descriptions").toObject();
+    m.category = desc.value("Category").toString();
+    m.vendor = desc.value("Vendor").toString();
+    m.copyright = desc.value("Copyright").toString();
+    m.license = desc.value("License").toString();
+    m.description = desc.value("Description").toString();
+    m.longDescription = desc.value("LongDescription").toString();
+    m.url = desc.value("Url").toString();
+    for (auto it = meta.begin(); it != meta.end(); ++it) {
+        if (!knownKeys().contains(it.key())) {
+            m.custom.insert(it.key(), it.value());
+        }
+    }
+    return m;
+}
+
+QList<PluginMetaData> PluginMetaData::fromJsonList(const QJsonObject& meta, const QString& path)
+{
+    auto&& plugins = meta.value("Plugins");
+    if (!plugins.isArray()) {
+        return { fromJson(meta, path) };
+    }
+    // 包级字段（Version、Descriptions 等）作为各项缺省值
+    QJsonObject defaults = meta;
+    defaults.remove("Name");
+    defaults.remove("Plugins");
+    defaults.remove("Dependencies");
+    defaults.remove("Class");
+    defaults.insert("Interface", "PluginInterface");
+    defaults.insert("Bundle", meta.value("Name"));
+    QList<PluginMetaData> entries;
+    for (auto&& value : plugins.toArray()) {
+        auto&& obj = value.toObject();
+        QJsonObject entry = defaults;
+        for (auto it = obj.begin(); it != obj.end(); ++it) {
+            entry.insert(it.key(), it.value());
+        }
+        auto&& m = fromJson(entry, path);
+        if (m.className.isEmpty()) {
+            m.className = m.name;
+        }
+        entries.append(m);
+    }
+    return sortByDependencies(entries);
+}
+
+PluginMetaData PluginMetaData::read(const QString& path)
+{
+    QPluginLoader loader(path);
+    return fromJson(loader.metaData().value("MetaData").toObject(), path);
+}
+
+QList<PluginMetaData> PluginMetaData::readAll(const QString& path)
+{
+    QPluginLoader loader(path);
+    QList<PluginMetaData> out;
+    for (auto&& m : fromJsonList(loader.metaData().value("MetaData").toObject(), path)) {
+        if (m.isValid()) {
+            out.append(m);
+        }
+    }
+    return out;
+}
+
+QJsonObject PluginMetaData::toJson() const
+{
+    QJsonObject desc;
+    desc.insert("Category", category);
+    desc.insert("Vendor", vendor);
+    desc.insert("Copyright", copyright);
+    desc.insert("License", license);
+    desc.insert("Description", description);
+    desc.insert("LongDescription", longDescription);
+    desc.insert("Url", url);
+    QJsonObject obj = custom;
+    obj.insert("Path", path);
+    obj.insert("Name", name);
+    obj.insert("Interface", interfaceName);
+    obj.insert("Version", version.toString());
+    obj.insert("CompatVersion", compatVersion.toString());
+    obj.insert("Experimental", experimental);
+    obj.insert("DisabledByDefault", disabledByDefault);
+    obj.insert("Required", required);
+    obj.insert("ThreadAffinity", threadAffinity);
+    obj.insert("PerThread", perThread);
+    obj.insert("Dependencies", QJsonArray::fromStringList(dependencies));
+    if (!bundle.isEmpty()) {
+        obj.insert("Bundle", bundle);
+    }
+    if (!className.isEmpty()) {
+        obj.insert("Class", className);
+    }
+    obj.insert("Descriptions", desc);
+    return obj;
+}
+
+void PluginCatalog::insert(const PluginMetaData& meta)
+{
+    auto it = _byPath.constFind(meta.path);
+    while (it != _byPath.cend() && it.key() == meta.path && _items[it.value()].name != meta.name) {
+        ++it;
+    }
+    if (it == _byPath.cend() || it.key() != meta.path) {
+        _items.append(meta);
+        index(static_cast<int>(_items.size()) - 1);
+        return;
+    }
+    // 同一文件重新读取：替换后重建二级索引
+    _items[it.value()] = meta;
+    _byPath.clear();
+    _byName.clear();
+    _byCategory.clear();
+    _byVendor.clear();
+    _byVersion.clear();
+    for (int i = 0; i < static_cast<int>(_items.size()); i++) {
+        index(i);
+    }
+}
+
+void PluginCatalog::clear()
+{
+    _items.clear();
+    _byPath.clear();
+    _byName.clear();
+    _byCategory.clear();
+    _byVendor.clear();
+    _byVersion.clear();
+}
+
+const PluginMetaData* PluginCatalog::find(const QString& name) const
+{
+    const PluginMetaData* best = nullptr;
+    for (auto it = _byName.constFind(name); it != _byName.cend() && it.key() == name; ++it) {
+        auto&& m = _items[it.value()];
+        if (best == nullptr || best->version < m.version) {
+            best = &m;
+        }
+    }
+    return best;
+}
+
+const PluginMetaData* PluginCatalog::findByPath(const QString& path) const
+{
+    int first = -1;
+    for (auto it = _byPath.constFind(path); it != _byPath.cend() && it.key() == path; ++it) {
+        if (first < 0 || it.value() < first) {
+            first = it.value();
+        }
+    }
+    return first < 0 ? nullptr : &_items[first];
+}
+
+QList<PluginMetaData> PluginCatalog::byCategory(const QString& category) const
+{
+    return collect(_byCategory.values(category.toLower()));
+}
+
+QList<PluginMetaData> PluginCatalog::byVendor(const QString& vendor) const
+{
+    return collect(_byVendor.values(vendor.toLower()));
+}
+
+QList<PluginMetaData> PluginCatalog::inVersionRange(const PluginVersion& min, const PluginVersion& max, const QString& name) const
+{
+    QList<PluginMetaData> out;
+    for (auto it = _byVersion.lowerBound(min); it != _byVersion.cend() && it.key() <= max; ++it) {
+        auto&& m = _items[it.value()];
+        if (name.isEmpty() || m.name == name) {
+            out.append(m);
+        }
+    }
+    return out;
+}
+
+void PluginCatalog::index(int i)
+{
+    auto&& m = _items[i];
+    _byPath.insert(m.path, i);
+    _byName.insert(m.name, i);
+    _byCategory.insert(m.category.toLower(), i);
+    _byVendor.insert(m.vendor.toLower(), i);
+    _byVersion.insert(m.version, i);
+}
+
+QList<PluginMetaData> PluginCatalog::collect(const QList<int>& indexes) const
+{
+    // QMultiHash::values 为插入逆序，恢复插入顺序
+    QList<int> sorted = indexes;
+    std::sort(sorted.begin(), sorted.end());
+    QList<PluginMetaData> out;
+    out.reserve(sorted.size());
+    for (auto&& i : sorted) {
+        out.append(_items[i]);
+    }
+    return out;
+}
@@ -0,0 +1,197 @@
+﻿#pragma once
+
+#include <QtCore/qglobal.h>
+
+#ifndef BUILD_STATIC
+#if defined(QPLUGINMANAGER_LIB)
+#define QPLUGINMANAGER_EXPORT Q_DECL_EXPORT
+#else
+#define QPLUGINMANAGER_EXPORT Q_DECL_IMPORT
+#endif
+#else
+#define QPLUGINMANAGER_EXPORT
+#endif
+
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QMultiHash>
+#include <QMultiMap>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief 插件版本号 major.minor.patch，缺省部分为 0，后缀（如 -beta）忽略
+ */
+struct QPLUGINMANAGER_EXPORT PluginVersion {
+    int major = 0;
+    int minor = 0;
+    int patch = 0;
+
+    static PluginVersion parse(const QString& text);
+    QString toString() const;
+
+    friend bool operator<(const PluginVersion& a, const PluginVersion& b)
+    {
+        if (a.major != b.major) {
+            return a.major < b.major;
+        }
+        if (a.minor != b.minor) {
+            return a.minor < b.minor;
+        }
+        return a.patch < b.patch;
+    }
+    friend bool operator==(const PluginVersion& a, const PluginVersion& b)
+    {
+        return a.major == b.major && a.minor == b.minor && a.patch == b.patch;
+    }
+    friend bool operator<=(const PluginVersion& a, const PluginVersion& b) { return !(b < a); }
+};
+
+/**
+ * @brief 解析后的插件元信息（MetaData）
+ */
+struct QPLUGINMANAGER_EXPORT PluginMetaData {
+    QString path;
+    QString name;
+    /**
+     * @brief Interface 字段（Windows 头文件把 interface 定义为宏，故不直接用作字段名）
+     */
+    QString interfaceName;
+    PluginVersion version;
+    PluginVersion compatVersion;
+    bool experimental = false;
+    bool disabledByDefault = false;
+    bool required = false;
+    QString threadAffinity;
+    /**
+     * @brief PerThread 字段：各调用线程经 load 取得各自的实例，需以 AUTO_REGISTER 注册 Class 的工厂
+     */
+    bool perThread = false;
+    /**
+     * @brief Dependencies 字段，依赖的插件名
+     */
+    QStringList dependencies;
+    /**
+     * @brief 所在插件包名，独立插件为空
+     */
+    QString bundle;
+    /**
+     * @brief StaticRegistry<PluginInterface> 中的工厂键（Class 字段）；插件包内缺省为 name，独立插件缺省为实例类名
+     */
+    QString className;
+    /**
+     * @brief Descriptions 字段
+     */
+    QString category;
+    QString vendor;
+    QString copyright;
+    QString license;
+    QString description;
+    QString longDescription;
+    QString url;
+    /**
+     * @brief 以上之外的自定义键
+     */
+    QJsonObject custom;
+
+    /**
+     * @brief 由 QPluginLoader::metaData() 中的 MetaData 解析
+     * @param meta MetaData 对象
+     * @param path 插件文件路径
+     * @return
+     */
+    static PluginMetaData fromJson(const QJsonObject& meta, const QString& path);
+
+    /**
+     * @brief 解析 MetaData 中声明的全部插件：插件包按 Plugins 数组逐项解析，包级字段作为各项缺省值，
+     *        包内依赖排在被依赖项之后；独立插件返回单项
+     * @param meta MetaData 对象
+     * @param path 插件文件路径
+     * @return
+     */
+    static QList<PluginMetaData> fromJsonList(const QJsonObject& meta, const QString& path);
+
+    /**
+     * @brief 读取插件文件的元信息，不加载插件
+     * @param path 插件文件路径
+     * @return 不是插件时 isValid 为 false
+     */
+    static PluginMetaData read(const QString& path);
+
+    /**
+     * @brief 读取插件文件中声明的全部插件，不加载插件
+     * @param path 插件文件路径
+     * @return 只含有效项，不是插件时为空
+     */
+    static QList<PluginMetaData> readAll(const QString& path);
+
+    bool isValid() const { return !name.isEmpty() && interfaceName == "PluginInterface"; }
+
+    QJsonObject toJson() const;
+};
+
+/**
+ * @brief 插件元信息目录，按名称、路径、分类、厂商与版本建立索引，查询无需加载插件
+ */
+class QPLUGINMANAGER_EXPORT PluginCatalog {
+public:
+    /**
+     * @brief 插入或按路径与名称替换（插件包的各项共用路径）
+     * @param meta
+     */
+    void insert(const PluginMetaData& meta);
+
+    void clear();
+
+    int size() const { return static_cast<int>(_items.size()); }
+
+    /**
+     * @brief 按名称查找，同名多个版本时返回版本最高者
+     * @param name
+     * @return 不存在时为空
+     */
+    const PluginMetaData* find(const QString& name) const;
+
+    /**
+     * @brief 按路径查找，插件包返回第一项
+     * @param path
+     * @return 不存在时为空
+     */
+    const PluginMetaData* findByPath(const QString& path) const;
+
+    /**
+     * @brief 按分类查询（大小写不敏感）
+     */
+    QList<PluginMetaData> byCategory(const QString& category) const;
+
+    /**
+     * @brief 按厂商查询（大小写不敏感）
+     */
+    QList<PluginMetaData> byVendor(const QString& vendor) const;
+
+    /**
+     * @brief 版本在闭区间 [min, max] 内的插件，按版本升序
+     * @param min
+     * @param max
+     * @param name 非空时只匹配该名称
+     * @return
+     */
+    QList<PluginMetaData> inVersionRange(const PluginVersion& min, const PluginVersion& max, const QString& name = QString()) const;
+
+    /**
+     * @brief 全部元信息，按插入顺序
+     */
+    const QList<PluginMetaData>& all() const { return _items; }
+
+private:
+    void index(int i);
+    QList<PluginMetaData> collect(const QList<int>& indexes) const;
+
+    QList<PluginMetaData> _items;
+    QMultiHash<QString, int> _byPath;
+    QMultiHash<QString, int> _byName;
+    QMultiHash<QString, int> _byCategory;
+    QMultiHash<QString, int> _byVendor;
+    QMultiMap<PluginVersion, int> _byVersion;
+};
@@ -0,0 +1,194 @@
+﻿#include "QPluginPrefetch.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+
+#include "QPluginMetrics.h"
+
+#include <algorithm>
+#include <climits>
+
+#if defined(Q_OS_UNIX)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+QJsonObject PluginPrefetchReport::toJson() const
+{
+    QJsonArray list;
+    for (auto&& e : entries) {
+        QJsonObject obj;
+        obj.insert("path", e.path);
+        obj.insert("bytes", e.bytes);
+        obj.insert("prefetchUs", e.prefetchUs);
+        obj.insert("loadUs", e.loadUs);
+        obj.insert("warm", e.warm);
+        list.append(obj);
+    }
+    QJsonObject obj;
+    obj.insert("files", files);
+    obj.insert("bytes", bytes);
+    obj.insert("prefetchUs", prefetchUs);
+    obj.insert("loadUs", loadUs);
+    obj.insert("warmPrefetchUs", warmPrefetchUs);
+    obj.insert("entries", list);
+    return obj;
+}
+
+PluginPrefetcher::~PluginPrefetcher()
+{
+    cancel();
+}
+
+void PluginPrefetcher::prefetch(const QStringList& paths)
+{
+    std::lock_guard lock(_mtx);
+    for (auto&& path : paths) {
+        if (_queued.contains(path) || entry(path).prefetchUs >= 0) {
+            continue;
+        }
+        _queue.push_back(path);
+        _queued.insert(path);
+    }
+    if (_running || _queue.empty()) {
+        return;
+    }
+    // 上一轮线程已结束，回收后重新启动
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+    _stop = false;
+    _running = true;
+    _thread = std::thread(&PluginPrefetcher::run, this);
+}
+
+void PluginPrefetcher::cancel()
+{
+    {
+        std::lock_guard lock(_mtx);
+        _stop = true;
+        _queue.clear();
+        _queued.clear();
+    }
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+bool PluginPrefetcher::beginLoad(const QString& path)
+{
+    std::lock_guard lock(_mtx);
+    auto it = _index.find(path);
+    return it != _index.end() && _entries[it.value()].prefetchUs >= 0;
+}
+
+void PluginPrefetcher::endLoad(const QString& path, bool warm, qint64 us)
+{
+    std::lock_guard lock(_mtx);
+    auto&& e = entry(path);
+    e.loadUs = us;
+    e.warm = warm;
+}
+
+PluginPrefetchReport PluginPrefetcher::report() const
+{
+    std::lock_guard lock(_mtx);
+    PluginPrefetchReport report;
+    report.entries = _entries;
+    report.prefetchUs = _wallUs;
+    for (auto&& e : _entries) {
+        if (e.prefetchUs >= 0) {
+            ++report.files;
+            report.bytes += e.bytes;
+        }
+        if (e.loadUs >= 0) {
+            report.loadUs += e.loadUs;
+            if (e.warm) {
+                report.warmPrefetchUs += e.prefetchUs;
+            }
+        }
+    }
+    return report;
+}
+
+qint64 PluginPrefetcher::prefetchFile(const QString& path)
+{
+#if defined(Q_OS_UNIX)
+    const int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return -1;
+    }
+#if defined(Q_OS_LINUX)
+    // readahead 在读入页缓存后返回，耗时即 I/O 时间；不支持的文件系统退回 fadvise
+    if (::readahead(fd, 0, static_cast<size_t>(st.st_size)) != 0) {
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    }
+#elif defined(Q_OS_MACOS)
+    radvisory advice { 0, static_cast<int>(std::min<off_t>(st.st_size, INT_MAX)) };
+    ::fcntl(fd, F_RDADVISE, &advice);
+#else
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+#endif
+    ::close(fd);
+    return static_cast<qint64>(st.st_size);
+#else
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    // 无预读接口时顺序读一遍，数据留在系统文件缓存
+    constexpr qint64 chunk = 1 << 20;
+    QByteArray buffer(chunk, Qt::Uninitialized);
+    while (file.read(buffer.data(), chunk) > 0) { }
+    return file.size();
+#endif
+}
+
+void PluginPrefetcher::run()
+{
+    QElapsedTimer wall;
+    wall.start();
+    std::unique_lock lock(_mtx);
+    while (!_stop && !_queue.empty()) {
+        const QString path = _queue.front();
+        _queue.pop_front();
+        lock.unlock();
+
+        QElapsedTimer timer;
+        timer.start();
+        const auto bytes = prefetchFile(path);
+        const auto us = timer.nsecsElapsed() / 1000;
+        if (PluginMetrics::enabled()) {
+            static auto& files = PluginMetrics::Instance().histogram("manager.prefetch", "file");
+            files.record(static_cast<std::uint64_t>(us));
+        }
+
+        lock.lock();
+        _queued.remove(path);
+        // 打开失败的文件保持未预读状态
+        if (bytes >= 0) {
+            auto&& e = entry(path);
+            e.bytes = bytes;
+            e.prefetchUs = us;
+        }
+    }
+    _wallUs += wall.nsecsElapsed() / 1000;
+    _running = false;
+}
+
+PluginPrefetchEntry& PluginPrefetcher::entry(const QString& path)
+{
+    auto it = _index.find(path);
+    if (it == _index.end()) {
+        it = _index.insert(path, _entries.size());
+        _entries.append(PluginPrefetchEntry { path });
+    }
+    return _entries[it.value()];
+}
@@ -0,0 +1,133 @@
+﻿#pragma once
+
+#include <QtCore/qglobal.h>
+
+#ifndef BUILD_STATIC
+#if defined(QPLUGINMANAGER_LIB)
+#define QPLUGINMANAGER_EXPORT Q_DECL_EXPORT
+#else
+#define QPLUGINMANAGER_EXPORT Q_DECL_IMPORT
+#endif
+#else
+#define QPLUGINMANAGER_EXPORT
+#endif
+
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+#include <deque>
+#include <mutex>
+#include <thread>
+
+/**
+ * @brief 单个插件文件的预读与加载耗时（微秒）
+ */
+struct PluginPrefetchEntry {
+    QString path;
+    qint64 bytes = 0;
+    /**
+     * @brief 预读耗时，未完成或失败时为 -1
+     */
+    qint64 prefetchUs = -1;
+    /**
+     * @brief 元信息解析与 QPluginLoader::load 耗时，未加载时为 -1
+     */
+    qint64 loadUs = -1;
+    /**
+     * @brief 加载开始时预读是否已完成
+     */
+    bool warm = false;
+};
+
+/**
+ * @brief 预读报告
+ */
+struct QPLUGINMANAGER_EXPORT PluginPrefetchReport {
+    qint64 files = 0;
+    qint64 bytes = 0;
+    /**
+     * @brief 后台线程预读总耗时
+     */
+    qint64 prefetchUs = 0;
+    /**
+     * @brief 主线程加载总耗时
+     */
+    qint64 loadUs = 0;
+    /**
+     * @brief 加载前已完成预读的文件在后台线程上的预读耗时之和；是移出主线程的 I/O 时间的上界估计，
+     *        不是实测的加载提速，实际收益以 warm 与冷加载的 loadUs 对比为准
+     */
+    qint64 warmPrefetchUs = 0;
+    QList<PluginPrefetchEntry> entries;
+
+    QJsonObject toJson() const;
+};
+
+/**
+ * @brief 插件文件页缓存预读：按预计加载顺序在后台线程对插件文件发起 readahead/posix_fadvise，主线程继续加载
+ */
+class QPLUGINMANAGER_EXPORT PluginPrefetcher {
+public:
+    PluginPrefetcher() = default;
+    ~PluginPrefetcher();
+
+    PluginPrefetcher(const PluginPrefetcher&) = delete;
+    PluginPrefetcher& operator=(const PluginPrefetcher&) = delete;
+
+    /**
+     * @brief 追加预读文件（已排队或已预读的忽略，被取消或打开失败的重新排队），后台线程空闲时启动
+     * @param paths 按预计加载顺序排列的文件路径
+     */
+    void prefetch(const QStringList& paths);
+
+    /**
+     * @brief 丢弃未开始的预读并等待后台线程退出
+     */
+    void cancel();
+
+    /**
+     * @brief 加载开始前调用
+     * @param path 文件路径
+     * @return 该文件是否已预读完成
+     */
+    bool beginLoad(const QString& path);
+
+    /**
+     * @brief 记录加载耗时
+     * @param path 文件路径
+     * @param warm beginLoad 的返回值
+     * @param us 加载耗时
+     */
+    void endLoad(const QString& path, bool warm, qint64 us);
+
+    PluginPrefetchReport report() const;
+
+    /**
+     * @brief 预读单个文件到页缓存（Linux: readahead，其他 POSIX: posix_fadvise，其余平台顺序读取）
+     * @param path 文件路径
+     * @return 文件字节数，失败返回 -1
+     */
+    static qint64 prefetchFile(const QString& path);
+
+private:
+    void run();
+
+    PluginPrefetchEntry& entry(const QString& path);
+
+    mutable std::mutex _mtx;
+    std::deque<QString> _queue;
+    /**
+     * @brief 排队或正在预读的文件
+     */
+    QSet<QString> _queued;
+    QHash<QString, int> _index;
+    QList<PluginPrefetchEntry> _entries;
+    qint64 _wallUs = 0;
+    bool _running = false;
+    bool _stop = false;
+    std::thread _thread;
+};
@@ -0,0 +1,75 @@
+﻿#include "QPluginScanner.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+
+namespace {
+/**
+ * @brief 修改时间距扫描时刻小于该值的目录不记录修改时间：文件系统时间精度有限（FAT 为 2 秒），
+ *        同一时间片内的后续修改不会改变修改时间
+ */
+constexpr qint64 MTIME_GRANULARITY_MS = 2000;
+}
+
+QJsonObject PluginScanStats::toJson() const
+{
+    QJsonObject obj;
+    obj.insert("directories", directories);
+    obj.insert("listed", listed);
+    obj.insert("files", files);
+    obj.insert("skipped", skipped);
+    obj.insert("candidates", candidates);
+    obj.insert("loaded", loaded);
+    obj.insert("elapsedUs", elapsedUs);
+    return obj;
+}
+
+PluginDirectoryScanner::PluginDirectoryScanner(const QString& suffix)
+    : _suffix(suffix)
+{
+}
+
+void PluginDirectoryScanner::scan(const QString& path, bool recursive, QStringList& out, PluginScanStats& stats)
+{
+    // 先读修改时间再列举，列举期间的修改留到下次扫描
+    const QFileInfo dirInfo(path);
+    if (!dirInfo.isDir()) {
+        _dirs.remove(path);
+        return;
+    }
+    stats.directories++;
+    const auto mtime = dirInfo.lastModified().toMSecsSinceEpoch();
+    auto&& dir = _dirs[path];
+    const bool changed = dir.mtime < 0 || dir.mtime != mtime;
+    if (changed) {
+        stats.listed++;
+        dir.entries.clear();
+        for (auto&& p : QDir(path).entryList(QDir::AllEntries | QDir::NoDotAndDotDot)) {
+            QFileInfo fi(path + "/" + p);
+            if (fi.isDir()) {
+                dir.entries.push_back({ fi.filePath(), true });
+            } else if (fi.isFile() && fi.suffix() == _suffix) {
+                dir.entries.push_back({ fi.filePath(), false });
+            }
+        }
+        dir.mtime = QDateTime::currentMSecsSinceEpoch() - mtime < MTIME_GRANULARITY_MS ? -1 : mtime;
+    }
+    // 递归会插入 _dirs，先复制条目
+    const auto entries = dir.entries;
+    for (auto&& entry : entries) {
+        if (entry.dir) {
+            if (recursive) {
+                this->scan(entry.path, recursive, out, stats);
+            }
+            continue;
+        }
+        stats.files++;
+        out.append(entry.path);
+    }
+}
+
+void PluginDirectoryScanner::clear()
+{
+    _dirs.clear();
+}
@@ -0,0 +1,96 @@
+﻿#pragma once
+
+#include <QtCore/qglobal.h>
+
+#ifndef BUILD_STATIC
+#if defined(QPLUGINMANAGER_LIB)
+#define QPLUGINMANAGER_EXPORT Q_DECL_EXPORT
+#else
+#define QPLUGINMANAGER_EXPORT Q_DECL_IMPORT
+#endif
+#else
+#define QPLUGINMANAGER_EXPORT
+#endif
+
+#include <QHash>
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+
+#include <vector>
+
+/**
+ * @brief 一次目录扫描的计数
+ */
+struct QPLUGINMANAGER_EXPORT PluginScanStats {
+    /**
+     * @brief 检查过修改时间的目录数
+     */
+    int directories = 0;
+    /**
+     * @brief 修改时间变化（或首次扫描）而重新列举的目录数
+     */
+    int listed = 0;
+    /**
+     * @brief 目录中的插件文件数
+     */
+    int files = 0;
+    /**
+     * @brief 已加载或此前被拒绝、未再读取的文件数
+     */
+    int skipped = 0;
+    /**
+     * @brief 交给 loadPlugin 的文件数
+     */
+    int candidates = 0;
+    /**
+     * @brief 新加载的插件数（插件包按项计）
+     */
+    int loaded = 0;
+    qint64 elapsedUs = 0;
+
+    QJsonObject toJson() const;
+};
+
+/**
+ * @brief 增量目录扫描：记录各目录的修改时间与其中的条目，修改时间未变的目录直接使用上次的条目，
+ *        不再列举目录、逐个读取文件属性。目录修改时间只随直接条目的增删改名变化，子目录仍逐个检查修改时间
+ */
+class QPLUGINMANAGER_EXPORT PluginDirectoryScanner {
+public:
+    /**
+     * @param suffix 插件文件后缀
+     */
+    explicit PluginDirectoryScanner(const QString& suffix);
+
+    /**
+     * @brief 扫描目录，插件文件的顺序与逐级 QDir::entryList 相同
+     * @param path 目录
+     * @param recursive 是否递归子目录
+     * @param out 追加插件文件路径
+     * @param stats 累加目录与文件计数
+     */
+    void scan(const QString& path, bool recursive, QStringList& out, PluginScanStats& stats);
+
+    /**
+     * @brief 清除全部目录记录，下次扫描重新列举
+     */
+    void clear();
+
+private:
+    struct Entry {
+        QString path;
+        bool dir = false;
+    };
+
+    struct Directory {
+        /**
+         * @brief 列举时的修改时间（毫秒），-1 表示下次必须重新列举
+         */
+        qint64 mtime = -1;
+        std::vector<Entry> entries;
+    };
+
+    QString _suffix;
+    QHash<QString, Directory> _dirs;
+};
@@ -0,0 +1,627 @@
+﻿#include "QPluginScheduler.h"
+
+#include <QJsonArray>
+#include <QThread>
+
+#include "QPluginLogging.h"
+#include "QPluginManager.h"
+#include "QPluginMetrics.h"
+
+#include <algorithm>
+#include <exception>
+#include <iterator>
+
+#if defined(Q_OS_WIN)
+#include <Windows.h>
+#else
+#include <ctime>
+#endif
+
+/**
+ * @brief 插件分组：取消标记与计数；取消与开始执行在同一把锁下判断，取消返回后不会再有任务开始
+ */
+struct PluginTaskGroup {
+    QString plugin;
+    std::mutex mtx;
+    std::condition_variable idle;
+    bool cancelled = false;
+    std::size_t running = 0;
+    std::atomic<std::uint64_t> submitted { 0 };
+    std::atomic<std::uint64_t> finished { 0 };
+    std::atomic<std::uint64_t> cancelledTasks { 0 };
+    std::atomic<std::uint64_t> failed { 0 };
+    std::atomic<std::uint64_t> cpuNs { 0 };
+    std::atomic<std::uint64_t> wallNs { 0 };
+    /**
+     * @brief 任务耗时直方图，首个任务完成时解析；并发解析得到同一对象
+     */
+    std::atomic<MetricHistogram*> metric { nullptr };
+
+    PluginTaskGroupStats stats()
+    {
+        PluginTaskGroupStats s;
+        s.plugin = plugin;
+        s.submitted = submitted.load(std::memory_order_relaxed);
+        s.finished = finished.load(std::memory_order_relaxed);
+        s.cancelled = cancelledTasks.load(std::memory_order_relaxed);
+        s.failed = failed.load(std::memory_order_relaxed);
+        s.cpuNs = cpuNs.load(std::memory_order_relaxed);
+        s.wallNs = wallNs.load(std::memory_order_relaxed);
+        std::lock_guard lock(mtx);
+        s.running = running;
+        return s;
+    }
+};
+
+/**
+ * @brief 任务控制块，句柄、队列与前序任务共同持有
+ */
+struct PluginTaskState {
+    std::function<void()> fun;
+    std::shared_ptr<PluginTaskGroup> group;
+    PluginTaskPriority priority = PluginTaskPriority::Normal;
+    /**
+     * @brief 所属调度器，后续任务经它提交
+     */
+    PluginScheduler* scheduler = nullptr;
+    std::atomic<PluginTaskStatus> status { PluginTaskStatus::Pending };
+    std::atomic_bool cancelRequested { false };
+    mutable std::mutex mtx;
+    mutable std::condition_variable cv;
+    /**
+     * @brief 尚未提交的后续任务，任务结束后清空
+     */
+    std::vector<std::shared_ptr<PluginTaskState>> continuations;
+    bool done = false;
+};
+
+namespace {
+thread_local PluginTaskState* t_task = nullptr;
+thread_local const PluginScheduler* t_scheduler = nullptr;
+thread_local int t_worker = -1;
+
+void accumulate(PluginTaskGroupStats& to, const PluginTaskGroupStats& from)
+{
+    to.submitted += from.submitted;
+    to.finished += from.finished;
+    to.cancelled += from.cancelled;
+    to.failed += from.failed;
+    to.running += from.running;
+    to.cpuNs += from.cpuNs;
+    to.wallNs += from.wallNs;
+}
+}
+
+PluginTaskStatus PluginTask::status() const
+{
+    return _state ? _state->status.load(std::memory_order_acquire) : PluginTaskStatus::Cancelled;
+}
+
+bool PluginTask::isDone() const
+{
+    if (!_state) {
+        return true;
+    }
+    std::lock_guard lock(_state->mtx);
+    return _state->done;
+}
+
+bool PluginTask::cancel()
+{
+    if (!_state) {
+        return false;
+    }
+    _state->cancelRequested.store(true, std::memory_order_release);
+    auto expected = PluginTaskStatus::Pending;
+    if (!_state->status.compare_exchange_strong(expected, PluginTaskStatus::Cancelled, std::memory_order_acq_rel)) {
+        return expected == PluginTaskStatus::Cancelled;
+    }
+    // 仍在队列中的控制块由工作线程取出时丢弃
+    _state->scheduler->finish(_state, PluginTaskStatus::Cancelled);
+    return true;
+}
+
+void PluginTask::wait() const
+{
+    if (!_state) {
+        return;
+    }
+    std::unique_lock lock(_state->mtx);
+    _state->cv.wait(lock, [this]() { return _state->done; });
+}
+
+bool PluginTask::waitFor(qint64 ms) const
+{
+    if (!_state) {
+        return true;
+    }
+    std::unique_lock lock(_state->mtx);
+    return _state->cv.wait_for(lock, std::chrono::milliseconds(ms), [this]() { return _state->done; });
+}
+
+PluginTask PluginTask::then(std::function<void()> fun, PluginTaskPriority priority) const
+{
+    if (!_state) {
+        return PluginTask();
+    }
+    auto next = std::make_shared<PluginTaskState>();
+    next->fun = std::move(fun);
+    next->group = _state->group;
+    next->priority = priority;
+    next->scheduler = _state->scheduler;
+    next->group->submitted.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard lock(_state->mtx);
+        if (!_state->done) {
+            _state->continuations.push_back(next);
+            return PluginTask(next);
+        }
+    }
+    // 前序任务已结束
+    if (_state->status.load(std::memory_order_acquire) == PluginTaskStatus::Cancelled) {
+        next->status.store(PluginTaskStatus::Cancelled, std::memory_order_release);
+        next->scheduler->finish(next, PluginTaskStatus::Cancelled);
+    } else {
+        next->scheduler->enqueue(next);
+    }
+    return PluginTask(next);
+}
+
+QJsonObject PluginSchedulerStats::toJson() const
+{
+    QJsonArray list;
+    for (auto&& g : groups) {
+        QJsonObject obj;
+        obj.insert("plugin", g.plugin);
+        obj.insert("submitted", static_cast<qint64>(g.submitted));
+        obj.insert("finished", static_cast<qint64>(g.finished));
+        obj.insert("cancelled", static_cast<qint64>(g.cancelled));
+        obj.insert("failed", static_cast<qint64>(g.failed));
+        obj.insert("running", static_cast<qint64>(g.running));
+        obj.insert("cpuMs", static_cast<double>(g.cpuNs) / 1e6);
+        obj.insert("wallMs", static_cast<double>(g.wallNs) / 1e6);
+        list.append(obj);
+    }
+    QJsonObject obj;
+    obj.insert("workers", workers);
+    obj.insert("steals", static_cast<qint64>(steals));
+    obj.insert("groups", list);
+    return obj;
+}
+
+PluginScheduler::PluginScheduler(QPluginManager* context)
+    : _context(context)
+{
+}
+
+PluginScheduler::~PluginScheduler()
+{
+    shutdown();
+}
+
+void PluginScheduler::setWorkerCount(int count)
+{
+    _workerCount = std::max(count, 0);
+}
+
+int PluginScheduler::workerCount() const
+{
+    const int active = _active.load(std::memory_order_acquire);
+    return active > 0 ? active : (_workerCount > 0 ? _workerCount : std::max(1, QThread::idealThreadCount()));
+}
+
+void PluginScheduler::start()
+{
+    std::call_once(_started, [this]() {
+        const int count = workerCount();
+        for (int i = 0; i < count; i++) {
+            _workers.push_back(std::make_unique<Worker>());
+        }
+        for (int i = 0; i < count; i++) {
+            _workers[i]->thread = std::thread(&PluginScheduler::run, this, i);
+        }
+        _active.store(count, std::memory_order_release);
+        qCInfo(lcPluginManager) << "插件调度器启动，工作线程:" << count;
+    });
+}
+
+PluginTask PluginScheduler::submit(const QString& plugin, std::function<void()> fun, PluginTaskPriority priority)
+{
+    auto task = std::make_shared<PluginTaskState>();
+    task->fun = std::move(fun);
+    task->priority = priority;
+    task->scheduler = this;
+    task->group = groupOf(plugin);
+    task->group->submitted.fetch_add(1, std::memory_order_relaxed);
+    bool cancelled = false;
+    {
+        std::lock_guard lock(task->group->mtx);
+        cancelled = task->group->cancelled;
+    }
+    if (cancelled) {
+        // 插件释放中，分组保留为取消状态直到 reopen
+        task->status.store(PluginTaskStatus::Cancelled, std::memory_order_release);
+        finish(task, PluginTaskStatus::Cancelled);
+        return PluginTask(task);
+    }
+    if (!_stop.load(std::memory_order_acquire)) {
+        start();
+    }
+    enqueue(task);
+    return PluginTask(task);
+}
+
+void PluginScheduler::enqueue(std::shared_ptr<PluginTaskState> task)
+{
+    if (_stop.load(std::memory_order_acquire)) {
+        auto expected = PluginTaskStatus::Pending;
+        if (task->status.compare_exchange_strong(expected, PluginTaskStatus::Cancelled, std::memory_order_acq_rel)) {
+            finish(task, PluginTaskStatus::Cancelled);
+        }
+        return;
+    }
+    const auto priority = static_cast<std::size_t>(task->priority);
+    // 工作线程提交的任务留在本线程，其他线程轮流分配
+    const int index = t_scheduler == this && t_worker >= 0
+        ? t_worker
+        : static_cast<int>(_next.fetch_add(1, std::memory_order_relaxed) % _workers.size());
+    {
+        auto&& worker = *_workers[index];
+        std::lock_guard lock(worker.mtx);
+        worker.queues[priority].push_back(std::move(task));
+    }
+    _queued.fetch_add(1, std::memory_order_release);
+    {
+        // 与休眠判断互斥，避免丢失唤醒
+        std::lock_guard lock(_sleepMtx);
+    }
+    _sleepCv.notify_one();
+}
+
+std::shared_ptr<PluginTaskState> PluginScheduler::take(int index)
+{
+    const auto count = static_cast<int>(_workers.size());
+    for (std::size_t priority = 0; priority < 3; priority++) {
+        {
+            auto&& own = *_workers[index];
+            std::lock_guard lock(own.mtx);
+            auto&& queue = own.queues[priority];
+            if (!queue.empty()) {
+                auto task = std::move(queue.back());
+                queue.pop_back();
+                return task;
+            }
+        }
+        for (int i = 1; i < count; i++) {
+            auto&& victim = *_workers[(index + i) % count];
+            std::lock_guard lock(victim.mtx);
+            auto&& queue = victim.queues[priority];
+            if (!queue.empty()) {
+                auto task = std::move(queue.front());
+                queue.pop_front();
+                _steals.fetch_add(1, std::memory_order_relaxed);
+                return task;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void PluginScheduler::run(int index)
+{
+    t_scheduler = this;
+    t_worker = index;
+    while (true) {
+        if (auto task = take(index)) {
+            _queued.fetch_sub(1, std::memory_order_acq_rel);
+            execute(task);
+            continue;
+        }
+        std::unique_lock lock(_sleepMtx);
+        _sleepCv.wait(lock, [this]() {
+            return _stop.load(std::memory_order_acquire) || _parking.load(std::memory_order_acquire) || _queued.load(std::memory_order_acquire) > 0;
+        });
+        if ((_stop.load(std::memory_order_acquire) || _parking.load(std::memory_order_acquire)) && _queued.load(std::memory_order_acquire) <= 0) {
+            break;
+        }
+    }
+    t_worker = -1;
+    t_scheduler = nullptr;
+}
+
+void PluginScheduler::execute(const std::shared_ptr<PluginTaskState>& task)
+{
+    auto&& group = *task->group;
+    auto expected = PluginTaskStatus::Pending;
+    {
+        std::lock_guard lock(group.mtx);
+        if (group.cancelled) {
+            if (task->status.compare_exchange_strong(expected, PluginTaskStatus::Cancelled, std::memory_order_acq_rel)) {
+                finish(task, PluginTaskStatus::Cancelled);
+            }
+            return;
+        }
+        if (!task->status.compare_exchange_strong(expected, PluginTaskStatus::Running, std::memory_order_acq_rel)) {
+            // 已由句柄取消
+            return;
+        }
+        group.running++;
+    }
+    const auto cpuBegin = threadCpuNs();
+    const auto wallBegin = std::chrono::steady_clock::now();
+    t_task = task.get();
+    try {
+        if (_context) {
+            QPluginManagerScope scope(*_context);
+            // 任务记为所属插件的调用，任务内经追踪层的调用以该插件为调用方
+            PluginTraceScope trace(_context->tracer(), group.plugin, "task");
+            task->fun();
+        } else {
+            task->fun();
+        }
+    } catch (const std::exception& e) {
+        group.failed.fetch_add(1, std::memory_order_relaxed);
+        qCWarning(lcPluginManager) << "插件任务异常:" << group.plugin << e.what();
+    } catch (...) {
+        group.failed.fetch_add(1, std::memory_order_relaxed);
+        qCWarning(lcPluginManager) << "插件任务异常:" << group.plugin;
+    }
+    t_task = nullptr;
+    // 释放捕获的数据，不随控制块留到句柄析构
+    task->fun = nullptr;
+    const auto wallNs = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - wallBegin).count());
+    group.cpuNs.fetch_add(threadCpuNs() - cpuBegin, std::memory_order_relaxed);
+    group.wallNs.fetch_add(wallNs, std::memory_order_relaxed);
+    if (PluginMetrics::enabled()) {
+        auto metric = group.metric.load(std::memory_order_acquire);
+        if (metric == nullptr) {
+            metric = &PluginMetrics::Instance().histogram("manager.task", group.plugin.toStdString());
+            group.metric.store(metric, std::memory_order_release);
+        }
+        metric->record(wallNs);
+    }
+    task->status.store(PluginTaskStatus::Finished, std::memory_order_release);
+    finish(task, PluginTaskStatus::Finished);
+    {
+        std::lock_guard lock(group.mtx);
+        group.running--;
+    }
+    group.idle.notify_all();
+}
+
+void PluginScheduler::finish(const std::shared_ptr<PluginTaskState>& task, PluginTaskStatus status)
+{
+    if (status == PluginTaskStatus::Cancelled) {
+        task->group->cancelledTasks.fetch_add(1, std::memory_order_relaxed);
+        task->fun = nullptr;
+    } else {
+        task->group->finished.fetch_add(1, std::memory_order_relaxed);
+    }
+    std::vector<std::shared_ptr<PluginTaskState>> continuations;
+    {
+        std::lock_guard lock(task->mtx);
+        task->done = true;
+        continuations.swap(task->continuations);
+    }
+    task->cv.notify_all();
+    for (auto&& next : continuations) {
+        if (status == PluginTaskStatus::Finished) {
+            enqueue(next);
+            continue;
+        }
+        auto expected = PluginTaskStatus::Pending;
+        if (next->status.compare_exchange_strong(expected, PluginTaskStatus::Cancelled, std::memory_order_acq_rel)) {
+            finish(next, PluginTaskStatus::Cancelled);
+        }
+    }
+}
+
+std::shared_ptr<PluginTaskGroup> PluginScheduler::groupOf(const QString& plugin)
+{
+    std::lock_guard lock(_groupMtx);
+    auto&& slot = _groups[plugin];
+    if (!slot) {
+        slot = std::make_shared<PluginTaskGroup>();
+        slot->plugin = plugin;
+    }
+    return slot;
+}
+
+void PluginScheduler::cancel(const QString& plugin)
+{
+    // 分组留在表中作为取消标记，经 groupOf 的后续提交直接取消，直到 reopen
+    const auto group = groupOf(plugin);
+    {
+        std::lock_guard lock(group->mtx);
+        group->cancelled = true;
+    }
+    // 排队中的任务立即结束，等待者不必等到工作线程取出
+    std::vector<std::shared_ptr<PluginTaskState>> dropped;
+    const int active = _active.load(std::memory_order_acquire);
+    for (int i = 0; i < active; i++) {
+        auto&& worker = _workers[i];
+        std::lock_guard lock(worker->mtx);
+        for (auto&& queue : worker->queues) {
+            auto it = std::stable_partition(queue.begin(), queue.end(), [&group](const std::shared_ptr<PluginTaskState>& t) { return t->group != group; });
+            std::move(it, queue.end(), std::back_inserter(dropped));
+            queue.erase(it, queue.end());
+        }
+    }
+    _queued.fetch_sub(static_cast<std::int64_t>(dropped.size()), std::memory_order_acq_rel);
+    for (auto&& task : dropped) {
+        auto expected = PluginTaskStatus::Pending;
+        if (task->status.compare_exchange_strong(expected, PluginTaskStatus::Cancelled, std::memory_order_acq_rel)) {
+            finish(task, PluginTaskStatus::Cancelled);
+        }
+    }
+    {
+        std::unique_lock lock(group->mtx);
+        if (t_scheduler == this && t_worker >= 0 && t_task && t_task->group == group) {
+            // 任务内取消自己的分组，不等待自身
+            group->idle.wait(lock, [&group]() { return group->running <= 1; });
+        } else {
+            group->idle.wait(lock, [&group]() { return group->running == 0; });
+        }
+    }
+    qPluginDebug(lcPluginManager) << "取消插件任务分组:" << plugin << dropped.size();
+}
+
+void PluginScheduler::reopen(const QString& plugin)
+{
+    std::lock_guard lock(_groupMtx);
+    auto it = _groups.find(plugin);
+    if (it == _groups.end()) {
+        return;
+    }
+    {
+        std::lock_guard groupLock(it.value()->mtx);
+        if (!it.value()->cancelled) {
+            return;
+        }
+    }
+    accumulate(_retired[plugin], it.value()->stats());
+    _retired[plugin].plugin = plugin;
+    _groups.erase(it);
+}
+
+bool PluginScheduler::isCancelled()
+{
+    auto task = t_task;
+    if (task == nullptr) {
+        return false;
+    }
+    if (task->cancelRequested.load(std::memory_order_acquire)) {
+        return true;
+    }
+    std::lock_guard lock(task->group->mtx);
+    return task->group->cancelled;
+}
+
+void PluginScheduler::shutdown()
+{
+    QList<QString> plugins;
+    {
+        std::lock_guard lock(_groupMtx);
+        plugins = _groups.keys();
+    }
+    for (auto&& plugin : plugins) {
+        cancel(plugin);
+    }
+    _stop.store(true, std::memory_order_release);
+    {
+        std::lock_guard lock(_sleepMtx);
+    }
+    _sleepCv.notify_all();
+    std::vector<std::shared_ptr<PluginTaskState>> left;
+    for (int i = 0; i < _active.load(std::memory_order_acquire); i++) {
+        auto&& worker = _workers[i];
+        if (worker->thread.joinable() && worker->thread.get_id() != std::this_thread::get_id()) {
+            worker->thread.join();
+        }
+        // 停止前由后续任务压入的任务
+        std::lock_guard lock(worker->mtx);
+        for (auto&& queue : worker->queues) {
+            std::move(queue.begin(), queue.end(), std::back_inserter(left));
+            queue.clear();
+        }
+    }
+    for (auto&& task : left) {
+        auto expected = PluginTaskStatus::Pending;
+        if (task->status.compare_exchange_strong(expected, PluginTaskStatus::Cancelled, std::memory_order_acq_rel)) {
+            finish(task, PluginTaskStatus::Cancelled);
+        }
+    }
+}
+
+void PluginScheduler::suspend()
+{
+    const int active = _active.load(std::memory_order_acquire);
+    if (active == 0 || _stop.load(std::memory_order_acquire)) {
+        return;
+    }
+    _parking.store(true, std::memory_order_release);
+    {
+        std::lock_guard lock(_sleepMtx);
+    }
+    _sleepCv.notify_all();
+    for (int i = 0; i < active; i++) {
+        if (_workers[i]->thread.joinable()) {
+            _workers[i]->thread.join();
+        }
+    }
+    _parking.store(false, std::memory_order_release);
+}
+
+void PluginScheduler::resume(bool discardQueued)
+{
+    const int active = _active.load(std::memory_order_acquire);
+    if (active == 0 || _stop.load(std::memory_order_acquire)) {
+        return;
+    }
+    if (discardQueued) {
+        std::vector<std::shared_ptr<PluginTaskState>> dropped;
+        for (int i = 0; i < active; i++) {
+            auto&& worker = _workers[i];
+            std::lock_guard lock(worker->mtx);
+            for (auto&& queue : worker->queues) {
+                std::move(queue.begin(), queue.end(), std::back_inserter(dropped));
+                queue.clear();
+            }
+        }
+        _queued.fetch_sub(static_cast<std::int64_t>(dropped.size()), std::memory_order_acq_rel);
+        for (auto&& task : dropped) {
+            auto expected = PluginTaskStatus::Pending;
+            if (task->status.compare_exchange_strong(expected, PluginTaskStatus::Cancelled, std::memory_order_acq_rel)) {
+                finish(task, PluginTaskStatus::Cancelled);
+            }
+        }
+    }
+    for (int i = 0; i < active; i++) {
+        if (!_workers[i]->thread.joinable()) {
+            _workers[i]->thread = std::thread(&PluginScheduler::run, this, i);
+        }
+    }
+}
+
+PluginSchedulerStats PluginScheduler::stats() const
+{
+    PluginSchedulerStats s;
+    s.workers = _active.load(std::memory_order_acquire);
+    s.steals = _steals.load(std::memory_order_relaxed);
+    std::lock_guard lock(_groupMtx);
+    auto merged = _retired;
+    for (auto it = _groups.cbegin(); it != _groups.cend(); ++it) {
+        auto&& to = merged[it.key()];
+        to.plugin = it.key();
+        accumulate(to, it.value()->stats());
+    }
+    for (auto it = merged.cbegin(); it != merged.cend(); ++it) {
+        s.groups.append(it.value());
+    }
+    std::sort(s.groups.begin(), s.groups.end(), [](const PluginTaskGroupStats& a, const PluginTaskGroupStats& b) {
+        return a.cpuNs > b.cpuNs;
+    });
+    return s;
+}
+
+std::uint64_t PluginScheduler::threadCpuNs()
+{
+#if defined(Q_OS_WIN)
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+        return 0;
+    }
+    const auto ticks = (static_cast<std::uint64_t>(kernel.dwHighDateTime) << 32 | kernel.dwLowDateTime)
+        + (static_cast<std::uint64_t>(user.dwHighDateTime) << 32 | user.dwLowDateTime);
+    // 100 纳秒为单位
+    return ticks * 100;
+#elif defined(CLOCK_THREAD_CPUTIME_ID)
+    timespec ts {};
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+        return 0;
+    }
+    return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<std::uint64_t>(ts.tv_nsec);
+#else
+    return 0;
+#endif
+}
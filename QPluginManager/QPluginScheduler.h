@@ -0,0 +1,291 @@
+﻿#pragma once
+
+#include <QtCore/qglobal.h>
+
+#ifndef BUILD_STATIC
+#if defined(QPLUGINMANAGER_LIB)
+#define QPLUGINMANAGER_EXPORT Q_DECL_EXPORT
+#else
+#define QPLUGINMANAGER_EXPORT Q_DECL_IMPORT
+#endif
+#else
+#define QPLUGINMANAGER_EXPORT
+#endif
+
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class QPluginManager;
+struct PluginTaskState;
+struct PluginTaskGroup;
+
+/**
+ * @brief 任务优先级，工作线程总是先取高优先级任务（含从其他线程窃取）
+ */
+enum class PluginTaskPriority {
+    High,
+    Normal,
+    Low,
+};
+
+/**
+ * @brief 任务状态
+ */
+enum class PluginTaskStatus {
+    /**
+     * @brief 排队中，或等待前序任务完成的后续任务
+     */
+    Pending,
+    Running,
+    Finished,
+    Cancelled,
+};
+
+/**
+ * @brief 任务句柄，可复制；句柄全部析构不影响任务执行
+ */
+class QPLUGINMANAGER_EXPORT PluginTask {
+public:
+    PluginTask() = default;
+
+    bool isValid() const
+    {
+        return _state != nullptr;
+    }
+
+    PluginTaskStatus status() const;
+
+    /**
+     * @brief 已完成或已取消
+     */
+    bool isDone() const;
+
+    /**
+     * @brief 取消尚未开始的任务及其后续任务；执行中的任务只设置取消标记，由任务自行检查 PluginScheduler::isCancelled
+     * @return 任务被取消时返回 true
+     */
+    bool cancel();
+
+    /**
+     * @brief 等待任务完成或取消；不要在任务中等待其他任务，改用 then
+     */
+    void wait() const;
+
+    /**
+     * @brief 限时等待
+     * @param ms 毫秒
+     * @return 是否已完成或取消
+     */
+    bool waitFor(qint64 ms) const;
+
+    /**
+     * @brief 后续任务：本任务完成后以同一分组提交，本任务被取消时一并取消
+     * @param fun 执行函数
+     * @param priority 后续任务优先级
+     * @return 后续任务句柄
+     */
+    PluginTask then(std::function<void()> fun, PluginTaskPriority priority = PluginTaskPriority::Normal) const;
+
+private:
+    friend class PluginScheduler;
+    explicit PluginTask(std::shared_ptr<PluginTaskState> state)
+        : _state(std::move(state))
+    {
+    }
+
+    std::shared_ptr<PluginTaskState> _state;
+};
+
+/**
+ * @brief 单个插件分组的计数与 CPU 时间
+ */
+struct PluginTaskGroupStats {
+    QString plugin;
+    std::uint64_t submitted = 0;
+    std::uint64_t finished = 0;
+    std::uint64_t cancelled = 0;
+    /**
+     * @brief 任务抛出异常的次数，计入 finished
+     */
+    std::uint64_t failed = 0;
+    std::size_t running = 0;
+    /**
+     * @brief 任务在工作线程上消耗的 CPU 时间
+     */
+    std::uint64_t cpuNs = 0;
+    /**
+     * @brief 任务执行的墙钟时间
+     */
+    std::uint64_t wallNs = 0;
+};
+
+/**
+ * @brief 调度器统计
+ */
+struct QPLUGINMANAGER_EXPORT PluginSchedulerStats {
+    int workers = 0;
+    /**
+     * @brief 从其他工作线程窃取的任务数
+     */
+    std::uint64_t steals = 0;
+    QList<PluginTaskGroupStats> groups;
+
+    QJsonObject toJson() const;
+};
+
+/**
+ * @brief 插件共享的工作窃取调度器，由插件管理器提供，替代插件各自创建 QThread 或使用全局 QThreadPool。
+ *        固定数量的工作线程各持一组按优先级划分的双端队列：本线程提交的任务压入自己的队列尾并按后进先出执行，
+ *        空闲时从其他线程队列头窃取；其他线程提交的任务轮流分配。任务按插件分组，插件卸载时取消其分组，
+ *        并按分组统计 CPU 时间。任务在所属上下文的 QPluginManagerScope 中执行
+ */
+class QPLUGINMANAGER_EXPORT PluginScheduler {
+public:
+    /**
+     * @param context 任务执行时的 QPluginManager::Current()，为空时不切换
+     */
+    explicit PluginScheduler(QPluginManager* context = nullptr);
+    ~PluginScheduler();
+
+    PluginScheduler(const PluginScheduler&) = delete;
+    PluginScheduler& operator=(const PluginScheduler&) = delete;
+
+    /**
+     * @brief 工作线程数，需在首次提交之前设置
+     * @param count 0 表示 QThread::idealThreadCount()
+     */
+    void setWorkerCount(int count);
+
+    int workerCount() const;
+
+    /**
+     * @brief 提交任务（任意线程），工作线程在首次提交时启动
+     * @param plugin 所属插件名，即分组
+     * @param fun 执行函数
+     * @param priority 优先级
+     * @return 分组已取消或调度器已停止时返回已取消的任务
+     */
+    PluginTask submit(const QString& plugin, std::function<void()> fun, PluginTaskPriority priority = PluginTaskPriority::Normal);
+
+    /**
+     * @brief 取消插件分组：丢弃排队中的任务并等待执行中的任务返回；之后的提交直接取消，直到 reopen
+     * @param plugin 插件名
+     */
+    void cancel(const QString& plugin);
+
+    /**
+     * @brief 结束已取消的分组，计数并入累计，之后的提交开启新分组；插件释放完成后调用
+     * @param plugin 插件名
+     */
+    void reopen(const QString& plugin);
+
+    /**
+     * @brief 当前任务或其分组是否已取消，供长任务在工作线程中轮询
+     * @return 不在任务中时为 false
+     */
+    static bool isCancelled();
+
+    /**
+     * @brief 取消全部分组并停止工作线程
+     */
+    void shutdown();
+
+    /**
+     * @brief 执行完排队中的任务后停止工作线程，期间提交的任务留在队列中；fork 之前调用
+     */
+    void suspend();
+
+    /**
+     * @brief 重新启动 suspend 停止的工作线程，fork 之后在父子进程中各调用一次
+     * @param discardQueued 取消队列中的任务，工作进程中传 true，任务不会在父子进程中各执行一次
+     */
+    void resume(bool discardQueued);
+
+    PluginSchedulerStats stats() const;
+
+    /**
+     * @brief 当前线程消耗的 CPU 时间
+     * @return 纳秒，平台不支持时为 0
+     */
+    static std::uint64_t threadCpuNs();
+
+private:
+    friend class PluginTask;
+
+    struct Worker {
+        std::mutex mtx;
+        std::array<std::deque<std::shared_ptr<PluginTaskState>>, 3> queues;
+        std::thread thread;
+    };
+
+    void start();
+    void run(int index);
+
+    /**
+     * @brief 按优先级取任务：自己的队列尾，其次其他队列头
+     * @param index 工作线程下标
+     * @return 没有任务时为空
+     */
+    std::shared_ptr<PluginTaskState> take(int index);
+
+    /**
+     * @brief 放入队列并唤醒一个工作线程
+     * @param task
+     */
+    void enqueue(std::shared_ptr<PluginTaskState> task);
+
+    void execute(const std::shared_ptr<PluginTaskState>& task);
+
+    /**
+     * @brief 任务结束：唤醒等待者并处理后续任务
+     * @param task
+     * @param status Finished 或 Cancelled
+     */
+    void finish(const std::shared_ptr<PluginTaskState>& task, PluginTaskStatus status);
+
+    std::shared_ptr<PluginTaskGroup> groupOf(const QString& plugin);
+
+    QPluginManager* _context = nullptr;
+    int _workerCount = 0;
+    std::vector<std::unique_ptr<Worker>> _workers;
+    std::once_flag _started;
+    /**
+     * @brief 已启动的工作线程数，_workers 在此之前构造完毕且不再改变
+     */
+    std::atomic_int _active { 0 };
+    std::atomic_bool _stop { false };
+    /**
+     * @brief suspend 中：工作线程在队列清空后退出
+     */
+    std::atomic_bool _parking { false };
+    std::atomic<std::uint32_t> _next { 0 };
+    std::atomic<std::uint64_t> _steals { 0 };
+
+    /**
+     * @brief 排队任务数，工作线程据此休眠
+     */
+    std::atomic<std::int64_t> _queued { 0 };
+    std::mutex _sleepMtx;
+    std::condition_variable _sleepCv;
+
+    mutable std::mutex _groupMtx;
+    QHash<QString, std::shared_ptr<PluginTaskGroup>> _groups;
+    /**
+     * @brief 已结束分组的累计计数，stats 中与现有分组合并
+     */
+    QHash<QString, PluginTaskGroupStats> _retired;
+};
@@ -0,0 +1,301 @@
+﻿#include "QPluginStateCache.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include "QPluginLogging.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+namespace {
+constexpr char MAGIC[4] = { 'Q', 'P', 'S', 'T' };
+constexpr qint64 FINGERPRINT_SIZE = 20;
+/**
+ * @brief 文件头：魔数、格式版本、指纹、数据长度，补齐到 64 字节使数据按缓存行对齐
+ */
+constexpr qint64 HEADER_SIZE = 64;
+/**
+ * @brief 数据长度上限，取 QByteArray 的长度类型（Qt5 为 int），超出的条目无法交给插件
+ */
+constexpr qint64 MAX_STATE_SIZE = std::numeric_limits<decltype(std::declval<QByteArray>().size())>::max();
+constexpr auto SUFFIX = ".state";
+
+/**
+ * @brief 插件名到文件名：[A-Za-z0-9-._~] 以外的字节（含路径分隔符与 %）百分号编码，"." 开头时编码首字符
+ */
+QString fileName(const QString& name)
+{
+    auto encoded = name.toUtf8().toPercentEncoding();
+    if (encoded.startsWith('.')) {
+        encoded.replace(0, 1, "%2E");
+    }
+    return QString::fromLatin1(encoded) + SUFFIX;
+}
+
+/**
+ * @brief 文件名到插件名，fileName 的逆变换
+ */
+QString nameOf(const QString& file)
+{
+    return QString::fromUtf8(QByteArray::fromPercentEncoding(file.chopped(static_cast<int>(strlen(SUFFIX))).toLatin1()));
+}
+
+QByteArray header(const QByteArray& fingerprint, qint64 size)
+{
+    QByteArray out(HEADER_SIZE, '\0');
+    auto p = out.data();
+    memcpy(p, MAGIC, sizeof(MAGIC));
+    qToLittleEndian<quint32>(PluginStateCache::FORMAT_VERSION, p + 4);
+    memcpy(p + 8, fingerprint.constData(), static_cast<std::size_t>(std::min<qint64>(fingerprint.size(), FINGERPRINT_SIZE)));
+    qToLittleEndian<quint64>(static_cast<quint64>(size), p + 8 + FINGERPRINT_SIZE);
+    return out;
+}
+
+bool isValid(const char* data, qint64 size, const QByteArray& fingerprint)
+{
+    return size >= HEADER_SIZE
+        && memcmp(data, MAGIC, sizeof(MAGIC)) == 0
+        && qFromLittleEndian<quint32>(data + 4) == PluginStateCache::FORMAT_VERSION
+        && fingerprint.size() == FINGERPRINT_SIZE
+        && memcmp(data + 8, fingerprint.constData(), FINGERPRINT_SIZE) == 0
+        && qFromLittleEndian<quint64>(data + 8 + FINGERPRINT_SIZE) == static_cast<quint64>(size - HEADER_SIZE);
+}
+}
+
+QJsonObject PluginStateStats::toJson() const
+{
+    QJsonObject obj;
+    obj.insert("hits", hits);
+    obj.insert("misses", misses);
+    obj.insert("stale", stale);
+    obj.insert("rejected", rejected);
+    obj.insert("written", written);
+    obj.insert("writeFailures", writeFailures);
+    obj.insert("pruned", pruned);
+    obj.insert("bytesRead", bytesRead);
+    obj.insert("bytesWritten", bytesWritten);
+    obj.insert("readUs", readUs);
+    obj.insert("writeUs", writeUs);
+    return obj;
+}
+
+PluginStateCache::~PluginStateCache()
+{
+    this->suspend();
+}
+
+void PluginStateCache::setDirectory(const QString& dir)
+{
+    std::lock_guard lock(_mtx);
+    _dir = dir;
+}
+
+QString PluginStateCache::directory() const
+{
+    std::lock_guard lock(_mtx);
+    return _dir;
+}
+
+bool PluginStateCache::isEnabled() const
+{
+    std::lock_guard lock(_mtx);
+    return !_dir.isEmpty();
+}
+
+QByteArray PluginStateCache::fingerprint(const QString& path, const QString& version, const QByteArray& key)
+{
+    const QFileInfo fi(path);
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(fi.canonicalFilePath().toUtf8());
+    hash.addData(QByteArray::number(fi.size()));
+    hash.addData(QByteArray::number(fi.lastModified().toMSecsSinceEpoch()));
+    hash.addData(version.toUtf8());
+    // 长度前缀避免版本与附加键拼接后相互混淆
+    hash.addData(QByteArray::number(key.size()));
+    hash.addData(key);
+    return hash.result();
+}
+
+QString PluginStateCache::fileOf(const QString& name) const
+{
+    return _dir + "/" + fileName(name);
+}
+
+bool PluginStateCache::read(const QString& name, const QByteArray& fingerprint, const std::function<bool(const QByteArray&)>& fun)
+{
+    QElapsedTimer timer;
+    timer.start();
+    QString path;
+    {
+        std::lock_guard lock(_mtx);
+        if (_dir.isEmpty()) {
+            return false;
+        }
+        path = fileOf(name);
+    }
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        std::lock_guard lock(_mtx);
+        _stats.misses++;
+        return false;
+    }
+    const auto size = file.size();
+    const bool fits = size - HEADER_SIZE <= MAX_STATE_SIZE;
+    // 映射失败时退回读取
+    uchar* mapped = size >= HEADER_SIZE && fits ? file.map(0, size) : nullptr;
+    const QByteArray content = mapped || !fits ? QByteArray() : file.readAll();
+    const char* data = mapped ? reinterpret_cast<const char*>(mapped) : content.constData();
+    if (!fits || !isValid(data, size, fingerprint)) {
+        if (mapped) {
+            file.unmap(mapped);
+        }
+        file.close();
+        std::lock_guard lock(_mtx);
+        // 持锁删除：同名条目排队或正在写入时保留，新文件由后台线程替换，不会被这里删掉
+        const bool pending = (_writing && _writingName == name)
+            || std::any_of(_queue.begin(), _queue.end(), [&name](const Pending& p) { return p.name == name; });
+        if (!pending) {
+            QFile::remove(path);
+            qCInfo(lcPluginManager) << "插件检查点已过期，删除:" << name << size;
+        }
+        _stats.stale++;
+        return false;
+    }
+    // 不复制：数据直接引用映射，fun 返回后才解除映射
+    const auto state = QByteArray::fromRawData(data + HEADER_SIZE, static_cast<decltype(content.size())>(size - HEADER_SIZE));
+    const bool ok = fun(state);
+    if (mapped) {
+        file.unmap(mapped);
+    }
+    file.close();
+    std::lock_guard lock(_mtx);
+    if (ok) {
+        _stats.hits++;
+        _stats.bytesRead += size - HEADER_SIZE;
+    } else {
+        _stats.rejected++;
+    }
+    _stats.readUs += timer.nsecsElapsed() / 1000;
+    return ok;
+}
+
+void PluginStateCache::write(const QString& name, const QByteArray& fingerprint, const QByteArray& state)
+{
+    {
+        std::lock_guard lock(_mtx);
+        if (_dir.isEmpty()) {
+            return;
+        }
+        auto it = std::find_if(_queue.begin(), _queue.end(), [&name](const Pending& p) { return p.name == name; });
+        if (it != _queue.end()) {
+            it->fingerprint = fingerprint;
+            it->state = state;
+        } else {
+            _queue.push_back(Pending { name, fingerprint, state });
+        }
+        if (!_thread.joinable()) {
+            _thread = std::thread(&PluginStateCache::run, this);
+        }
+    }
+    _cv.notify_one();
+}
+
+void PluginStateCache::prune(const QStringList& names)
+{
+    QString dir;
+    {
+        std::lock_guard lock(_mtx);
+        dir = _dir;
+    }
+    if (dir.isEmpty()) {
+        return;
+    }
+    int pruned = 0;
+    for (auto&& file : QDir(dir).entryList({ QString("*") + SUFFIX }, QDir::Files)) {
+        if (!names.contains(nameOf(file)) && QFile::remove(dir + "/" + file)) {
+            pruned++;
+        }
+    }
+    if (pruned > 0) {
+        qCInfo(lcPluginManager) << "清理插件检查点:" << pruned;
+        std::lock_guard lock(_mtx);
+        _stats.pruned += pruned;
+    }
+}
+
+void PluginStateCache::flush()
+{
+    std::unique_lock lock(_mtx);
+    _drained.wait(lock, [this]() { return _queue.empty() && !_writing; });
+}
+
+void PluginStateCache::suspend()
+{
+    {
+        std::lock_guard lock(_mtx);
+        _stop = true;
+    }
+    _cv.notify_all();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+    std::lock_guard lock(_mtx);
+    _stop = false;
+}
+
+PluginStateStats PluginStateCache::stats() const
+{
+    std::lock_guard lock(_mtx);
+    return _stats;
+}
+
+void PluginStateCache::run()
+{
+    std::unique_lock lock(_mtx);
+    while (true) {
+        _cv.wait(lock, [this]() { return _stop || !_queue.empty(); });
+        if (_queue.empty()) {
+            break;
+        }
+        const auto item = std::move(_queue.front());
+        _queue.pop_front();
+        const auto dir = _dir;
+        const auto path = fileOf(item.name);
+        _writing = true;
+        _writingName = item.name;
+        lock.unlock();
+        QElapsedTimer timer;
+        timer.start();
+        QDir().mkpath(dir);
+        QSaveFile file(path);
+        const bool ok = file.open(QIODevice::WriteOnly)
+            && file.write(header(item.fingerprint, item.state.size())) == HEADER_SIZE
+            && file.write(item.state) == item.state.size()
+            && file.commit();
+        if (!ok) {
+            qCWarning(lcPluginManager) << "插件检查点写入失败:" << path << file.errorString();
+        }
+        const auto us = timer.nsecsElapsed() / 1000;
+        lock.lock();
+        _writing = false;
+        _writingName.clear();
+        if (ok) {
+            _stats.written++;
+            _stats.bytesWritten += item.state.size();
+        } else {
+            _stats.writeFailures++;
+        }
+        _stats.writeUs += us;
+        _drained.notify_all();
+    }
+    _drained.notify_all();
+}
@@ -0,0 +1,159 @@
+﻿#pragma once
+
+#include <QtCore/qglobal.h>
+
+#ifndef BUILD_STATIC
+#if defined(QPLUGINMANAGER_LIB)
+#define QPLUGINMANAGER_EXPORT Q_DECL_EXPORT
+#else
+#define QPLUGINMANAGER_EXPORT Q_DECL_IMPORT
+#endif
+#else
+#define QPLUGINMANAGER_EXPORT
+#endif
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/**
+ * @brief 检查点缓存计数
+ */
+struct QPLUGINMANAGER_EXPORT PluginStateStats {
+    /**
+     * @brief 读取有效且插件恢复成功的次数
+     */
+    int hits = 0;
+    int misses = 0;
+    /**
+     * @brief 指纹或格式不符而删除的条目数
+     */
+    int stale = 0;
+    /**
+     * @brief 条目有效但插件拒绝恢复的次数
+     */
+    int rejected = 0;
+    int written = 0;
+    int writeFailures = 0;
+    /**
+     * @brief 清理掉的已不存在插件的条目数
+     */
+    int pruned = 0;
+    qint64 bytesRead = 0;
+    qint64 bytesWritten = 0;
+    /**
+     * @brief 映射与插件恢复耗时
+     */
+    qint64 readUs = 0;
+    /**
+     * @brief 后台线程写入耗时
+     */
+    qint64 writeUs = 0;
+
+    QJsonObject toJson() const;
+};
+
+/**
+ * @brief 插件初始化状态的本地检查点缓存：每个插件一个文件，文件头记录格式版本与指纹（插件文件路径、大小、
+ *        修改时间、元信息 Version 及插件提供的附加键），指纹不符时条目作废并删除；读取时内存映射，写入在后台线程原子替换。
+ *        插件名中文件名不安全的字符经百分号编码，条目始终位于缓存目录内
+ */
+class QPLUGINMANAGER_EXPORT PluginStateCache {
+public:
+    /**
+     * @brief 文件格式版本，变化后旧条目全部作废
+     */
+    static constexpr quint32 FORMAT_VERSION = 1;
+
+    PluginStateCache() = default;
+    ~PluginStateCache();
+
+    PluginStateCache(const PluginStateCache&) = delete;
+    PluginStateCache& operator=(const PluginStateCache&) = delete;
+
+    /**
+     * @brief 设置缓存目录，为空时关闭
+     * @param dir
+     */
+    void setDirectory(const QString& dir);
+
+    QString directory() const;
+
+    bool isEnabled() const;
+
+    /**
+     * @brief 插件文件指纹
+     * @param path 插件文件
+     * @param version 元信息 Version
+     * @param key 插件提供的附加键，见 PluginStateHooks::stateKey
+     * @return SHA-1
+     */
+    static QByteArray fingerprint(const QString& path, const QString& version, const QByteArray& key = QByteArray());
+
+    /**
+     * @brief 内存映射读取检查点并交给 fun；指纹或格式不符、或超出 QByteArray 长度上限的条目删除，同名条目等待写入时保留
+     * @param name 插件名
+     * @param fingerprint 当前指纹
+     * @param fun 数据直接引用映射（QByteArray::fromRawData），只在调用期间有效，需保留时深复制
+     * @return 条目有效且 fun 返回 true
+     */
+    bool read(const QString& name, const QByteArray& fingerprint, const std::function<bool(const QByteArray&)>& fun);
+
+    /**
+     * @brief 交给后台线程写入，同名条目以最后一次为准
+     * @param name 插件名
+     * @param fingerprint 当前指纹
+     * @param state 检查点数据，隐式共享不复制
+     */
+    void write(const QString& name, const QByteArray& fingerprint, const QByteArray& state);
+
+    /**
+     * @brief 删除不在 names 中的插件的条目
+     * @param names 当前插件名
+     */
+    void prune(const QStringList& names);
+
+    /**
+     * @brief 等待后台写入完成
+     */
+    void flush();
+
+    /**
+     * @brief 写完队列后停止后台线程，下次写入时重新启动；fork 前调用
+     */
+    void suspend();
+
+    PluginStateStats stats() const;
+
+private:
+    struct Pending {
+        QString name;
+        QByteArray fingerprint;
+        QByteArray state;
+    };
+
+    void run();
+
+    QString fileOf(const QString& name) const;
+
+    mutable std::mutex _mtx;
+    std::condition_variable _cv;
+    std::condition_variable _drained;
+    std::deque<Pending> _queue;
+    bool _writing = false;
+    /**
+     * @brief 后台线程正在写入的插件名
+     */
+    QString _writingName;
+    bool _stop = false;
+    std::thread _thread;
+    QString _dir;
+    PluginStateStats _stats;
+};
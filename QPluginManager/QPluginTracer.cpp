@@ -0,0 +1,313 @@
+﻿#include "QPluginTracer.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
+
+/**
+ * @brief 调用树节点，同一调用栈的调用落在同一节点；节点只增不删，reset 只清零统计
+ */
+struct PluginTracer::Node {
+    QString plugin;
+    const char* method = nullptr;
+    Node* parent = nullptr;
+    /**
+     * @brief 只由所属线程追加，追加与读取报告时持有 Buffer::mtx
+     */
+    std::vector<std::unique_ptr<Node>> children;
+    std::atomic<std::uint64_t> sampled { 0 };
+    std::atomic<std::uint64_t> selfNs { 0 };
+    MetricHistogram latency;
+};
+
+/**
+ * @brief 单个线程的采样缓冲；调用路径只在新增节点时取锁，与之竞争的只有读取方
+ */
+struct PluginTracer::Buffer {
+    std::mutex mtx;
+    Node root;
+};
+
+namespace {
+std::atomic<std::uint64_t> s_nextTracer { 1 };
+
+struct TraceFrame {
+    void* buffer = nullptr;
+    void* node = nullptr;
+    std::chrono::steady_clock::time_point start;
+    /**
+     * @brief 被采样的嵌套调用耗时之和
+     */
+    std::uint64_t childNs = 0;
+};
+
+/**
+ * @brief 线程的追踪状态，各上下文的追踪器共用一条调用栈
+ */
+struct TraceThread {
+    std::vector<TraceFrame> frames;
+    /**
+     * @brief 未采样调用的嵌套深度
+     */
+    int skipped = 0;
+    /**
+     * @brief 距下次采样的最外层调用数
+     */
+    int countdown = 0;
+};
+
+thread_local TraceThread t_trace;
+
+QString frameName(const QString& plugin, const char* method)
+{
+    return plugin + "::" + QLatin1String(method);
+}
+
+/**
+ * @brief 深度优先遍历调用树（不含根），调用方需持有节点所属缓冲的锁
+ * @param fun 参数为节点与自根起的折叠调用栈
+ */
+template <class Node, class Fun>
+void walk(Node& node, const QString& stack, const Fun& fun)
+{
+    for (auto&& child : node.children) {
+        const auto path = stack.isEmpty() ? frameName(child->plugin, child->method) : stack + ';' + frameName(child->plugin, child->method);
+        fun(*child, path);
+        walk(*child, path, fun);
+    }
+}
+
+struct TraceMethod {
+    QString plugin;
+    QString method;
+    std::uint64_t sampled = 0;
+    MetricHistogram latency;
+    QHash<QString, std::uint64_t> callers;
+};
+}
+
+QJsonObject PluginTraceReport::toJson() const
+{
+    QJsonArray list;
+    for (auto&& m : methods) {
+        QJsonObject latency;
+        latency.insert("count", static_cast<qint64>(m.latency.count));
+        latency.insert("sum", static_cast<qint64>(m.latency.sum));
+        latency.insert("min", static_cast<qint64>(m.latency.min));
+        latency.insert("max", static_cast<qint64>(m.latency.max));
+        latency.insert("p50", static_cast<qint64>(m.latency.p50));
+        latency.insert("p90", static_cast<qint64>(m.latency.p90));
+        latency.insert("p99", static_cast<qint64>(m.latency.p99));
+        latency.insert("p999", static_cast<qint64>(m.latency.p999));
+        QJsonObject callers;
+        for (auto it = m.callers.cbegin(); it != m.callers.cend(); ++it) {
+            callers.insert(it.key().isEmpty() ? QString("(host)") : it.key(), static_cast<qint64>(it.value()));
+        }
+        QJsonObject obj;
+        obj.insert("plugin", m.plugin);
+        obj.insert("method", m.method);
+        obj.insert("calls", static_cast<qint64>(m.calls));
+        obj.insert("sampled", static_cast<qint64>(m.sampled));
+        obj.insert("latencyNs", latency);
+        obj.insert("callers", callers);
+        list.append(obj);
+    }
+    QJsonObject obj;
+    obj.insert("sampleEvery", sampleEvery);
+    obj.insert("calls", static_cast<qint64>(calls));
+    obj.insert("methods", list);
+    return obj;
+}
+
+PluginTracer::PluginTracer()
+    : _id(s_nextTracer.fetch_add(1, std::memory_order_relaxed))
+{
+}
+
+PluginTracer::~PluginTracer() { }
+
+void PluginTracer::enable(int sampleEvery)
+{
+    _sampleEvery.store(std::max(sampleEvery, 1), std::memory_order_relaxed);
+    _enabled.store(true, std::memory_order_relaxed);
+}
+
+void PluginTracer::disable()
+{
+    _enabled.store(false, std::memory_order_relaxed);
+}
+
+void PluginTracer::reset()
+{
+    _calls.reset();
+    std::lock_guard lock(_mtx);
+    for (auto&& buffer : _buffers) {
+        std::lock_guard bufferLock(buffer->mtx);
+        // 线程的调用栈可能仍指向节点，只清零统计
+        walk(buffer->root, QString(), [](Node& node, const QString&) {
+            node.sampled.store(0, std::memory_order_relaxed);
+            node.selfNs.store(0, std::memory_order_relaxed);
+            node.latency.reset();
+        });
+    }
+}
+
+PluginTracer::Buffer* PluginTracer::buffer()
+{
+    // 追踪器编号不复用，已销毁追踪器的条目不会再被查到
+    static thread_local std::unordered_map<std::uint64_t, Buffer*> buffers;
+    auto&& slot = buffers[_id];
+    if (!slot) {
+        auto buffer = std::make_unique<Buffer>();
+        slot = buffer.get();
+        std::lock_guard lock(_mtx);
+        _buffers.push_back(std::move(buffer));
+    }
+    return slot;
+}
+
+bool PluginTracer::enter(const QString& plugin, const char* method)
+{
+    _calls.add();
+    auto&& t = t_trace;
+    if (t.skipped > 0) {
+        // 未采样调用内的嵌套调用同样不采样
+        t.skipped++;
+        return false;
+    }
+    if (t.frames.empty()) {
+        if (--t.countdown > 0) {
+            t.skipped = 1;
+            return false;
+        }
+        t.countdown = _sampleEvery.load(std::memory_order_relaxed);
+    }
+    auto buffer = this->buffer();
+    // 嵌套在其他追踪器的调用内时从本线程调用树的根开始
+    auto parent = !t.frames.empty() && t.frames.back().buffer == buffer ? static_cast<Node*>(t.frames.back().node) : &buffer->root;
+    Node* node = nullptr;
+    for (auto&& child : parent->children) {
+        if ((child->method == method || strcmp(child->method, method) == 0) && child->plugin == plugin) {
+            node = child.get();
+            break;
+        }
+    }
+    if (!node) {
+        auto child = std::make_unique<Node>();
+        child->plugin = plugin;
+        child->method = method;
+        child->parent = parent;
+        node = child.get();
+        std::lock_guard lock(buffer->mtx);
+        parent->children.push_back(std::move(child));
+    }
+    t.frames.push_back(TraceFrame { buffer, node, std::chrono::steady_clock::now(), 0 });
+    return true;
+}
+
+void PluginTracer::leave(bool sampled)
+{
+    auto&& t = t_trace;
+    if (!sampled) {
+        t.skipped--;
+        return;
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const auto frame = std::move(t.frames.back());
+    t.frames.pop_back();
+    const auto totalNs = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - frame.start).count());
+    const auto selfNs = totalNs > frame.childNs ? totalNs - frame.childNs : 0;
+    if (!t.frames.empty()) {
+        t.frames.back().childNs += totalNs;
+    }
+    auto node = static_cast<Node*>(frame.node);
+    node->sampled.fetch_add(1, std::memory_order_relaxed);
+    node->selfNs.fetch_add(selfNs, std::memory_order_relaxed);
+    node->latency.record(totalNs);
+}
+
+PluginTraceReport PluginTracer::report() const
+{
+    PluginTraceReport report;
+    report.sampleEvery = _sampleEvery.load(std::memory_order_relaxed);
+    report.calls = _calls.value();
+    // 键为 "插件::方法"
+    QHash<QString, std::shared_ptr<TraceMethod>> methods;
+    {
+        std::lock_guard lock(_mtx);
+        for (auto&& buffer : _buffers) {
+            std::lock_guard bufferLock(buffer->mtx);
+            const auto root = &buffer->root;
+            walk(buffer->root, QString(), [&methods, root](const Node& node, const QString&) {
+                const auto sampled = node.sampled.load(std::memory_order_relaxed);
+                if (sampled == 0) {
+                    return;
+                }
+                auto&& method = methods[frameName(node.plugin, node.method)];
+                if (!method) {
+                    method = std::make_shared<TraceMethod>();
+                    method->plugin = node.plugin;
+                    method->method = QLatin1String(node.method);
+                }
+                method->sampled += sampled;
+                method->latency.merge(node.latency);
+                method->callers[node.parent == root ? QString() : node.parent->plugin] += sampled;
+            });
+        }
+    }
+    for (auto&& method : methods) {
+        PluginTraceMethod m;
+        m.plugin = method->plugin;
+        m.method = method->method;
+        m.sampled = method->sampled;
+        m.calls = method->sampled * static_cast<std::uint64_t>(report.sampleEvery);
+        m.latency = method->latency.snapshot();
+        m.callers = method->callers;
+        report.methods.append(m);
+    }
+    std::sort(report.methods.begin(), report.methods.end(), [](const PluginTraceMethod& a, const PluginTraceMethod& b) {
+        return a.latency.sum > b.latency.sum;
+    });
+    return report;
+}
+
+QString PluginTracer::folded() const
+{
+    // {折叠调用栈，自身耗时纳秒}
+    QHash<QString, std::uint64_t> stacks;
+    {
+        std::lock_guard lock(_mtx);
+        for (auto&& buffer : _buffers) {
+            std::lock_guard bufferLock(buffer->mtx);
+            walk(buffer->root, QString(), [&stacks](const Node& node, const QString& stack) {
+                if (node.sampled.load(std::memory_order_relaxed) > 0) {
+                    stacks[stack] += node.selfNs.load(std::memory_order_relaxed);
+                }
+            });
+        }
+    }
+    QStringList lines;
+    for (auto it = stacks.cbegin(); it != stacks.cend(); ++it) {
+        // 不足 1 微秒的栈仍输出，火焰图中保留调用路径
+        lines.append(QString("%1 %2").arg(it.key()).arg(static_cast<qulonglong>(std::max<std::uint64_t>(it.value() / 1000, 1))));
+    }
+    lines.sort();
+    return lines.join('\n') + (lines.isEmpty() ? "" : "\n");
+}
+
+bool PluginTracer::writeFolded(const QString& path) const
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(folded().toUtf8());
+    return file.commit();
+}
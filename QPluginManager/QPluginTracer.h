@@ -0,0 +1,172 @@
+﻿#pragma once
+
+#include <QtCore/qglobal.h>
+
+#ifndef BUILD_STATIC
+#if defined(QPLUGINMANAGER_LIB)
+#define QPLUGINMANAGER_EXPORT Q_DECL_EXPORT
+#else
+#define QPLUGINMANAGER_EXPORT Q_DECL_IMPORT
+#endif
+#else
+#define QPLUGINMANAGER_EXPORT
+#endif
+
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QString>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "QPluginMetrics.h"
+
+/**
+ * @brief 单个插件方法的调用统计
+ */
+struct PluginTraceMethod {
+    QString plugin;
+    QString method;
+    /**
+     * @brief 估计调用次数，即采样次数乘以采样间隔
+     */
+    std::uint64_t calls = 0;
+    std::uint64_t sampled = 0;
+    /**
+     * @brief 采样调用的耗时（纳秒），含被调插件内部的嵌套调用
+     */
+    HistogramSnapshot latency;
+    /**
+     * @brief {调用方插件，采样次数}，不在追踪调用中发起的调用记为空字符串
+     */
+    QHash<QString, std::uint64_t> callers;
+};
+
+/**
+ * @brief 调用追踪报告
+ */
+struct QPLUGINMANAGER_EXPORT PluginTraceReport {
+    int sampleEvery = 0;
+    /**
+     * @brief 启用期间经追踪层的全部调用次数（含未采样）
+     */
+    std::uint64_t calls = 0;
+    QList<PluginTraceMethod> methods;
+
+    QJsonObject toJson() const;
+};
+
+/**
+ * @brief 插件方法调用追踪：记录经 QPluginManager::invoke/call、CallPluginPtr 与调度器任务进入插件的调用，
+ *        统计调用次数、耗时直方图与调用方插件，并按调用栈汇总为火焰图折叠格式（flamegraph.pl、speedscope 可直接读取）。
+ *        按线程的最外层调用采样，被采样调用内的嵌套调用一并记录；关闭时每次调用只有一次原子读。
+ *        各线程把采样写入自己的调用树，调用路径上不取全局锁也不拼接字符串，读取报告时再按方法与调用栈汇总
+ */
+class QPLUGINMANAGER_EXPORT PluginTracer {
+public:
+    PluginTracer();
+    ~PluginTracer();
+
+    PluginTracer(const PluginTracer&) = delete;
+    PluginTracer& operator=(const PluginTracer&) = delete;
+
+    /**
+     * @brief 开启追踪
+     * @param sampleEvery 每个线程每 N 次最外层调用采样一次，1 为全部采样；默认稀疏采样，可在线上常开
+     */
+    void enable(int sampleEvery = 100);
+
+    void disable();
+
+    bool isEnabled() const
+    {
+        return _enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 清空统计
+     */
+    void reset();
+
+    PluginTraceReport report() const;
+
+    /**
+     * @brief 火焰图折叠格式：每行 "插件::方法;插件::方法 自身耗时（微秒）"
+     * @return
+     */
+    QString folded() const;
+
+    /**
+     * @brief 把折叠格式写入文件
+     * @param path 文件路径
+     * @return 写入失败时返回 false
+     */
+    bool writeFolded(const QString& path) const;
+
+private:
+    friend class PluginTraceScope;
+
+    struct Node;
+    struct Buffer;
+
+    /**
+     * @brief 进入调用
+     * @return 本次调用是否被采样
+     */
+    bool enter(const QString& plugin, const char* method);
+
+    /**
+     * @brief 离开调用
+     * @param sampled enter 的返回值
+     */
+    void leave(bool sampled);
+
+    /**
+     * @brief 当前线程的调用树，首次使用时登记
+     * @return
+     */
+    Buffer* buffer();
+
+    const std::uint64_t _id;
+    std::atomic_bool _enabled { false };
+    std::atomic_int _sampleEvery { 100 };
+    MetricCounter _calls;
+
+    /**
+     * @brief 保护 _buffers，只在线程首次采样与读取报告时获取
+     */
+    mutable std::mutex _mtx;
+    std::vector<std::unique_ptr<Buffer>> _buffers;
+};
+
+/**
+ * @brief 作用域内的代码记为一次插件方法调用；追踪关闭时只读一次开关
+ */
+class QPLUGINMANAGER_EXPORT PluginTraceScope {
+public:
+    PluginTraceScope(PluginTracer& tracer, const QString& plugin, const char* method)
+        : _tracer(tracer.isEnabled() ? &tracer : nullptr)
+    {
+        if (_tracer) {
+            _sampled = _tracer->enter(plugin, method);
+        }
+    }
+
+    ~PluginTraceScope()
+    {
+        if (_tracer) {
+            _tracer->leave(_sampled);
+        }
+    }
+
+    PluginTraceScope(const PluginTraceScope&) = delete;
+    PluginTraceScope& operator=(const PluginTraceScope&) = delete;
+
+private:
+    PluginTracer* _tracer = nullptr;
+    bool _sampled = false;
+};
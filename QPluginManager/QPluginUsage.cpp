@@ -0,0 +1,147 @@
+﻿#include "QPluginUsage.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <limits>
+
+bool PluginUsageProfile::load(const QString& path)
+{
+    QFile file(path);
+    if (!file.exists()) {
+        return true;
+    }
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QJsonParseError err {};
+    auto&& doc = QJsonDocument::fromJson(file.readAll(), &err);
+    if (err.error != QJsonParseError::NoError || !doc.isObject()) {
+        return false;
+    }
+    auto&& obj = doc.object();
+    sessions = obj.value("sessions").toInt();
+    records.clear();
+    auto&& plugins = obj.value("plugins").toObject();
+    for (auto it = plugins.begin(); it != plugins.end(); ++it) {
+        auto&& p = it.value().toObject();
+        PluginUsageRecord record;
+        record.firstSeen = p.value("firstSeen").toInt(-1);
+        record.lastUsed = p.value("lastUsed").toInt(-1);
+        record.sessionsUsed = p.value("sessionsUsed").toInt();
+        record.firstAccessMs = static_cast<qint64>(p.value("firstAccessMs").toDouble(-1));
+        records.insert(it.key(), record);
+    }
+    overrides.clear();
+    auto&& list = obj.value("overrides").toObject();
+    for (auto it = list.begin(); it != list.end(); ++it) {
+        auto&& value = it.value().toString().toLower();
+        if (value == "eager") {
+            overrides.insert(it.key(), PluginActivation::Eager);
+        } else if (value == "deferred") {
+            overrides.insert(it.key(), PluginActivation::Deferred);
+        }
+    }
+    return true;
+}
+
+bool PluginUsageProfile::save(const QString& path) const
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(QJsonDocument(toJson()).toJson());
+    return file.commit();
+}
+
+void PluginUsageProfile::beginSession()
+{
+    ++sessions;
+}
+
+void PluginUsageProfile::markSeen(const QString& name)
+{
+    auto&& record = records[name];
+    if (record.firstSeen < 0) {
+        record.firstSeen = session();
+    }
+}
+
+void PluginUsageProfile::markUsed(const QString& name, qint64 firstAccessMs)
+{
+    markSeen(name);
+    auto&& record = records[name];
+    if (record.lastUsed != session()) {
+        record.lastUsed = session();
+        ++record.sessionsUsed;
+    }
+    record.firstAccessMs = firstAccessMs;
+}
+
+bool PluginUsageProfile::isDeferred(const QString& name, int idleSessions) const
+{
+    switch (overrides.value(name, PluginActivation::Auto)) {
+    case PluginActivation::Eager:
+        return false;
+    case PluginActivation::Deferred:
+        return true;
+    default:
+        break;
+    }
+    // 新插件或记录不足时留在关键路径上
+    auto it = records.find(name);
+    if (it == records.end() || it->firstSeen < 0) {
+        return false;
+    }
+    const auto lastActive = std::max(it->lastUsed, it->firstSeen);
+    return session() - lastActive > idleSessions;
+}
+
+QList<QString> PluginUsageProfile::prioritize(const QList<QString>& names) const
+{
+    QList<QString> out = names;
+    std::stable_sort(out.begin(), out.end(), [this](const QString& a, const QString& b) {
+        auto&& ra = records.value(a);
+        auto&& rb = records.value(b);
+        if (ra.sessionsUsed != rb.sessionsUsed) {
+            return ra.sessionsUsed > rb.sessionsUsed;
+        }
+        // 未访问过的排在最后
+        const auto fa = ra.firstAccessMs < 0 ? std::numeric_limits<qint64>::max() : ra.firstAccessMs;
+        const auto fb = rb.firstAccessMs < 0 ? std::numeric_limits<qint64>::max() : rb.firstAccessMs;
+        return fa < fb;
+    });
+    return out;
+}
+
+QJsonObject PluginUsageProfile::toJson() const
+{
+    QJsonObject plugins;
+    for (auto it = records.begin(); it != records.end(); ++it) {
+        QJsonObject p;
+        p.insert("firstSeen", it->firstSeen);
+        p.insert("lastUsed", it->lastUsed);
+        p.insert("sessionsUsed", it->sessionsUsed);
+        p.insert("firstAccessMs", it->firstAccessMs);
+        plugins.insert(it.key(), p);
+    }
+    QJsonObject list;
+    for (auto it = overrides.begin(); it != overrides.end(); ++it) {
+        if (it.value() == PluginActivation::Eager) {
+            list.insert(it.key(), "eager");
+        } else if (it.value() == PluginActivation::Deferred) {
+            list.insert(it.key(), "deferred");
+        }
+    }
+    QJsonObject obj;
+    obj.insert("sessions", sessions);
+    obj.insert("plugins", plugins);
+    obj.insert("overrides", list);
+    return obj;
+}
@@ -0,0 +1,128 @@
+﻿#pragma once
+
+#include <QtCore/qglobal.h>
+
+#ifndef BUILD_STATIC
+#if defined(QPLUGINMANAGER_LIB)
+#define QPLUGINMANAGER_EXPORT Q_DECL_EXPORT
+#else
+#define QPLUGINMANAGER_EXPORT Q_DECL_IMPORT
+#endif
+#else
+#define QPLUGINMANAGER_EXPORT
+#endif
+
+#include <QJsonObject>
+#include <QList>
+#include <QMap>
+#include <QString>
+
+/**
+ * @brief 插件激活方式
+ */
+enum class PluginActivation {
+    /**
+     * @brief 由使用记录决定
+     */
+    Auto,
+    /**
+     * @brief 总在启动关键路径上初始化
+     */
+    Eager,
+    /**
+     * @brief 总是延后到 delayedInitialize 之后或首次 load 时激活
+     */
+    Deferred,
+};
+
+/**
+ * @brief 单个插件的跨会话使用记录
+ */
+struct PluginUsageRecord {
+    /**
+     * @brief 首次出现的会话序号
+     */
+    int firstSeen = -1;
+    /**
+     * @brief 最近一次被访问的会话序号，从未访问为 -1
+     */
+    int lastUsed = -1;
+    /**
+     * @brief 被访问过的会话数
+     */
+    int sessionsUsed = 0;
+    /**
+     * @brief 最近一次会话中首次访问距启动的毫秒数，从未访问为 -1
+     */
+    qint64 firstAccessMs = -1;
+};
+
+/**
+ * @brief 插件使用画像，按会话记录哪些插件经 load()/GetPluginPtr 被访问过，持久化为本地 JSON 文件
+ */
+class QPLUGINMANAGER_EXPORT PluginUsageProfile {
+public:
+    /**
+     * @brief 读取画像文件，文件不存在时为空画像
+     * @param path 文件路径
+     * @return 文件存在但无法解析时返回 false
+     */
+    bool load(const QString& path);
+
+    /**
+     * @brief 原子写入画像文件
+     * @param path 文件路径
+     * @return
+     */
+    bool save(const QString& path) const;
+
+    /**
+     * @brief 开始新会话
+     */
+    void beginSession();
+
+    /**
+     * @brief 当前会话序号
+     */
+    int session() const { return sessions - 1; }
+
+    /**
+     * @brief 记录插件在当前会话中出现
+     * @param name 插件名
+     */
+    void markSeen(const QString& name);
+
+    /**
+     * @brief 记录插件在当前会话中被访问
+     * @param name 插件名
+     * @param firstAccessMs 首次访问距启动的毫秒数
+     */
+    void markUsed(const QString& name, qint64 firstAccessMs);
+
+    /**
+     * @brief 结合覆盖表与使用记录判断插件是否延后激活
+     * @param name 插件名
+     * @param idleSessions 连续未使用的会话数阈值
+     * @return
+     */
+    bool isDeferred(const QString& name, int idleSessions) const;
+
+    /**
+     * @brief 按使用频度排序，常用且访问早的在前
+     * @param names 插件名
+     * @return 排序后的插件名
+     */
+    QList<QString> prioritize(const QList<QString>& names) const;
+
+    QJsonObject toJson() const;
+
+    /**
+     * @brief 已记录的会话数
+     */
+    int sessions = 0;
+    QMap<QString, PluginUsageRecord> records;
+    /**
+     * @brief 覆盖表，可在画像文件的 overrides 中按 {插件名: "eager"|"deferred"} 配置
+     */
+    QMap<QString, PluginActivation> overrides;
+};
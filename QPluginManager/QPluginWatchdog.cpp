@@ -0,0 +1,371 @@
+﻿#include "QPluginWatchdog.h"
+
+#include <QJsonArray>
+#include <QThread>
+
+#include "QPluginLogging.h"
+#include "QPluginMetrics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(Q_OS_LINUX) && defined(__GLIBC__)
+#include <csignal>
+#include <execinfo.h>
+#include <pthread.h>
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#include <Windows.h>
+#if defined(_M_X64)
+#include <DbgHelp.h>
+#pragma comment(lib, "dbghelp.lib")
+#endif
+#endif
+
+namespace {
+constexpr int MAX_FRAMES = 64;
+
+#if defined(Q_OS_LINUX) && defined(__GLIBC__)
+/**
+ * @brief 信号处理函数写入的栈采样；静态存放，迟到的信号也不会写入已释放的内存
+ */
+struct SignalSample {
+    void* frames[MAX_FRAMES];
+    std::atomic_int count { -1 };
+};
+
+std::atomic<SignalSample*> g_sample { nullptr };
+
+void onSampleSignal(int)
+{
+    if (auto sample = g_sample.load(std::memory_order_acquire)) {
+        sample->count.store(backtrace(sample->frames, MAX_FRAMES), std::memory_order_release);
+    }
+}
+
+int sampleSignal()
+{
+    static const int sig = []() {
+        // 预先加载 libgcc，信号处理函数中的 backtrace 不再分配内存
+        void* warm[1];
+        backtrace(warm, 1);
+        const int s = SIGRTMIN + 4;
+        struct sigaction action {};
+        action.sa_handler = onSampleSignal;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_RESTART;
+        sigaction(s, &action, nullptr);
+        return s;
+    }();
+    return sig;
+}
+#endif
+}
+
+QJsonObject PluginOverrun::toJson() const
+{
+    QJsonObject obj;
+    obj.insert("plugin", plugin);
+    obj.insert("phase", phase);
+    obj.insert("budgetMs", budgetMs);
+    obj.insert("elapsedMs", elapsedMs);
+    obj.insert("thread", threadName);
+    obj.insert("stack", QJsonArray::fromStringList(stack));
+    return obj;
+}
+
+PluginWatchdog::PluginWatchdog(QObject* parent)
+    : QObject(parent)
+{
+    qRegisterMetaType<PluginOverrun>("PluginOverrun");
+}
+
+PluginWatchdog::~PluginWatchdog()
+{
+    this->suspend();
+}
+
+void PluginWatchdog::suspend()
+{
+    {
+        std::lock_guard lock(_mtx);
+        _stop = true;
+    }
+    _cv.notify_all();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+    std::lock_guard lock(_mtx);
+    _stop = false;
+}
+
+void PluginWatchdog::setPhaseBudget(const QString& phase, qint64 ms)
+{
+    std::lock_guard lock(_mtx);
+    _phaseBudgets.insert(phase, ms);
+}
+
+void PluginWatchdog::setPluginBudget(const QString& plugin, const QString& phase, qint64 ms)
+{
+    std::lock_guard lock(_mtx);
+    _pluginBudgets.insert(plugin + '/' + phase, ms);
+}
+
+qint64 PluginWatchdog::budget(const QString& plugin, const QString& phase) const
+{
+    std::lock_guard lock(_mtx);
+    auto it = _pluginBudgets.constFind(plugin + '/' + phase);
+    if (it != _pluginBudgets.cend()) {
+        return it.value();
+    }
+    it = _pluginBudgets.constFind(plugin + '/');
+    if (it != _pluginBudgets.cend()) {
+        return it.value();
+    }
+    it = _phaseBudgets.constFind(phase);
+    if (it != _phaseBudgets.cend()) {
+        return it.value();
+    }
+    return _phaseBudgets.value(QString(), 0);
+}
+
+void PluginWatchdog::setFailOnOverrun(bool on)
+{
+    std::lock_guard lock(_mtx);
+    _fail = on;
+}
+
+bool PluginWatchdog::failOnOverrun() const
+{
+    std::lock_guard lock(_mtx);
+    return _fail;
+}
+
+quint64 PluginWatchdog::arm(const QString& plugin, const QString& phase, qint64 budgetMs)
+{
+    if (budgetMs <= 0) {
+        return 0;
+    }
+    Watch watch;
+    watch.plugin = plugin;
+    watch.phase = phase;
+    watch.budgetMs = budgetMs;
+    watch.start = std::chrono::steady_clock::now();
+    watch.deadline = watch.start + std::chrono::milliseconds(budgetMs);
+    watch.thread = currentNativeThread();
+    watch.threadName = QThread::currentThread()->objectName();
+    quint64 token = 0;
+    {
+        std::lock_guard lock(_mtx);
+        if (!_thread.joinable()) {
+            _thread = std::thread(&PluginWatchdog::run, this);
+        }
+        token = ++_next;
+        _watches.emplace(token, std::move(watch));
+    }
+    _cv.notify_one();
+    return token;
+}
+
+bool PluginWatchdog::disarm(quint64 token)
+{
+    if (token == 0) {
+        return false;
+    }
+    PluginOverrun info;
+    {
+        std::unique_lock lock(_mtx);
+        // 正在采样本线程时等待采样结束，采样期间线程不能退出
+        _sampled.wait(lock, [this, token]() { return _sampling != token; });
+        auto it = _watches.find(token);
+        if (it == _watches.end()) {
+            return false;
+        }
+        const auto watch = std::move(it->second);
+        _watches.erase(it);
+        const auto now = std::chrono::steady_clock::now();
+        if (watch.fired || now <= watch.deadline) {
+            return watch.fired;
+        }
+        // 看门狗线程尚未发现，阶段已返回，无法再采样调用栈
+        info.plugin = watch.plugin;
+        info.phase = watch.phase;
+        info.budgetMs = watch.budgetMs;
+        info.elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(now - watch.start).count();
+        info.threadName = watch.threadName;
+    }
+    this->report(info);
+    return true;
+}
+
+QList<PluginOverrun> PluginWatchdog::overruns() const
+{
+    std::lock_guard lock(_mtx);
+    return _overruns;
+}
+
+void PluginWatchdog::run()
+{
+    std::unique_lock lock(_mtx);
+    while (!_stop) {
+        const auto now = std::chrono::steady_clock::now();
+        auto next = std::chrono::steady_clock::time_point::max();
+        auto due = _watches.end();
+        for (auto it = _watches.begin(); it != _watches.end(); ++it) {
+            if (it->second.fired) {
+                continue;
+            }
+            if (it->second.deadline <= now) {
+                due = it;
+                break;
+            }
+            next = std::min(next, it->second.deadline);
+        }
+        if (due == _watches.end()) {
+            if (next == std::chrono::steady_clock::time_point::max()) {
+                _cv.wait(lock);
+            } else {
+                _cv.wait_until(lock, next);
+            }
+            continue;
+        }
+        auto&& watch = due->second;
+        watch.fired = true;
+        PluginOverrun info;
+        info.plugin = watch.plugin;
+        info.phase = watch.phase;
+        info.budgetMs = watch.budgetMs;
+        info.elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(now - watch.start).count();
+        info.threadName = watch.threadName;
+        const auto thread = watch.thread;
+        // 采样不持锁，arm/disarm 不被采样拖住；disarm 等待 _sampling 清除，执行线程在采样期间不会退出
+        _sampling = due->first;
+        lock.unlock();
+        info.stack = sampleStack(thread);
+        lock.lock();
+        _sampling = 0;
+        _sampled.notify_all();
+        lock.unlock();
+        this->report(info);
+        lock.lock();
+    }
+}
+
+void PluginWatchdog::report(const PluginOverrun& info)
+{
+    {
+        std::lock_guard lock(_mtx);
+        _overruns.append(info);
+    }
+    if (PluginMetrics::enabled()) {
+        static auto& overruns = PluginMetrics::Instance().counter("manager.watchdog", "overruns");
+        overruns.add();
+    }
+    qCWarning(lcPluginManager) << "插件阶段超时:" << info.plugin << info.phase << info.elapsedMs << "ms, 预算" << info.budgetMs << "ms";
+    for (auto&& frame : info.stack) {
+        qCWarning(lcPluginManager) << "    " << frame;
+    }
+    emit overrun(info);
+}
+
+std::uintptr_t PluginWatchdog::currentNativeThread()
+{
+#if defined(Q_OS_LINUX) && defined(__GLIBC__)
+    return static_cast<std::uintptr_t>(pthread_self());
+#elif defined(Q_OS_WIN)
+    return static_cast<std::uintptr_t>(GetCurrentThreadId());
+#else
+    return 0;
+#endif
+}
+
+QStringList PluginWatchdog::sampleStack(std::uintptr_t thread)
+{
+    QStringList out;
+    if (thread == 0) {
+        return out;
+    }
+#if defined(Q_OS_LINUX) && defined(__GLIBC__)
+    static std::mutex mtx;
+    static SignalSample sample;
+    std::lock_guard lock(mtx);
+    const int sig = sampleSignal();
+    sample.count.store(-1, std::memory_order_relaxed);
+    g_sample.store(&sample, std::memory_order_release);
+    if (pthread_kill(static_cast<pthread_t>(thread), sig) != 0) {
+        g_sample.store(nullptr, std::memory_order_release);
+        return out;
+    }
+    int count = -1;
+    for (int i = 0; i < 200 && (count = sample.count.load(std::memory_order_acquire)) < 0; i++) {
+        usleep(1000);
+    }
+    g_sample.store(nullptr, std::memory_order_release);
+    if (count <= 0) {
+        return out;
+    }
+    if (char** symbols = backtrace_symbols(sample.frames, count)) {
+        // 前两帧为信号处理函数与内核跳板
+        for (int i = 2; i < count; i++) {
+            out.append(QString::fromLocal8Bit(symbols[i]));
+        }
+        free(symbols);
+    }
+#elif defined(Q_OS_WIN) && defined(_M_X64)
+    const auto handle = OpenThread(THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT | THREAD_QUERY_INFORMATION, FALSE, static_cast<DWORD>(thread));
+    if (handle == nullptr) {
+        return out;
+    }
+    DWORD64 frames[MAX_FRAMES];
+    int count = 0;
+    if (SuspendThread(handle) != static_cast<DWORD>(-1)) {
+        CONTEXT context {};
+        context.ContextFlags = CONTEXT_FULL;
+        if (GetThreadContext(handle, &context)) {
+            // 挂起期间只按展开表回溯原始地址：不分配内存、不加载符号，
+            // 目标线程可能正持有堆锁或加载器锁
+            while (count < MAX_FRAMES && context.Rip != 0) {
+                frames[count++] = context.Rip;
+                DWORD64 imageBase = 0;
+                const auto function = RtlLookupFunctionEntry(context.Rip, &imageBase, nullptr);
+                if (function == nullptr) {
+                    // 叶函数，返回地址位于栈顶
+                    context.Rip = *reinterpret_cast<const DWORD64*>(context.Rsp);
+                    context.Rsp += sizeof(DWORD64);
+                } else {
+                    void* handlerData = nullptr;
+                    DWORD64 establisherFrame = 0;
+                    RtlVirtualUnwind(UNW_FLAG_NHANDLER, imageBase, context.Rip, function, &context, &handlerData, &establisherFrame, nullptr);
+                }
+            }
+        }
+        ResumeThread(handle);
+    }
+    CloseHandle(handle);
+    // 恢复线程之后再解析符号；DbgHelp 非线程安全
+    static std::mutex mtx;
+    std::lock_guard lock(mtx);
+    const auto process = GetCurrentProcess();
+    static const bool symbols = []() {
+        SymSetOptions(SYMOPT_UNDNAME | SYMOPT_DEFERRED_LOADS);
+        return SymInitialize(GetCurrentProcess(), nullptr, TRUE) == TRUE;
+    }();
+    alignas(SYMBOL_INFO) char buffer[sizeof(SYMBOL_INFO) + MAX_SYM_NAME];
+    auto info = reinterpret_cast<SYMBOL_INFO*>(buffer);
+    for (int i = 0; i < count; i++) {
+        const auto pc = frames[i];
+        memset(buffer, 0, sizeof(buffer));
+        info->SizeOfStruct = sizeof(SYMBOL_INFO);
+        info->MaxNameLen = MAX_SYM_NAME;
+        DWORD64 displacement = 0;
+        if (symbols && SymFromAddr(process, pc, &displacement, info)) {
+            out.append(QString("%1+0x%2").arg(QString::fromLocal8Bit(info->Name)).arg(displacement, 0, 16));
+        } else {
+            out.append(QString("0x%1").arg(pc, 16, 16, QChar('0')));
+        }
+    }
+#endif
+    return out;
+}
@@ -0,0 +1,172 @@
+﻿#pragma once
+
+#include <QtCore/qglobal.h>
+
+#ifndef BUILD_STATIC
+#if defined(QPLUGINMANAGER_LIB)
+#define QPLUGINMANAGER_EXPORT Q_DECL_EXPORT
+#else
+#define QPLUGINMANAGER_EXPORT Q_DECL_IMPORT
+#endif
+#else
+#define QPLUGINMANAGER_EXPORT
+#endif
+
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QMetaType>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <thread>
+
+/**
+ * @brief 一次阶段超时：插件名、阶段、预算、发现时已耗时与执行线程的栈采样
+ */
+struct QPLUGINMANAGER_EXPORT PluginOverrun {
+    QString plugin;
+    QString phase;
+    qint64 budgetMs = 0;
+    qint64 elapsedMs = 0;
+    QString threadName;
+    /**
+     * @brief 超时时刻执行线程的调用栈，自栈顶起；平台不支持或阶段已返回时为空
+     */
+    QStringList stack;
+
+    QJsonObject toJson() const;
+};
+
+Q_DECLARE_METATYPE(PluginOverrun)
+
+/**
+ * @brief 插件初始化阶段看门狗：阶段开始时登记截止时间，后台线程在超时时采样执行线程的调用栈并发出 overrun 信号。
+ *        信号在看门狗线程发出，直连的槽在该线程执行，其他连接按接收者线程排队
+ */
+class QPLUGINMANAGER_EXPORT PluginWatchdog : public QObject {
+    Q_OBJECT
+public:
+    explicit PluginWatchdog(QObject* parent = nullptr);
+    ~PluginWatchdog() override;
+
+    /**
+     * @brief 阶段的默认预算
+     * @param phase 阶段名（initialize、extensionsInitialize、delayedInitialize），为空时作用于全部阶段
+     * @param ms 毫秒，0 表示不限
+     */
+    void setPhaseBudget(const QString& phase, qint64 ms);
+
+    /**
+     * @brief 单个插件的预算，优先于阶段默认预算
+     * @param plugin 插件名
+     * @param phase 阶段名，为空时作用于该插件全部阶段
+     * @param ms 毫秒，0 表示不限
+     */
+    void setPluginBudget(const QString& plugin, const QString& phase, qint64 ms);
+
+    /**
+     * @brief 生效的预算，依次查找 插件+阶段、插件、阶段、全部阶段
+     * @param plugin
+     * @param phase
+     * @return 毫秒，0 表示不限
+     */
+    qint64 budget(const QString& plugin, const QString& phase) const;
+
+    /**
+     * @brief 超时后将插件标记为失败：跳过其后续阶段并从插件表中移除，
+     *        运行在其他线程的插件不再等待其返回
+     * @param on
+     */
+    void setFailOnOverrun(bool on);
+
+    bool failOnOverrun() const;
+
+    /**
+     * @brief 登记一次阶段执行，需在执行阶段的线程调用
+     * @param plugin 插件名
+     * @param phase 阶段名
+     * @param budgetMs 预算，0 时不登记
+     * @return 登记号，0 表示未登记
+     */
+    quint64 arm(const QString& plugin, const QString& phase, qint64 budgetMs);
+
+    /**
+     * @brief 阶段结束，注销登记；阶段在看门狗发现之前刚好超时时在此补记
+     * @param token arm 的返回值
+     * @return 是否超时
+     */
+    bool disarm(quint64 token);
+
+    /**
+     * @brief 已发生的超时记录
+     * @return
+     */
+    QList<PluginOverrun> overruns() const;
+
+    /**
+     * @brief 停止看门狗线程，下次 arm 时重新启动；fork 之前调用
+     */
+    void suspend();
+
+    /**
+     * @brief 采样指定线程当前的调用栈
+     * @param thread 由 currentNativeThread 取得的线程标识
+     * @return 平台不支持时为空
+     */
+    static QStringList sampleStack(std::uintptr_t thread);
+
+    /**
+     * @brief 当前线程的本地标识，供 sampleStack 使用
+     * @return
+     */
+    static std::uintptr_t currentNativeThread();
+
+signals:
+    void overrun(const PluginOverrun& info);
+
+private:
+    struct Watch {
+        QString plugin;
+        QString phase;
+        qint64 budgetMs = 0;
+        std::chrono::steady_clock::time_point start;
+        std::chrono::steady_clock::time_point deadline;
+        std::uintptr_t thread = 0;
+        QString threadName;
+        bool fired = false;
+    };
+
+    void run();
+
+    /**
+     * @brief 记录超时并发出信号，不持有锁调用
+     * @param info
+     */
+    void report(const PluginOverrun& info);
+
+    mutable std::mutex _mtx;
+    std::condition_variable _cv;
+    /**
+     * @brief 正在采样的登记号，采样在锁外进行，结束时经 _sampled 通知 disarm
+     */
+    quint64 _sampling = 0;
+    std::condition_variable _sampled;
+    std::thread _thread;
+    bool _stop = false;
+    bool _fail = false;
+    quint64 _next = 0;
+    std::map<quint64, Watch> _watches;
+    QHash<QString, qint64> _phaseBudgets;
+    /**
+     * @brief {插件名/阶段名，预算}，阶段名为空表示全部阶段
+     */
+    QHash<QString, qint64> _pluginBudgets;
+    QList<PluginOverrun> _overruns;
+};
@@ -0,0 +1,28 @@
+﻿#include "QPluginZygote.h"
+
+#include <QJsonArray>
+
+QJsonObject PluginZygoteReport::toJson() const
+{
+    QJsonArray list;
+    for (auto&& w : workers) {
+        QJsonObject obj;
+        obj.insert("pid", w.pid);
+        obj.insert("forkedAt", w.forkedAt);
+        obj.insert("pauseUs", w.pauseUs);
+        obj.insert("alive", w.alive);
+        obj.insert("memory", w.memory.toJson());
+        list.append(obj);
+    }
+    QJsonObject obj;
+    obj.insert("isWorker", isWorker);
+    if (isWorker) {
+        obj.insert("parentPid", parentPid);
+        obj.insert("spawnUs", spawnUs);
+    }
+    obj.insert("forks", forks);
+    obj.insert("failures", failures);
+    obj.insert("memory", memory.toJson());
+    obj.insert("workers", list);
+    return obj;
+}
@@ -0,0 +1,74 @@
+﻿#pragma once
+
+#include <QtCore/qglobal.h>
+
+#ifndef BUILD_STATIC
+#if defined(QPLUGINMANAGER_LIB)
+#define QPLUGINMANAGER_EXPORT Q_DECL_EXPORT
+#else
+#define QPLUGINMANAGER_EXPORT Q_DECL_IMPORT
+#endif
+#else
+#define QPLUGINMANAGER_EXPORT
+#endif
+
+#include <QJsonObject>
+#include <QList>
+
+#include "QPluginMemory.h"
+
+/**
+ * @brief 孕育进程 fork 出的工作进程
+ */
+struct PluginWorkerProcess {
+    qint64 pid = 0;
+    /**
+     * @brief fork 时刻（毫秒时间戳）
+     */
+    qint64 forkedAt = 0;
+    /**
+     * @brief 孕育进程为本次 fork 暂停的时长（微秒）：beforeFork、停止与重启后台线程、afterFork
+     */
+    qint64 pauseUs = 0;
+    /**
+     * @brief 生成报告时进程是否仍存在（未回收的僵尸进程也视为存在）
+     */
+    bool alive = false;
+    /**
+     * @brief 生成报告时的内存划分
+     */
+    PluginProcessMemory memory;
+};
+
+/**
+ * @brief 孕育进程模式报告
+ */
+struct QPLUGINMANAGER_EXPORT PluginZygoteReport {
+    /**
+     * @brief 当前进程是否为 forkWorker 创建的工作进程
+     */
+    bool isWorker = false;
+    /**
+     * @brief 工作进程中：孕育进程的进程号
+     */
+    qint64 parentPid = 0;
+    /**
+     * @brief 工作进程中：从孕育进程开始 fork 到本进程 afterFork 全部完成的耗时（微秒），否则为 -1
+     */
+    qint64 spawnUs = -1;
+    /**
+     * @brief 孕育进程中：成功 fork 的次数
+     */
+    qint64 forks = 0;
+    qint64 failures = 0;
+    /**
+     * @brief 当前进程的内存划分
+     */
+    PluginProcessMemory memory;
+    /**
+     * @brief 孕育进程中：已创建的工作进程
+     */
+    QList<PluginWorkerProcess> workers;
+
+    QJsonObject toJson() const;
+};
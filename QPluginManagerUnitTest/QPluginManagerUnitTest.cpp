@@ -2,15 +2,37 @@
 
 #include "CppUnitTest.h"
 
+#include <QCoreApplication>
 #include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
 #include <QObject>
+#include <QThread>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(Q_OS_UNIX)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 #include "QLogPluginTest.h"
 #include "QPluginManager.h"
+#include "QThreadPluginTest.h"
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
 namespace QPluginManagerUnitTest {
+struct RegistryTestBase {
+    virtual ~RegistryTestBase() = default;
+};
+
 TEST_CLASS(QPluginManagerUnitTest)
 {
 public:
@@ -36,6 +58,55 @@ public:
         QString error;
         Assert::AreEqual(QPluginManager::Instance().initializes({}, error), true);
     }
+    TEST_METHOD(ThreadAffinity)
+    {
+        QJsonObject json { { "Name", "AffinityTest" }, { "Version", "1.0.0" }, { "ThreadAffinity", "Dedicated" } };
+        auto&& meta = PluginMetaData::fromJson(json, "affinity");
+        Assert::AreEqual(meta.threadAffinity == "Dedicated", true);
+        Assert::AreEqual(PluginMetaData::fromJson(meta.toJson(), "affinity").threadAffinity == "Dedicated", true);
+
+        QStringList releaseLog;
+        {
+            QPluginManager context("unittest.affinity");
+            context.findLoadPlugins(QDir("..").absolutePath());
+            QString error;
+            Assert::AreEqual(context.initializes({}, error), true);
+            const auto threadOf = [&context](const QString& name) -> QThreadPluginTest* {
+                auto&& plugin = context.load(name);
+                return plugin.has_value() ? qobject_cast<QThreadPluginTest*>(plugin.value()) : nullptr;
+            };
+            // Main：初始化后仍在管理线程，各阶段在该线程上执行
+            auto&& main = threadOf("ThreadMain");
+            Assert::AreEqual(main != nullptr, true);
+            Assert::AreEqual(main->thread() == QThread::currentThread(), true);
+            Assert::AreEqual(main->initializeThread() == QThread::currentThread(), true);
+            // Dedicated：每个插件一个以插件名命名的线程，各阶段在该线程上执行
+            auto&& first = threadOf("ThreadDedicatedA");
+            auto&& second = threadOf("ThreadDedicatedB");
+            Assert::AreEqual(first != nullptr && second != nullptr, true);
+            Assert::AreEqual(first->thread() != QThread::currentThread() && first->thread() != second->thread(), true);
+            Assert::AreEqual(first->thread()->objectName() == "ThreadDedicatedA", true);
+            Assert::AreEqual(second->thread()->objectName() == "ThreadDedicatedB", true);
+            Assert::AreEqual(first->initializeThread() == first->thread() && second->initializeThread() == second->thread(), true);
+            // Pool：分配到共享线程池
+            auto&& pooled = threadOf("ThreadPool");
+            Assert::AreEqual(pooled != nullptr, true);
+            Assert::AreEqual(pooled->thread()->objectName().startsWith("QPluginPool-"), true);
+            Assert::AreEqual(pooled->initializeThread() == pooled->thread(), true);
+            SetAppPropertyPtr("QThreadPluginTest.releaseLog", &releaseLog);
+            // 上下文析构时卸载
+        }
+        SetAppPropertyPtr("QThreadPluginTest.releaseLog", nullptr);
+        // 专属线程按加载顺序逐个卸载：插件在自己的线程上 release，该线程结束之后才轮到下一个
+        QStringList dedicated;
+        for (auto&& entry : releaseLog) {
+            if (entry.startsWith("ThreadDedicated")) {
+                dedicated.append(entry);
+            }
+        }
+        const QStringList expected { "ThreadDedicatedA.release", "ThreadDedicatedA.finished", "ThreadDedicatedB.release", "ThreadDedicatedB.finished" };
+        Assert::AreEqual(dedicated == expected, true);
+    }
     TEST_METHOD(GetPtr)
     {
         QPluginManager::Instance().findLoadPlugins(QDir("..").absolutePath());
@@ -49,5 +120,720 @@ public:
         auto&& ptr = qobject_cast<QLogPluginTest*>(opt.value());
         Assert::AreEqual(ptr->log(), true);
     }
+    TEST_METHOD(ConcurrentLookup)
+    {
+        constexpr int readers = 32;
+        constexpr int iterations = 20000;
+        std::atomic_bool start { false };
+        std::atomic_int failures { 0 };
+        std::vector<std::thread> threads;
+        for (int i = 0; i < readers; i++) {
+            threads.emplace_back([&]() {
+                while (!start.load()) {
+                    std::this_thread::yield();
+                }
+                for (int n = 0; n < iterations; n++) {
+                    auto&& names = QPluginManager::Instance().pluginNames();
+                    for (auto&& name : names) {
+                        // 快照中的插件名必须能查到实例
+                        if (!QPluginManager::Instance().load(name).has_value()) {
+                            failures++;
+                        }
+                    }
+                    QPluginManager::Instance().isLoad("QLogPluginTest");
+                }
+            });
+        }
+        start = true;
+        QPluginManager::Instance().findLoadPlugins(QDir("..").absolutePath());
+        for (auto&& t : threads) {
+            t.join();
+        }
+        Assert::AreEqual(failures.load(), 0);
+        Assert::AreEqual(QPluginManager::Instance().pluginNames().isEmpty(), false);
+    }
+    TEST_METHOD(PerThreadInstances)
+    {
+        QPluginManager::Instance().findLoadPlugins(QDir("..").absolutePath());
+        // 独立上下文，不重复初始化其他用例共用的默认上下文
+        QPluginManager context("unittest.perThread");
+        context.findLoadPlugins(QDir("..").absolutePath());
+        QString error;
+        Assert::AreEqual(context.initializes({}, error), true);
+        auto&& shared = context.load("ThreadPerThread").value();
+        PluginInterface* first = nullptr;
+        PluginInterface* second = nullptr;
+        QPluginManager* owner = nullptr;
+        bool initializedHere = false;
+        // 工作线程只收集结果，断言在主线程进行
+        std::thread([&]() {
+            first = context.load("ThreadPerThread").value_or(nullptr);
+            second = context.load("ThreadPerThread").value_or(nullptr);
+            owner = QPluginManager::contextOf(first);
+            auto&& plugin = qobject_cast<QThreadPluginTest*>(first);
+            initializedHere = plugin != nullptr && plugin->initializeThread() == QThread::currentThread();
+        }).join();
+        // 其他线程取得自己的实例，同一线程内缓存，初始化阶段在取用线程上执行
+        Assert::AreEqual(first != nullptr && first != shared && first == second, true);
+        Assert::AreEqual(owner == &context, true);
+        Assert::AreEqual(initializedHere, true);
+        // 线程退出时释放
+        Assert::AreEqual(QPluginManager::contextOf(first) == nullptr, true);
+    }
+    TEST_METHOD(EventBus)
+    {
+        auto&& bus = QPluginManager::Instance().eventBus();
+        EventSubscribeOptions options;
+        options.capacity = 8;
+        options.policy = BackPressure::Reject;
+        int sum = 0;
+        auto&& sub = bus.subscribe<int>("unittest.int", nullptr, [&sum](const int& v) { sum += v; }, options);
+        Assert::AreEqual(sub.isValid(), true);
+        Assert::AreEqual(bus.topic<double>("unittest.int") == nullptr, true);
+        for (int i = 0; i < 10; i++) {
+            bus.publish("unittest.int", i);
+        }
+        auto&& stats = sub.stats();
+        Assert::AreEqual<size_t>(stats.depth, 8);
+        Assert::AreEqual<uint64_t>(stats.dropped, 2);
+        Assert::AreEqual<size_t>(sub.drain(), 8);
+        Assert::AreEqual(sum, 28);
+    }
+    TEST_METHOD(EventBusBlock)
+    {
+        auto&& bus = QPluginManager::Instance().eventBus();
+        EventSubscribeOptions options;
+        options.capacity = 2;
+        options.policy = BackPressure::Block;
+        options.blockTimeout = std::chrono::milliseconds(20);
+        // 投递目标已销毁，队列满后不再等待
+        auto context = new QObject();
+        auto&& sub = bus.subscribe<int>("unittest.block", context, [](const int&) {}, options);
+        delete context;
+        for (int i = 0; i < 5; i++) {
+            bus.publish("unittest.block", i);
+        }
+        Assert::AreEqual<uint64_t>(sub.stats().dropped, 3);
+        // 轮询订阅无人拉取时等待 blockTimeout 后丢弃
+        auto&& polled = bus.subscribe<int>("unittest.block.polled", nullptr, [](const int&) {}, options);
+        const auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < 3; i++) {
+            bus.publish("unittest.block.polled", i);
+        }
+        Assert::AreEqual(std::chrono::steady_clock::now() - begin >= std::chrono::milliseconds(20), true);
+        Assert::AreEqual<uint64_t>(polled.stats().dropped, 1);
+        // 发布者在满队列上睡眠，消费者出队后即被唤醒，不等到 blockTimeout
+        options.blockTimeout = std::chrono::seconds(10);
+        auto&& woken = bus.subscribe<int>("unittest.block.woken", nullptr, [](const int&) {}, options);
+        bus.publish("unittest.block.woken", 0);
+        bus.publish("unittest.block.woken", 1);
+        std::size_t accepted = 0;
+        const auto blocked = std::chrono::steady_clock::now();
+        std::thread publisher([&bus, &accepted]() { accepted = bus.publish("unittest.block.woken", 2); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        woken.drain(1);
+        publisher.join();
+        Assert::AreEqual<std::size_t>(accepted, 1);
+        Assert::AreEqual(std::chrono::steady_clock::now() - blocked < std::chrono::seconds(5), true);
+        Assert::AreEqual<uint64_t>(woken.stats().dropped, 0);
+    }
+    TEST_METHOD(UsageProfile)
+    {
+        PluginUsageProfile profile;
+        for (int i = 0; i < 8; i++) {
+            profile.beginSession();
+            profile.markSeen("Idle");
+            if (i % 2 == 0) {
+                profile.markUsed("Hot", 100);
+            }
+        }
+        profile.markUsed("Early", 10);
+        // Idle 从第 0 个会话起从未使用，已超过 5 个会话
+        Assert::AreEqual(profile.isDeferred("Idle", 5), true);
+        Assert::AreEqual(profile.isDeferred("Hot", 5), false);
+        Assert::AreEqual(profile.isDeferred("Unknown", 5), false);
+        profile.overrides.insert("Idle", PluginActivation::Eager);
+        Assert::AreEqual(profile.isDeferred("Idle", 5), false);
+        auto&& order = profile.prioritize({ "Idle", "Early", "Hot" });
+        Assert::AreEqual(order.first() == "Hot", true);
+        Assert::AreEqual(order.last() == "Idle", true);
+    }
+    TEST_METHOD(DeferredActivation)
+    {
+        const auto path = QDir::temp().absoluteFilePath("QPluginDeferredTest.json");
+        QFile::remove(path);
+        {
+            QPluginManager context("unittest.deferred");
+            context.enableUsageProfile(path);
+            context.setActivation("QLogPluginTest", PluginActivation::Deferred);
+            context.findLoadPlugins(QDir("..").absolutePath());
+            QString error;
+            Assert::AreEqual(context.initializes({}, error), true);
+            // 管理线程阻塞在 join 中，派发给它的阶段无法开始：访问快速失败，插件保持未激活
+            std::optional<PluginInterface*> blocked;
+            std::thread([&]() { blocked = context.load("QLogPluginTest"); }).join();
+            Assert::AreEqual(blocked.has_value(), false);
+            // 同时访问时由一个线程激活，其余等待激活结束，全部取得同一实例
+            constexpr int loaders = 4;
+            std::atomic_int finished { 0 };
+            std::vector<PluginInterface*> results(loaders, nullptr);
+            std::vector<std::thread> threads;
+            for (int i = 0; i < loaders; i++) {
+                threads.emplace_back([&, i]() {
+                    results[i] = context.load("QLogPluginTest").value_or(nullptr);
+                    finished++;
+                });
+            }
+            // 管理线程运行事件循环，执行派发来的阶段
+            while (finished.load() < loaders) {
+                QCoreApplication::processEvents();
+            }
+            for (auto&& t : threads) {
+                t.join();
+            }
+            auto&& plugin = context.load("QLogPluginTest");
+            Assert::AreEqual(plugin.has_value(), true);
+            Assert::AreEqual(std::all_of(results.begin(), results.end(), [&plugin](PluginInterface* result) { return result == plugin.value(); }), true);
+        }
+        QFile::remove(path);
+    }
+    TEST_METHOD(MemoryReport)
+    {
+        QPluginManager::Instance().findLoadPlugins(QDir("..").absolutePath());
+        auto&& report = QPluginManager::Instance().memoryReport();
+        Assert::AreEqual(report.timestamp > 0, true);
+        auto&& it = std::find_if(report.plugins.begin(), report.plugins.end(), [](const PluginMemoryInfo& info) { return info.name == "QLogPluginTest"; });
+        Assert::AreEqual(it != report.plugins.end(), true);
+        auto&& json = report.toJson();
+        Assert::AreEqual(json.value("plugins").toArray().size() == report.plugins.size(), true);
+        Assert::AreEqual(json.value("plugins").toArray().first().toObject().contains("heap"), true);
+
+        // 堆探测默认关闭；启用后新上下文记录实例化与各初始化阶段的堆增量
+        const bool was = PluginMemoryProbe::enabled();
+        PluginMemoryProbe::setEnabled(true);
+        {
+            QPluginManager context("unittest.memory");
+            context.findLoadPlugins(QDir("..").absolutePath());
+            QString error;
+            Assert::AreEqual(context.initializes({}, error), true);
+            auto&& probed = context.memoryReport();
+            auto&& log = std::find_if(probed.plugins.begin(), probed.plugins.end(), [](const PluginMemoryInfo& info) { return info.name == "QLogPluginTest"; });
+            Assert::AreEqual(log != probed.plugins.end(), true);
+            Assert::AreEqual(log->heapDeltas.contains("instance") && log->heapDeltas.contains("initialize"), true);
+        }
+        PluginMemoryProbe::setEnabled(was);
+    }
+    TEST_METHOD(Metrics)
+    {
+        const bool was = PluginMetrics::enabled();
+        PluginMetrics::setEnabled(true);
+        auto&& counter = PluginMetrics::Instance().counter("unittest", "counter");
+        counter.reset();
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++) {
+            threads.emplace_back([]() {
+                for (int i = 0; i < 10000; i++) {
+                    PLUGIN_METRIC_COUNT("unittest", "counter");
+                }
+            });
+        }
+        for (auto&& t : threads) {
+            t.join();
+        }
+        // 各线程写入不同分片，读侧合并
+        Assert::AreEqual<uint64_t>(counter.value(), 40000);
+        Assert::AreEqual<uint64_t>(PluginMetrics::Instance().snapshot().counters.at("unittest/counter"), 40000);
+
+        // 每个2的幂区间 8 档，上界相对误差不超过 12.5%
+        for (std::uint64_t v : { 0ull, 7ull, 8ull, 9ull, 100ull, 1000ull, 123456789ull, (1ull << 40) + 12345 }) {
+            const auto upper = MetricHistogram::BucketUpper(MetricHistogram::BucketOf(v));
+            Assert::AreEqual(upper >= v && upper - v <= v / 8, true);
+        }
+        Assert::AreEqual(MetricHistogram::BucketOf(7) < MetricHistogram::BucketOf(8), true);
+        Assert::AreEqual(MetricHistogram::BucketOf(~0ull) < MetricHistogram::BUCKETS, true);
+
+        auto&& histogram = PluginMetrics::Instance().histogram("unittest", "histogram");
+        histogram.reset();
+        for (std::uint64_t v = 1; v <= 1000; v++) {
+            histogram.record(v);
+        }
+        auto&& s = histogram.snapshot();
+        Assert::AreEqual<uint64_t>(s.count, 1000);
+        Assert::AreEqual<uint64_t>(s.sum, 500500);
+        Assert::AreEqual<uint64_t>(s.min, 1);
+        Assert::AreEqual<uint64_t>(s.max, 1000);
+        Assert::AreEqual(s.p50 >= 500 && s.p50 <= 500 + 500 / 8, true);
+        Assert::AreEqual(s.p99 >= 990 && s.p99 <= 1000, true);
+
+        // 注册表命中按类型计时，未命中按基类计数
+        using Registry = StaticRegistry<RegistryTestBase>;
+        Registry::AddRaw("unittest.metrics", []() -> void* { return new RegistryTestBase(); });
+        const std::string base = RegistryBaseKey<RegistryTestBase>();
+        auto&& hits = PluginMetrics::Instance().histogram("registry.create", base + "/unittest.metrics");
+        auto&& misses = PluginMetrics::Instance().counter("registry.create.miss", base);
+        const auto hitsBefore = hits.snapshot().count;
+        const auto missesBefore = misses.value();
+        Assert::AreEqual(Registry::create("unittest.metrics") != nullptr, true);
+        Assert::AreEqual(Registry::create("unittest.metrics.missing") == nullptr, true);
+        Assert::AreEqual<uint64_t>(hits.snapshot().count - hitsBefore, 1);
+        Assert::AreEqual<uint64_t>(misses.value() - missesBefore, 1);
+        PluginMetrics::setEnabled(was);
+    }
+    TEST_METHOD(GlobalObjects)
+    {
+        struct Tracked {
+            std::vector<int>* order;
+            int id;
+            ~Tracked() { order->push_back(id); }
+        };
+        auto&& registry = GlobalObjectRegistry::Instance();
+        const auto first = registry.slotOf("unittest.first");
+        const auto second = registry.slotOf("unittest.second");
+        Assert::AreEqual(registry.slotOf("unittest.first") == first, true);
+        Assert::AreEqual(first != second && first != GlobalObjectRegistry::npos, true);
+
+        std::vector<int> order;
+        auto a = registry.getOrCreate<Tracked>(first, true, [&order]() { return new Tracked { &order, 1 }; });
+        auto b = registry.getOrCreate<Tracked>(second, true, [&order]() { return new Tracked { &order, 2 }; });
+        // 已构造的槽位不再构造
+        Assert::AreEqual(registry.getOrCreate<Tracked>(first, true, [&order]() { return new Tracked { &order, 3 }; }) == a, true);
+        Assert::AreEqual(registry.get(second) == b, true);
+        // 按构造逆序析构并清空槽位
+        registry.destroyAll();
+        Assert::AreEqual(order == std::vector<int> { 2, 1 }, true);
+        Assert::AreEqual(registry.get(first) == nullptr && registry.get(second) == nullptr, true);
+        Assert::AreEqual(registry.get(GlobalObjectRegistry::npos) == nullptr, true);
+
+        int value = 42;
+        SetAppPropertyPtr("unittest.property", &value);
+        Assert::AreEqual(GetAppPropertyPtr("unittest.property", int) == &value, true);
+        Assert::AreEqual(registry.get(registry.slotOf("unittest.property")) == &value, true);
+        // 运行时键每次解析：同一展开处的不同键写入各自的槽位
+        int other = 7;
+        const char* keys[] = { "unittest.runtime.a", "unittest.runtime.b" };
+        int* values[] = { &value, &other };
+        for (int i = 0; i < 2; i++) {
+            SetAppPropertyPtr(keys[i], values[i]);
+        }
+        for (int i = 0; i < 2; i++) {
+            Assert::AreEqual(GetAppPropertyPtr(keys[i], int) == values[i], true);
+        }
+    }
+    TEST_METHOD(RegistryCrossModule)
+    {
+        QPluginManager::Instance().findLoadPlugins(QDir("..").absolutePath());
+        // 插件动态库中 AUTO_REGISTER 的类型经 RegistryHub 对测试程序可见
+        Assert::AreEqual(StaticRegistry<PluginInterface>::IsRegistered("QLogPluginTestImpl"), true);
+        auto instance = StaticRegistry<PluginInterface>::create("QLogPluginTestImpl");
+        Assert::AreEqual(instance != nullptr && qobject_cast<QLogPluginTest*>(instance.get()) != nullptr, true);
+        Assert::AreEqual(StaticRegistry<PluginInterface>::create("QLogPluginTestImpl.missing") == nullptr, true);
+
+        // 批次撤销只移除本批次注册的项，同名键的先前注册保留
+        using Registry = StaticRegistry<RegistryTestBase>;
+        // 两个数组对象内容相同、地址不同，模拟两个动态库注册同名键
+        static const char kept[] = "unittest.kept";
+        static const char keptAgain[] = "unittest.kept";
+        Registry::AddRaw(kept, []() -> void* { return new RegistryTestBase(); });
+        {
+            RegistryBatch batch;
+            Registry::AddRaw("unittest.reverted", []() -> void* { return new RegistryTestBase(); });
+            Registry::AddRaw(keptAgain, []() -> void* { return new RegistryTestBase(); });
+            // 批次内读取先提交本线程的注册
+            Assert::AreEqual(Registry::IsRegistered("unittest.reverted"), true);
+            Assert::AreEqual(RegistryHub::Instance().revertBatch() >= 1, true);
+        }
+        Assert::AreEqual(Registry::IsRegistered("unittest.reverted"), false);
+        Assert::AreEqual(Registry::IsRegistered("unittest.kept"), true);
+    }
+    TEST_METHOD(RegistrySnapshot)
+    {
+        using Registry = StaticRegistry<RegistryTestBase>;
+        static const char first[] = "unittest.snapshot";
+        Registry::AddRaw(first, []() -> void* { return new RegistryTestBase(); });
+        auto held = Registry::find(first);
+        Assert::AreEqual(held != nullptr, true);
+        const auto before = Registry::entries()->size();
+
+        // 注册表的键须长期有效，预先分配不再扩容
+        static std::vector<std::string> keys(200);
+        std::atomic_bool stop { false };
+        std::atomic_int bad { 0 };
+        std::thread reader([&]() {
+            while (!stop.load()) {
+                auto e = Registry::find(first);
+                if (e == nullptr || std::string_view(e->type_key) != first) {
+                    bad++;
+                }
+                auto list = Registry::entries();
+                if (list->size() < before) {
+                    bad++;
+                }
+            }
+        });
+        for (std::size_t i = 0; i < keys.size(); i++) {
+            keys[i] = "unittest.snapshot." + std::to_string(i);
+            Registry::AddRaw(keys[i].c_str(), []() -> void* { return new RegistryTestBase(); });
+        }
+        stop = true;
+        reader.join();
+        Assert::AreEqual(bad.load(), 0);
+        Assert::AreEqual(Registry::entries()->size() == before + keys.size(), true);
+        // 多次刷新之后先前取得的条目仍然有效
+        Assert::AreEqual(std::string_view(held->type_key) == first, true);
+        std::unique_ptr<RegistryTestBase> created(static_cast<RegistryTestBase*>(held->create()));
+        Assert::AreEqual(created != nullptr, true);
+    }
+    TEST_METHOD(Prefetch)
+    {
+        const auto dir = QDir::temp().absoluteFilePath("QPluginPrefetchTest");
+        QDir(dir).removeRecursively();
+        QDir().mkpath(dir);
+        QStringList paths;
+        for (int i = 0; i < 3; i++) {
+            paths.append(dir + QString("/%1.bin").arg(i));
+            QFile file(paths.last());
+            file.open(QIODevice::WriteOnly);
+            file.write(QByteArray(64 * 1024, 'x'));
+        }
+        Assert::AreEqual(PluginPrefetcher::prefetchFile(paths.first()), qint64(64 * 1024));
+        Assert::AreEqual(PluginPrefetcher::prefetchFile(dir + "/missing.bin"), qint64(-1));
+
+        PluginPrefetcher prefetcher;
+        // 取消后再次追加，被丢弃的文件重新排队
+        prefetcher.prefetch(paths);
+        prefetcher.cancel();
+        prefetcher.prefetch(paths);
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (prefetcher.report().files < paths.size() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        Assert::AreEqual(prefetcher.report().files == paths.size(), true);
+        Assert::AreEqual(prefetcher.report().bytes, qint64(3 * 64 * 1024));
+
+        const bool warm = prefetcher.beginLoad(paths.first());
+        Assert::AreEqual(warm, true);
+        prefetcher.endLoad(paths.first(), warm, 10);
+        Assert::AreEqual(prefetcher.beginLoad(dir + "/other.bin"), false);
+        auto&& report = prefetcher.report();
+        Assert::AreEqual(report.loadUs, qint64(10));
+        Assert::AreEqual(report.warmPrefetchUs == report.entries.first().prefetchUs, true);
+        QDir(dir).removeRecursively();
+    }
+    TEST_METHOD(LogSink)
+    {
+        auto&& sink = PluginLogSink::Instance();
+        const auto path = QDir::temp().absoluteFilePath("QPluginLogSinkTest.log");
+        QFile::remove(path);
+        Assert::AreEqual(sink.install(path), true);
+        const auto before = sink.written();
+        for (int i = 0; i < 1000; i++) {
+            qCInfo(lcPluginManager) << "LogSink" << i;
+        }
+        sink.flush();
+        Assert::AreEqual(sink.written() - before + sink.dropped() >= 1000, true);
+        sink.uninstall();
+        Assert::AreEqual(sink.isInstalled(), false);
+        Assert::AreEqual(QFileInfo(path).size() > 0, true);
+    }
+    TEST_METHOD(Watchdog)
+    {
+        PluginWatchdog watchdog;
+        watchdog.setPhaseBudget("initialize", 20);
+        watchdog.setPluginBudget("Slow", "", 0);
+        Assert::AreEqual(watchdog.budget("Any", "initialize") == 20, true);
+        Assert::AreEqual(watchdog.budget("Slow", "initialize") == 0, true);
+        std::atomic_int fired { 0 };
+        QObject::connect(&watchdog, &PluginWatchdog::overrun, [&fired](const PluginOverrun&) { fired++; });
+        const auto fast = watchdog.arm("Fast", "initialize", watchdog.budget("Fast", "initialize"));
+        Assert::AreEqual(watchdog.disarm(fast), false);
+        const auto slow = watchdog.arm("Blocked", "initialize", watchdog.budget("Blocked", "initialize"));
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        Assert::AreEqual(watchdog.disarm(slow), true);
+        Assert::AreEqual(fired.load(), 1);
+        auto&& overruns = watchdog.overruns();
+        Assert::AreEqual(overruns.size() == 1 && overruns.first().plugin == "Blocked", true);
+    }
+    TEST_METHOD(Buffers)
+    {
+        auto&& buffers = QPluginManager::Instance().buffers();
+        auto channel = buffers.channel("unittest.frames", 4);
+        const char* data = nullptr;
+        {
+            auto buffer = buffers.allocate(100000);
+            Assert::AreEqual(buffer.capacity() == 131072 && buffer.size() == 100000, true);
+            data = buffer.data();
+            Assert::AreEqual(channel->push(std::move(buffer)), true);
+            Assert::AreEqual(buffer.isNull(), true);
+        }
+        PluginBuffer received;
+        Assert::AreEqual(channel->pop(received), true);
+        // 句柄转移，数据未复制
+        Assert::AreEqual(received.data() == data && received.isUnique(), true);
+        received.reset();
+        // 归还的块被复用
+        Assert::AreEqual(buffers.allocate(70000).data() == data, true);
+        // 共享内存不可用时退回堆，计数记在实际来源上
+        auto shared = buffers.allocate(1000, PluginBufferBacking::SharedMemory);
+        Assert::AreEqual(shared.span().size() == shared.size() && shared.view().size() == 1000, true);
+        auto&& stats = buffers.stats();
+        Assert::AreEqual(stats.channels.size() >= 1 && stats.classes.size() >= 1, true);
+        const auto used = std::find_if(stats.classes.cbegin(), stats.classes.cend(), [&shared](const PluginBufferClassStats& c) {
+            return c.backing == shared.backing() && c.blockSize == shared.capacity();
+        });
+        Assert::AreEqual(used != stats.classes.cend() && used->allocations >= 1 && used->inUse >= 1, true);
+    }
+    TEST_METHOD(Scheduler)
+    {
+        PluginScheduler scheduler;
+        scheduler.setWorkerCount(4);
+        std::atomic_int count { 0 };
+        std::vector<PluginTask> tasks;
+        for (int i = 0; i < 1000; i++) {
+            tasks.push_back(scheduler.submit(i % 2 ? "A" : "B", [&count]() { count++; }, static_cast<PluginTaskPriority>(i % 3)));
+        }
+        for (auto&& task : tasks) {
+            task.wait();
+        }
+        Assert::AreEqual(count.load(), 1000);
+        std::atomic_int step { 0 };
+        int first = -1;
+        int second = -1;
+        auto head = scheduler.submit("C", [&]() { first = step++; });
+        head.then([&]() { second = step++; }).wait();
+        Assert::AreEqual(first == 0 && second == 1, true);
+        // 取消分组：执行中的任务轮询到取消后返回，排队中的任务不再执行
+        std::atomic_bool started { false };
+        auto running = scheduler.submit("D", [&started]() {
+            started = true;
+            while (!PluginScheduler::isCancelled()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+        while (!started) {
+            std::this_thread::yield();
+        }
+        auto follow = running.then([&count]() { count++; });
+        scheduler.cancel("D");
+        follow.wait();
+        Assert::AreEqual(running.status() == PluginTaskStatus::Finished && follow.status() == PluginTaskStatus::Cancelled, true);
+        // 取消后的分组在 reopen 之前拒绝新提交
+        auto late = scheduler.submit("D", [&count]() { count++; });
+        late.wait();
+        Assert::AreEqual(late.status() == PluginTaskStatus::Cancelled, true);
+        scheduler.reopen("D");
+        auto reopened = scheduler.submit("D", [&count]() { count++; });
+        reopened.wait();
+        Assert::AreEqual(reopened.status() == PluginTaskStatus::Finished, true);
+        auto&& stats = scheduler.stats();
+        Assert::AreEqual(stats.workers, 4);
+        Assert::AreEqual(stats.groups.size() >= 4, true);
+    }
+    TEST_METHOD(MetaDataQuery)
+    {
+        auto&& metas = QPluginManager::Instance().scanMetaData(QDir("..").absolutePath());
+        Assert::AreEqual(metas.isEmpty(), false);
+        auto&& meta = QPluginManager::Instance().metaData("QLogPluginTest");
+        Assert::AreEqual(meta.has_value(), true);
+        Assert::AreEqual(meta->required, true);
+        Assert::AreEqual(QPluginManager::Instance().pluginsByCategory("test").isEmpty(), false);
+        Assert::AreEqual(QPluginManager::Instance().pluginsByVendor("CN").isEmpty(), false);
+        Assert::AreEqual(QPluginManager::Instance().pluginsInVersionRange("0.0", "0.1").isEmpty(), false);
+        Assert::AreEqual(QPluginManager::Instance().pluginsInVersionRange("1.0", "2.0", "QLogPluginTest").isEmpty(), true);
+    }
+    TEST_METHOD(BundleMetaData)
+    {
+        QJsonObject desc { { "Category", "test" } };
+        QJsonObject meta {
+            { "Name", "QTestBundle" },
+            { "Interface", "PluginBundle" },
+            { "Version", "1.2.0" },
+            { "Descriptions", desc },
+            { "Plugins", QJsonArray {
+                QJsonObject { { "Name", "BundleA" }, { "Dependencies", QJsonArray { "BundleB", "QLogPluginTest" } } },
+                QJsonObject { { "Name", "BundleB" }, { "Class", "ns::BundleB" }, { "Version", "2.0" } },
+            } },
+        };
+        auto&& entries = PluginMetaData::fromJsonList(meta, "bundle");
+        Assert::AreEqual(static_cast<int>(entries.size()), 2);
+        // 包内依赖排在前面，包外依赖不影响顺序
+        Assert::AreEqual(entries[0].name == "BundleB" && entries[0].className == "ns::BundleB", true);
+        Assert::AreEqual(entries[1].name == "BundleA" && entries[1].className == "BundleA", true);
+        // 包级字段作为缺省值
+        Assert::AreEqual(entries[1].isValid() && entries[1].bundle == "QTestBundle", true);
+        Assert::AreEqual(entries[1].version == PluginVersion::parse("1.2.0") && entries[1].category == "test", true);
+        Assert::AreEqual(entries[0].version == PluginVersion::parse("2.0"), true);
+        PluginCatalog catalog;
+        for (auto&& entry : entries) {
+            catalog.insert(entry);
+        }
+        Assert::AreEqual(catalog.size() == 2 && catalog.find("BundleA") != nullptr, true);
+        Assert::AreEqual(catalog.findByPath("bundle")->name == "BundleB", true);
+    }
+    TEST_METHOD(Rescan)
+    {
+        QPluginManager::Instance().findLoadPlugins(QDir("..").absolutePath());
+        auto&& names = QPluginManager::Instance().pluginNames();
+        // 目录与插件文件均未变化：不加载新插件，已加载的文件不再读取
+        auto&& stats = QPluginManager::Instance().rescan();
+        Assert::AreEqual(stats.directories > 0, true);
+        Assert::AreEqual(stats.loaded, 0);
+        Assert::AreEqual(stats.skipped > 0, true);
+        Assert::AreEqual(QPluginManager::Instance().pluginNames() == names, true);
+        Assert::AreEqual(QPluginManager::Instance().rescan(true).loaded, 0);
+        // 无法加载的文件按自身的修改时间与大小跳过，目录未变化而文件被原地改写时重新尝试
+        const auto dir = QDir::temp().absoluteFilePath("QPluginManagerRescanTest");
+        QDir().mkpath(dir);
+        QFile broken(dir + "/broken.dll");
+        Assert::AreEqual(broken.open(QIODevice::WriteOnly | QIODevice::Truncate) && broken.write("broken") == 6, true);
+        broken.close();
+        QPluginManager::Instance().loadPlugins(dir);
+        const auto unchanged = QPluginManager::Instance().rescan().candidates;
+        Assert::AreEqual(broken.open(QIODevice::Append) && broken.write("!") == 1, true);
+        broken.close();
+        Assert::AreEqual(QPluginManager::Instance().rescan().candidates, unchanged + 1);
+        Assert::AreEqual(QPluginManager::Instance().rescan().candidates, unchanged);
+        broken.remove();
+    }
+    TEST_METHOD(Zygote)
+    {
+        QPluginManager context("zygote");
+        // 本工程只在 Windows 构建；Linux 下的 fork 路径由 QPluginZygoteTest（CMake + ctest）编译与运行
+#if defined(Q_OS_UNIX)
+        context.findLoadPlugins(QDir("..").absolutePath());
+        const auto pid = context.forkWorker();
+        if (pid == 0) {
+            // 工作进程：插件仍可调用，结果经退出码交给孕育进程，不回到测试框架
+            auto&& plugin = context.load("QLogPluginTest");
+            auto&& log = plugin.has_value() ? qobject_cast<QLogPluginTest*>(plugin.value()) : nullptr;
+            _exit(log && log->log() ? 0 : 1);
+        }
+        Assert::AreEqual(pid > 0, true);
+        int status = -1;
+        Assert::AreEqual(waitpid(static_cast<pid_t>(pid), &status, 0) == static_cast<pid_t>(pid), true);
+        Assert::AreEqual(WIFEXITED(status) && WEXITSTATUS(status) == 0, true);
+        auto&& report = context.zygoteReport();
+        Assert::AreEqual(report.isWorker, false);
+        Assert::AreEqual(report.failures, qint64(0));
+        Assert::AreEqual(report.workers.size() == 1, true);
+#else
+        // Windows 不支持 fork
+        Assert::AreEqual(context.forkWorker(), qint64(-1));
+        auto&& report = context.zygoteReport();
+        Assert::AreEqual(report.isWorker, false);
+        Assert::AreEqual(report.failures, qint64(1));
+        Assert::AreEqual(report.workers.isEmpty(), true);
+#endif
+    }
+    TEST_METHOD(Tracer)
+    {
+        QPluginManager::Instance().findLoadPlugins(QDir("..").absolutePath());
+        auto&& tracer = QPluginManager::Instance().tracer();
+        tracer.reset();
+        tracer.enable(1);
+        Assert::AreEqual(CallPluginPtr(QLogPluginTest, log).has_value(), true);
+        // 任务内的调用以任务所属插件为调用方
+        QPluginManager::Instance().scheduler().submit("QLogPluginTest", []() { CallPluginPtr(QLogPluginTest, log); }).wait();
+        tracer.disable();
+        Assert::AreEqual(CallPluginPtr(QLogPluginTest, log).has_value(), true);
+        auto&& report = tracer.report();
+        Assert::AreEqual(static_cast<int>(report.calls), 3);
+        auto&& it = std::find_if(report.methods.begin(), report.methods.end(), [](const PluginTraceMethod& m) { return m.method == "log"; });
+        Assert::AreEqual(it != report.methods.end(), true);
+        Assert::AreEqual(static_cast<int>(it->sampled), 2);
+        Assert::AreEqual(it->callers.contains("") && it->callers.contains("QLogPluginTest"), true);
+        Assert::AreEqual(tracer.folded().contains("QLogPluginTest::task;QLogPluginTest::log "), true);
+    }
+    TEST_METHOD(StateCache)
+    {
+        const auto dir = QDir::temp().absoluteFilePath("QPluginStateTest");
+        QDir(dir).removeRecursively();
+        QDir().mkpath(dir);
+        // 以临时文件代替插件文件
+        const auto library = dir + "/plugin.bin";
+        {
+            QFile file(library);
+            Assert::AreEqual(file.open(QIODevice::WriteOnly), true);
+            file.write("library");
+        }
+        const auto fingerprint = PluginStateCache::fingerprint(library, "1.0.0");
+        Assert::AreEqual(fingerprint == PluginStateCache::fingerprint(library, "1.0.0"), true);
+        Assert::AreEqual(fingerprint == PluginStateCache::fingerprint(library, "1.0.1"), false);
+        Assert::AreEqual(fingerprint == PluginStateCache::fingerprint(library, "1.0.0", "config"), false);
+        QByteArray restored;
+        {
+            PluginStateCache cache;
+            cache.setDirectory(dir);
+            Assert::AreEqual(cache.read("A", fingerprint, [](const QByteArray&) { return true; }), false);
+            cache.write("A", fingerprint, "first");
+            cache.write("A", fingerprint, "checkpoint");
+            cache.write("B", fingerprint, "other");
+            cache.flush();
+            Assert::AreEqual(cache.read("A", fingerprint, [&restored](const QByteArray& state) {
+                restored = QByteArray(state.constData(), state.size());
+                return true;
+            }), true);
+            Assert::AreEqual(restored == "checkpoint", true);
+            // 插件名中的路径分隔符不会把条目写到缓存目录之外
+            cache.write("../C", fingerprint, "escaped");
+            cache.flush();
+            Assert::AreEqual(QFileInfo::exists(QDir::temp().absoluteFilePath("C.state")), false);
+            // 数据只在回调内有效，保留时深复制
+            Assert::AreEqual(cache.read("../C", fingerprint, [&restored](const QByteArray& state) {
+                restored = QByteArray(state.constData(), state.size());
+                return true;
+            }), true);
+            Assert::AreEqual(restored == "escaped", true);
+            // 指纹不符的条目删除
+            Assert::AreEqual(cache.read("B", QByteArray(20, 'x'), [](const QByteArray&) { return true; }), false);
+            Assert::AreEqual(QFileInfo::exists(dir + "/B.state"), false);
+            cache.prune({ "B", "../C" });
+            Assert::AreEqual(QFileInfo::exists(dir + "/A.state"), false);
+            Assert::AreEqual(cache.read("../C", fingerprint, [](const QByteArray&) { return true; }), true);
+            cache.prune({ "B" });
+            Assert::AreEqual(QFileInfo::exists(library), true);
+            auto&& stats = cache.stats();
+            Assert::AreEqual(stats.hits, 3);
+            Assert::AreEqual(stats.misses, 1);
+            Assert::AreEqual(stats.stale, 1);
+            Assert::AreEqual(stats.pruned, 2);
+            Assert::AreEqual(stats.written >= 3, true);
+        }
+        QDir(dir).removeRecursively();
+    }
+    TEST_METHOD(Contexts)
+    {
+        QPluginManager::Instance().findLoadPlugins(QDir("..").absolutePath());
+        QPluginManager context("unittest");
+        Assert::AreEqual(context.name() == "unittest", true);
+        // 各上下文插件表互不影响
+        Assert::AreEqual(context.pluginNames().isEmpty(), true);
+        Assert::AreEqual(context.isLoad("QLogPluginTest"), false);
+        Assert::AreEqual(&QPluginManager::Current() == &QPluginManager::Instance(), true);
+        {
+            QPluginManagerScope scope(context);
+            Assert::AreEqual(&QPluginManager::Current() == &context, true);
+        }
+        Assert::AreEqual(&QPluginManager::Current() == &QPluginManager::Instance(), true);
+        auto&& opt = QPluginManager::Instance().load("QLogPluginTest");
+        Assert::AreEqual(opt.has_value(), true);
+        Assert::AreEqual(QPluginManager::contextOf(opt.value()) == &QPluginManager::Instance(), true);
+    }
+    TEST_METHOD(ContextInstances)
+    {
+        QPluginManager::Instance().findLoadPlugins(QDir("..").absolutePath());
+        QPluginManager first("unittest.first");
+        QPluginManager second("unittest.second");
+        first.findLoadPlugins(QDir("..").absolutePath());
+        second.findLoadPlugins(QDir("..").absolutePath());
+        // 根实例属于默认上下文，其余上下文各自经工厂创建实例
+        auto&& shared = QPluginManager::Instance().load("QLogPluginTest");
+        auto&& a = first.load("QLogPluginTest");
+        auto&& b = second.load("QLogPluginTest");
+        Assert::AreEqual(shared.has_value() && a.has_value() && b.has_value(), true);
+        Assert::AreEqual(a.value() != b.value() && a.value() != shared.value() && b.value() != shared.value(), true);
+        Assert::AreEqual(QPluginManager::contextOf(a.value()) == &first, true);
+        Assert::AreEqual(QPluginManager::contextOf(b.value()) == &second, true);
+        Assert::AreEqual(qobject_cast<QLogPluginTest*>(a.value()) != nullptr, true);
+    }
 };
 }
@@ -0,0 +1,123 @@
+﻿#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+#include <QTimer>
+
+#include <cstdio>
+#include <cstring>
+#include <sys/eventfd.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "QPluginManager.h"
+#include "QPluginMetrics.h"
+
+/**
+ * @brief Linux 下 forkWorker 的集成测试：孕育进程加载插件后 fork，工作进程调用插件并运行事件循环，
+ *        插件自己创建的 eventfd 不被替换，孕育进程在 fork 后继续处理事件并重启指标导出
+ *
+ * 用法: QPluginZygoteTest，由 ctest 运行，返回 0 表示通过
+ */
+namespace {
+
+#define CHECK(expr)                                                                 \
+    do {                                                                            \
+        if (!(expr)) {                                                              \
+            fprintf(stderr, "%s:%d: 检查失败: %s\n", __FILE__, __LINE__, #expr); \
+            return 1;                                                               \
+        }                                                                           \
+    } while (0)
+
+/**
+ * @brief 投递一个零延时定时器并处理事件直到其执行，验证本线程的事件分发器仍能被唤醒
+ */
+bool pumpEvents()
+{
+    bool fired = false;
+    QTimer::singleShot(0, [&fired]() { fired = true; });
+    QElapsedTimer elapsed;
+    elapsed.start();
+    while (!fired && elapsed.elapsed() < 2000) {
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 50);
+    }
+    return fired;
+}
+
+/**
+ * @brief 工作进程：结果经退出码交给孕育进程
+ */
+int runWorker(QPluginManager& context, int owned)
+{
+    auto&& report = context.zygoteReport();
+    CHECK(report.isWorker);
+    CHECK(report.parentPid == getppid());
+    auto&& plugin = context.load("QLogPluginTest");
+    CHECK(plugin.has_value());
+    CHECK(strcmp(plugin.value()->metaObject()->className(), "QLogPluginTestImpl") == 0);
+    CHECK(pumpEvents());
+    // 与孕育进程共享同一对象，孕育进程能读到这次写入
+    const eventfd_t value = 1;
+    CHECK(eventfd_write(owned, value) == 0);
+    return 0;
+}
+
+int run()
+{
+    const auto dump = QDir::temp().absoluteFilePath("QPluginZygoteTest.metrics.json");
+    QFile::remove(dump);
+    PluginMetrics::setEnabled(true);
+    PluginMetrics::Instance().startDump(dump, 20);
+    // 模拟插件自己创建的 eventfd
+    const int owned = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    CHECK(owned >= 0);
+
+    QPluginManager context("zygote");
+    // 另一个上下文的后台线程同样在 fork 前停止、之后重启
+    QPluginManager other("zygote.other");
+    context.findLoadPlugins(QDir(QPLUGIN_TEST_PLUGIN_DIR).absolutePath());
+    QString error;
+    CHECK(context.initializes({}, error));
+    CHECK(context.extensionsInitialized());
+
+    const auto pid = context.forkWorker();
+    if (pid == 0) {
+        _exit(runWorker(context, owned));
+    }
+    CHECK(pid > 0);
+    int status = -1;
+    CHECK(waitpid(static_cast<pid_t>(pid), &status, 0) == static_cast<pid_t>(pid));
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    eventfd_t value = 0;
+    CHECK(eventfd_read(owned, &value) == 0 && value == 1);
+    close(owned);
+
+    auto&& report = context.zygoteReport();
+    CHECK(!report.isWorker);
+    CHECK(report.failures == 0);
+    CHECK(report.workers.size() == 1 && report.workers.first().pid == pid);
+    CHECK(pumpEvents());
+    // 导出线程在孕育进程中重启
+    QFile::remove(dump);
+    QElapsedTimer elapsed;
+    elapsed.start();
+    while (!QFileInfo::exists(dump) && elapsed.elapsed() < 2000) {
+        QThread::msleep(10);
+    }
+    CHECK(QFileInfo::exists(dump));
+    PluginMetrics::Instance().stopDump();
+    QFile::remove(dump);
+    return 0;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    const int result = run();
+    fprintf(stderr, result == 0 ? "QPluginZygoteTest 通过\n" : "QPluginZygoteTest 失败\n");
+    return result;
+}
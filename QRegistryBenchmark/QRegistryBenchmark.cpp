@@ -0,0 +1,281 @@
+﻿#include "AutoRegistered.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief RegistryHub / StaticRegistry 基准：请求链路上的 create、entries 刷新、
+ *        version/snapshot 读并发与 ExtractClassName
+ *
+ * 用法: QRegistryBenchmark [--quick] [--out result.json]
+ */
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+    std::string name;
+    std::string params;
+    double nsPerOp = 0;
+    double opsPerSec = 0;
+};
+
+std::vector<Result> g_results;
+bool g_quick = false;
+
+/**
+ * @brief 防止被测调用被优化掉
+ */
+volatile std::size_t g_sink = 0;
+
+void report(const std::string& name, const std::string& params, double nsPerOp, double opsPerSec)
+{
+    g_results.push_back(Result { name, params, nsPerOp, opsPerSec });
+    std::fprintf(stderr, "%-28s %-28s %12.1f ns/op %14.0f ops/s\n", name.c_str(), params.c_str(), nsPerOp, opsPerSec);
+}
+
+template <typename F>
+double nsPerCall(std::size_t iterations, F&& fun)
+{
+    const auto begin = Clock::now();
+    for (std::size_t i = 0; i < iterations; ++i) {
+        fun(i);
+    }
+    const auto ns = std::chrono::duration<double, std::nano>(Clock::now() - begin).count();
+    return ns / static_cast<double>(iterations);
+}
+
+struct BenchBase {
+    virtual ~BenchBase() = default;
+    virtual int value() const = 0;
+};
+
+/**
+ * @brief 每个规模使用独立的 BaseKey，互不影响
+ */
+template <int N>
+struct Scale : BenchBase { };
+
+template <int N>
+struct ScaleImpl : Scale<N> {
+    int value() const override { return N; }
+};
+
+/**
+ * @brief 注册键需在进程内保持有效
+ */
+std::deque<std::string> g_keys;
+
+const char* internKey(const std::string& key)
+{
+    return g_keys.emplace_back(key).c_str();
+}
+
+template <int N>
+void* createImpl()
+{
+    return static_cast<Scale<N>*>(new ScaleImpl<N>());
+}
+
+template <int N>
+void registerTypes(std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        StaticRegistry<Scale<N>>::AddRaw(internKey("Type" + std::to_string(i)), &createImpl<N>);
+    }
+}
+
+template <int N>
+void benchCreate(std::size_t types)
+{
+    registerTypes<N>(types);
+    StaticRegistry<Scale<N>>::entries();
+    const std::size_t iterations = g_quick ? 20000 : 500000;
+    const std::string first = "Type0";
+    const std::string last = "Type" + std::to_string(types - 1);
+    const std::string params = "types=" + std::to_string(types);
+
+    auto ns = nsPerCall(iterations, [&](std::size_t) {
+        auto p = StaticRegistry<Scale<N>>::create(first);
+        if (!p) {
+            std::abort();
+        }
+    });
+    report("create.first", params, ns, 1e9 / ns);
+
+    ns = nsPerCall(iterations, [&](std::size_t) {
+        auto p = StaticRegistry<Scale<N>>::create(last);
+        if (!p) {
+            std::abort();
+        }
+    });
+    report("create.last", params, ns, 1e9 / ns);
+
+    ns = nsPerCall(iterations, [&](std::size_t) {
+        auto p = StaticRegistry<Scale<N>>::create("Missing");
+        if (p) {
+            std::abort();
+        }
+    });
+    report("create.miss", params, ns, 1e9 / ns);
+}
+
+template <int N>
+void benchRebuild(std::size_t types)
+{
+    registerTypes<N>(types);
+    StaticRegistry<Scale<N>>::entries();
+    const std::size_t rounds = g_quick ? 20 : 200;
+    double total = 0;
+    for (std::size_t i = 0; i < rounds; ++i) {
+        // 一次 add 使版本号递增，下一次 entries() 触发刷新
+        StaticRegistry<Scale<N>>::AddRaw(internKey("Extra" + std::to_string(i)), &createImpl<N>);
+        const auto begin = Clock::now();
+        StaticRegistry<Scale<N>>::entries();
+        total += std::chrono::duration<double, std::nano>(Clock::now() - begin).count();
+    }
+    const auto ns = total / static_cast<double>(rounds);
+    report("entries.rebuild", "types=" + std::to_string(types), ns, 1e9 / ns);
+}
+
+template <int N>
+void benchRegister(std::size_t types, bool batched)
+{
+    const auto begin = Clock::now();
+    if (batched) {
+        RegistryBatch batch;
+        registerTypes<N>(types);
+    } else {
+        registerTypes<N>(types);
+    }
+    const auto ns = std::chrono::duration<double, std::nano>(Clock::now() - begin).count();
+    report(batched ? "register.batched" : "register.single", "types=" + std::to_string(types), ns / static_cast<double>(types), 1e9 * static_cast<double>(types) / ns);
+}
+
+void benchReaders(int readers)
+{
+    auto& hub = RegistryHub::Instance();
+    const std::string baseKey = "bench.readers";
+    hub.add(baseKey, "seed", std::any());
+
+    std::atomic_bool stop { false };
+    std::atomic<std::uint64_t> reads { 0 };
+    std::atomic<std::uint64_t> writes { 0 };
+    std::vector<std::thread> threads;
+    for (int r = 0; r < readers; ++r) {
+        threads.emplace_back([&]() {
+            std::uint64_t n = 0;
+            volatile std::size_t sink = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                sink = hub.version(baseKey);
+                sink = hub.snapshot(baseKey)->size();
+                n += 2;
+            }
+            reads.fetch_add(n, std::memory_order_relaxed);
+        });
+    }
+    std::thread writer([&]() {
+        std::uint64_t n = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+            // 写入分散到多个桶，避免单个写时复制向量无限增长
+            hub.add("bench.writer." + std::to_string(n % 64), "w", std::any());
+            ++n;
+            std::this_thread::yield();
+        }
+        writes.store(n, std::memory_order_relaxed);
+    });
+
+    const auto duration = std::chrono::milliseconds(g_quick ? 50 : 500);
+    const auto begin = Clock::now();
+    std::this_thread::sleep_for(duration);
+    stop.store(true);
+    for (auto& t : threads) {
+        t.join();
+    }
+    writer.join();
+    const auto seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+    const auto total = static_cast<double>(reads.load());
+    report("hub.version+snapshot", "readers=" + std::to_string(readers), seconds * 1e9 * readers / total, total / seconds);
+    // 写者可能被读者饿死，至少按一次计
+    const auto written = static_cast<double>(std::max<std::uint64_t>(writes.load(), 1));
+    report("hub.add.concurrent", "readers=" + std::to_string(readers), seconds * 1e9 / written, static_cast<double>(writes.load()) / seconds);
+}
+
+void benchExtractClassName()
+{
+    const std::size_t iterations = g_quick ? 100000 : 10000000;
+    auto ns = nsPerCall(iterations, [&](std::size_t) {
+        g_sink = static_cast<std::size_t>(ExtractClassName<Scale<99>>()[0]);
+    });
+    report("ExtractClassName", "warm", ns, 1e9 / ns);
+
+    // 多线程首次调用（ThreadSanitizer 场景）
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([]() { ExtractClassName<Scale<100>>(); });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
+void writeJson(std::FILE* out)
+{
+    std::fprintf(out, "{\n  \"benchmarks\": [\n");
+    for (std::size_t i = 0; i < g_results.size(); ++i) {
+        const auto& r = g_results[i];
+        std::fprintf(out, "    {\"name\": \"%s\", \"params\": \"%s\", \"ns_per_op\": %.2f, \"ops_per_sec\": %.0f}%s\n",
+            r.name.c_str(), r.params.c_str(), r.nsPerOp, r.opsPerSec, i + 1 < g_results.size() ? "," : "");
+    }
+    std::fprintf(out, "  ]\n}\n");
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    const char* outPath = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--quick") == 0) {
+            g_quick = true;
+        } else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            outPath = argv[++i];
+        }
+    }
+
+    benchCreate<1>(1);
+    benchCreate<16>(16);
+    benchCreate<256>(256);
+    benchCreate<2048>(2048);
+
+    benchRegister<1001>(2048, false);
+    benchRegister<1002>(2048, true);
+
+    benchRebuild<-1>(16);
+    benchRebuild<-256>(256);
+    benchRebuild<-2048>(2048);
+
+    for (int readers : { 1, 2, 4, 8, 16, 32, 64 }) {
+        benchReaders(readers);
+    }
+
+    benchExtractClassName();
+
+    std::FILE* out = outPath ? std::fopen(outPath, "w") : stdout;
+    if (out == nullptr) {
+        std::perror("fopen");
+        return 1;
+    }
+    writeJson(out);
+    if (out != stdout) {
+        std::fclose(out);
+    }
+    return 0;
+}
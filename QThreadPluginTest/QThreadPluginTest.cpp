@@ -0,0 +1,5 @@
+﻿#include "QThreadPluginTest.h"
+
+QThreadPluginTest::~QThreadPluginTest()
+{
+}
@@ -0,0 +1,37 @@
+﻿#pragma once
+
+#include <QtCore/qglobal.h>
+
+#ifndef BUILD_STATIC
+#if defined(QTHREADPLUGINTEST_LIB)
+#define QTHREADPLUGINTEST_EXPORT Q_DECL_EXPORT
+#else
+#define QTHREADPLUGINTEST_EXPORT Q_DECL_IMPORT
+#endif
+#else
+#define QTHREADPLUGINTEST_EXPORT
+#endif
+
+#include "PluginInterface.h"
+
+class QThread;
+
+/**
+ * @brief 线程测试插件：以插件包声明 Main、Dedicated、Pool 与 PerThread 各项，供线程亲和性与按线程实例用例使用
+ */
+class QTHREADPLUGINTEST_EXPORT QThreadPluginTest : public PluginInterface {
+    Q_OBJECT;
+
+public:
+    virtual ~QThreadPluginTest() = 0;
+
+    /**
+     * @brief initialize 执行时所在的线程
+     * @return 尚未初始化时为空
+     */
+    virtual QThread* initializeThread() const = 0;
+};
+
+QT_BEGIN_NAMESPACE
+Q_DECLARE_INTERFACE(QThreadPluginTest, "cn.hiyj.QThreadPluginTest")
+QT_END_NAMESPACE
\ No newline at end of file
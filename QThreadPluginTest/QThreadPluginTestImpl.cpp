@@ -0,0 +1,51 @@
+﻿#include "QThreadPluginTestImpl.h"
+
+#include <QCoreApplication>
+#include <QThread>
+
+#include "QClassRegister.h"
+
+// 包内各项的 Class 均为 QThreadPluginTestImpl
+REGISTER_BUNDLE_PLUGIN(QThreadPluginTestImpl)
+
+QThreadPluginTestImpl::~QThreadPluginTestImpl()
+{
+}
+
+QThread* QThreadPluginTestImpl::initializeThread() const
+{
+    return _initializeThread.load();
+}
+
+bool QThreadPluginTestImpl::initialize(const QStringList& args, QString& error)
+{
+    _initializeThread = QThread::currentThread();
+    return true;
+}
+
+bool QThreadPluginTestImpl::extensionsInitialize()
+{
+    return true;
+}
+
+bool QThreadPluginTestImpl::delayedInitialize()
+{
+    return true;
+}
+
+void QThreadPluginTestImpl::release()
+{
+    auto&& log = GetAppPropertyPtr("QThreadPluginTest.releaseLog", QStringList);
+    if (log == nullptr) {
+        return;
+    }
+    auto&& thread = QThread::currentThread();
+    log->append(thread->objectName() + ".release");
+    if (thread == QCoreApplication::instance()->thread()) {
+        return;
+    }
+    // 线程结束时在该线程上直接记录，用于核对专属线程按序卸载并退出
+    connect(thread, &QThread::finished, thread, [log, name = thread->objectName()]() {
+        log->append(name + ".finished");
+    }, Qt::DirectConnection);
+}
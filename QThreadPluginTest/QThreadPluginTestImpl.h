@@ -0,0 +1,53 @@
+﻿#pragma once
+
+#include <QObject>
+
+#include <atomic>
+
+#include "PluginBundle.h"
+#include "QThreadPluginTest.h"
+
+/**
+ * @brief 插件包根对象，包内各项均由 QThreadPluginTestImpl 实现
+ */
+class QThreadPluginBundle : public PluginBundle {
+    Q_OBJECT;
+    Q_PLUGIN_METADATA(IID "cn.hiyj.QThreadPluginTest" FILE "QThreadPluginTest.json")
+};
+
+class QThreadPluginTestImpl : public QThreadPluginTest {
+    Q_OBJECT;
+    Q_INTERFACES(QThreadPluginTest)
+public:
+    virtual ~QThreadPluginTestImpl();
+
+    QThread* initializeThread() const override;
+
+    /**
+     * @brief 批量初始化，记录执行线程
+     * @param args 程序启动参数
+     * @param error 初始化错误信息
+     * @return 初始化状态
+     */
+    bool initialize(const QStringList& args, QString& error) override;
+
+    /**
+     * @brief 初始化之后扩展初始化
+     * @return 初始化状态
+     */
+    bool extensionsInitialize() override;
+
+    /**
+     * @brief 延迟初始化，执行信号功能
+     * @return 初始化状态
+     */
+    bool delayedInitialize() override;
+
+    /**
+     * @brief 卸载；应用属性 QThreadPluginTest.releaseLog 存在时，记录卸载所在线程及该线程的结束
+     */
+    void release() override;
+
+private:
+    std::atomic<QThread*> _initializeThread { nullptr };
+};